@@ -0,0 +1,65 @@
+// With BOOKYPEDIA_TRACK_ALLOCATIONS, reports heap allocations per benchmark iteration
+// next to the timings, so allocation regressions show up in the benchmark run.
+
+#include "../src/util/allocation_tracker.h"
+
+#ifdef BOOKYPEDIA_TRACK_ALLOCATIONS
+
+#include <catch2/reporters/catch_reporter_event_listener.hpp>
+#include <catch2/reporters/catch_reporter_registrars.hpp>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace std::literals;
+
+class AllocationListener : public Catch::EventListenerBase {
+public:
+    using Catch::EventListenerBase::EventListenerBase;
+
+    void benchmarkStarting(const Catch::BenchmarkInfo& info) override {
+        iterations_ = static_cast<std::uint64_t>(info.iterations) * info.samples;
+        at_start_ = util::GetThreadAllocations();
+    }
+
+    // Besides the measured runs, the numbers include set-up code of BENCHMARK_ADVANCED
+    // bodies and Catch's own analysis of the samples, so compare them between builds
+    // rather than reading them as exact per-call costs
+    void benchmarkEnded(const Catch::BenchmarkStats<>& stats) override {
+        const auto now = util::GetThreadAllocations();
+        const auto iterations = static_cast<double>(std::max<std::uint64_t>(iterations_, 1));
+        results_.push_back({stats.info.name, (now.count - at_start_.count) / iterations,
+                            (now.bytes - at_start_.bytes) / iterations});
+    }
+
+    void testRunEnded(const Catch::TestRunStats&) override {
+        if (results_.empty()) {
+            return;
+        }
+        std::cout << "\nHeap allocations per iteration\n"sv << std::fixed << std::setprecision(1);
+        for (const auto& result : results_) {
+            std::cout << std::left << std::setw(64) << result.name << std::right << std::setw(14)
+                      << result.allocations << " allocs"sv << std::setw(16) << result.bytes << " bytes"sv << std::endl;
+        }
+    }
+
+private:
+    struct Result {
+        std::string name;
+        double allocations;
+        double bytes;
+    };
+
+    std::uint64_t iterations_ = 0;
+    util::AllocationCounters at_start_;
+    std::vector<Result> results_;
+};
+
+}  // namespace
+
+CATCH_REGISTER_LISTENER(AllocationListener)
+
+#endif  // BOOKYPEDIA_TRACK_ALLOCATIONS
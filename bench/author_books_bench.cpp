@@ -0,0 +1,165 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <optional>
+#include <pqxx/pqxx>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../src/postgres/postgres.h"
+#include "../src/storage/storage.h"
+#include "bench_database.h"
+
+using namespace std::literals;
+using pqxx::operator"" _zv;
+
+namespace {
+
+constexpr std::size_t PROLIFIC_AUTHOR_BOOKS = 50'000;
+constexpr std::size_t PAGE_SIZE = 1000;
+
+// An author with PROLIFIC_AUTHOR_BOOKS tagged books next to the seeded catalog of the shared database,
+// removed along with the books when the benchmark ends
+class ProlificAuthor {
+public:
+    ProlificAuthor()
+        : id_{domain::AuthorId::New().ToString()} {
+        pqxx::connection connection{bench::GetDatabase().GetUrl()};
+        pqxx::work work{connection};
+        work.exec_params("INSERT INTO authors (id, name) VALUES ($1, $2)"_zv, id_, "Prolific author "s + id_);
+        {
+            auto stream = pqxx::stream_to::table(work, {"books"}, {"id", "author_id", "title", "publication_year"});
+            for (std::size_t i = 0; i < PROLIFIC_AUTHOR_BOOKS; ++i) {
+                book_ids_.push_back(domain::BookId::New().ToString());
+                // Many books a year, so pages split runs of books of the same year
+                stream.write_values(book_ids_.back(), id_, "Prolific book "s + std::to_string(i),
+                                    1900 + static_cast<int>(i % 125));
+            }
+            stream.complete();
+        }
+        {
+            auto stream = pqxx::stream_to::table(work, {"book_tags"}, {"book_id", "tag"});
+            for (std::size_t i = 0; i < PROLIFIC_AUTHOR_BOOKS; ++i) {
+                for (std::size_t t = 0; t < bench::TAGS_PER_BOOK; ++t) {
+                    stream.write_values(book_ids_[i], "tag "s + std::to_string((i + t * 7) % 50));
+                }
+            }
+            stream.complete();
+        }
+        work.commit();
+
+        pqxx::nontransaction maintenance{connection};
+        maintenance.exec("ANALYZE books, book_tags"_zv);
+    }
+
+    ~ProlificAuthor() {
+        try {
+            pqxx::connection connection{bench::GetDatabase().GetUrl()};
+            pqxx::work work{connection};
+            work.exec_params("DELETE FROM book_tags WHERE book_id IN (SELECT id FROM books WHERE author_id = $1)"_zv, id_);
+            work.exec_params("DELETE FROM books WHERE author_id = $1"_zv, id_);
+            work.exec_params("DELETE FROM authors WHERE id = $1"_zv, id_);
+            work.commit();
+        } catch (const std::exception&) {
+            // The database is dropped at the end of the run anyway
+        }
+    }
+
+    ProlificAuthor(const ProlificAuthor&) = delete;
+    ProlificAuthor& operator=(const ProlificAuthor&) = delete;
+
+    const std::string& GetId() const noexcept {
+        return id_;
+    }
+
+private:
+    std::string id_;
+    std::vector<std::string> book_ids_;
+};
+
+domain::AuthorBooksCursor MakeCursor(const domain::Book& book) {
+    return {book.GetPublicationYear(), book.GetTitle(), book.GetBookId().ToString()};
+}
+
+std::size_t ReadAllPages(domain::BookRepository& books, const std::string& author_id) {
+    std::size_t read = 0;
+    std::optional<domain::AuthorBooksCursor> after;
+    while (true) {
+        const auto page = books.GetAuthorBooksPage(author_id, after, PAGE_SIZE);
+        read += page.size();
+        if (page.size() < PAGE_SIZE) {
+            return read;
+        }
+        after = MakeCursor(page.back());
+    }
+}
+
+void BenchmarkBackend(std::string_view backend, domain::BookRepository& books, const std::string& author_id) {
+    const auto name = [&](std::string_view operation) {
+        return std::string{backend} + "::"s + std::string{operation} + " [50000 books of an author]"s;
+    };
+
+    // The pages have to add up to the whole list, and come with the tags
+    const auto all_books = books.GetAuthorBooks(author_id);
+    REQUIRE(all_books.size() == PROLIFIC_AUTHOR_BOOKS);
+    REQUIRE(all_books.front().GetTags()->size() == bench::TAGS_PER_BOOK);
+    REQUIRE(ReadAllPages(books, author_id) == PROLIFIC_AUTHOR_BOOKS);
+    const auto middle = MakeCursor(all_books[PROLIFIC_AUTHOR_BOOKS / 2]);
+    const auto middle_page = books.GetAuthorBooksPage(author_id, middle, PAGE_SIZE);
+    REQUIRE(middle_page.front().GetBookId() == all_books[PROLIFIC_AUTHOR_BOOKS / 2 + 1].GetBookId());
+
+    BENCHMARK(name("GetAuthorBooks"sv)) {
+        return books.GetAuthorBooks(author_id);
+    };
+
+    BENCHMARK(name("GetAuthorBooksPage first page"sv)) {
+        return books.GetAuthorBooksPage(author_id, std::nullopt, PAGE_SIZE);
+    };
+
+    BENCHMARK(name("GetAuthorBooksPage middle page"sv)) {
+        return books.GetAuthorBooksPage(author_id, middle, PAGE_SIZE);
+    };
+
+    // Tags come with the books, in the same round trip
+    BENCHMARK(name("GetAuthorBooksPage first page with tags"sv)) {
+        auto page = books.GetAuthorBooksPage(author_id, std::nullopt, PAGE_SIZE);
+        std::size_t tags = 0;
+        for (const auto& book : page) {
+            tags += book.GetTags()->size();
+        }
+        return tags;
+    };
+
+    BENCHMARK(name("GetAuthorBooksPage all pages"sv)) {
+        return ReadAllPages(books, author_id);
+    };
+}
+
+}  // namespace
+
+TEST_CASE("Author books", "[author_books]") {
+    bench::PrepareCatalog(bench::GetCatalogSizes().front());
+    const ProlificAuthor author;
+
+    {
+        postgres::Database db{pqxx::connection{bench::GetDatabase().GetUrl()}};
+        BenchmarkBackend("postgres"sv, db.GetBooks(), author.GetId());
+    }
+
+    {
+        const auto log_path = std::filesystem::temp_directory_path()
+                            / ("bookypedia_author_books_"s + std::to_string(::getpid()) + ".log"s);
+        {
+            storage::Database local{{log_path.string(), false}};
+            local.GetAuthors().Save({domain::AuthorId::FromString(author.GetId()), "Prolific author"s});
+            pqxx::connection connection{bench::GetDatabase().GetUrl()};
+            postgres::PrepareStatements(connection);
+            for (auto& book : postgres::BookRepositoryImpl{connection}.GetAuthorBooks(author.GetId())) {
+                local.GetBooks().Save(book);
+            }
+            BenchmarkBackend("storage"sv, local.GetBooks(), author.GetId());
+        }
+        std::filesystem::remove(log_path);
+    }
+}
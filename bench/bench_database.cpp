@@ -0,0 +1,226 @@
+#include "bench_database.h"
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <pqxx/pqxx>
+#include <set>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "../src/postgres/postgres.h"
+#include "../src/storage/storage.h"
+
+namespace bench {
+
+using namespace std::literals;
+using pqxx::operator"" _zv;
+
+namespace {
+
+constexpr std::size_t TAG_POOL_SIZE = 50;
+
+// Replaces the database name in a postgres:// URL
+std::string WithDatabaseName(const std::string& url, const std::string& db_name) {
+    const auto params_pos = url.find('?');
+    const auto path_pos = url.rfind('/', params_pos);
+    if (path_pos == std::string::npos || path_pos < "postgres://"sv.size()) {
+        throw std::invalid_argument(ADMIN_DB_URL_ENV_NAME + " must be a postgres:// URL with a database name"s);
+    }
+    auto result = url.substr(0, path_pos + 1) + db_name;
+    if (params_pos != std::string::npos) {
+        result += url.substr(params_pos);
+    }
+    return result;
+}
+
+// Removes the file when the benchmark run ends
+class TemporaryFile {
+public:
+    explicit TemporaryFile(std::filesystem::path path)
+        : path_{std::move(path)} {
+    }
+
+    ~TemporaryFile() {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+
+    const std::string& GetPath() const noexcept {
+        return path_string_;
+    }
+
+private:
+    std::filesystem::path path_;
+    std::string path_string_ = path_.string();
+};
+
+std::string MakeSampleIndex(std::size_t i, std::size_t width) {
+    auto text = std::to_string(i);
+    if (text.size() < width) {
+        text.insert(0, width - text.size(), '0');
+    }
+    return text;
+}
+
+}  // namespace
+
+DisposableDatabase::DisposableDatabase(std::string admin_url)
+    : admin_url_{std::move(admin_url)}
+    , name_{"bookypedia_bench_"s + std::to_string(::getpid())}
+    , url_{WithDatabaseName(admin_url_, name_)} {
+    pqxx::connection admin{admin_url_};
+    pqxx::nontransaction work{admin};
+    work.exec("DROP DATABASE IF EXISTS " + work.quote_name(name_));
+    work.exec("CREATE DATABASE " + work.quote_name(name_));
+}
+
+DisposableDatabase::~DisposableDatabase() {
+    try {
+        pqxx::connection admin{admin_url_};
+        pqxx::nontransaction work{admin};
+        work.exec("DROP DATABASE IF EXISTS " + work.quote_name(name_) + " WITH (FORCE)");
+    } catch (...) {
+    }
+}
+
+std::vector<std::size_t> GetCatalogSizes() {
+    const auto* env = std::getenv(CATALOG_SIZES_ENV_NAME);
+    if (!env) {
+        return {10'000, 100'000, 1'000'000};
+    }
+
+    std::vector<std::string> items;
+    boost::split(items, std::string{env}, boost::is_any_of(","));
+    std::vector<std::size_t> sizes;
+    for (const auto& item : items) {
+        if (!item.empty()) {
+            sizes.push_back(std::stoul(item));
+        }
+    }
+    return sizes;
+}
+
+DisposableDatabase& GetDatabase() {
+    static const auto database = [] {
+        const auto* url = std::getenv(ADMIN_DB_URL_ENV_NAME);
+        if (!url) {
+            throw std::runtime_error(ADMIN_DB_URL_ENV_NAME + " environment variable not found"s);
+        }
+        return std::make_unique<DisposableDatabase>(url);
+    }();
+    return *database;
+}
+
+const CatalogSample& PrepareCatalog(std::size_t books) {
+    static CatalogSample sample;
+    if (sample.books == books) {
+        return sample;
+    }
+
+    // Creates the schema exactly the way the application does
+    postgres::Database db{pqxx::connection{GetDatabase().GetUrl()}};
+
+    pqxx::connection connection{GetDatabase().GetUrl()};
+    pqxx::work work{connection};
+    work.exec("TRUNCATE authors, books, book_tags"_zv);
+
+    sample = CatalogSample{};
+    sample.books = books;
+    const auto authors = std::max<std::size_t>(1, books / BOOKS_PER_AUTHOR);
+    const auto sample_step = std::max<std::size_t>(1, books / SAMPLE_SIZE);
+
+    std::vector<std::string> author_ids;
+    author_ids.reserve(authors);
+    {
+        auto stream = pqxx::stream_to::table(work, {"authors"}, {"id", "name"});
+        for (std::size_t i = 0; i < authors; ++i) {
+            auto id = domain::AuthorId::New().ToString();
+            auto name = "Author "s + MakeSampleIndex(i, 8);
+            stream.write_values(id, name);
+            if (i % BOOKS_PER_AUTHOR == 0 && sample.author_ids.size() < SAMPLE_SIZE) {
+                sample.author_ids.push_back(id);
+                sample.author_names.push_back(name);
+            }
+            author_ids.push_back(std::move(id));
+        }
+        stream.complete();
+    }
+
+    std::vector<std::string> book_ids;
+    book_ids.reserve(books);
+    {
+        auto stream = pqxx::stream_to::table(work, {"books"}, {"id", "author_id", "title", "publication_year"});
+        for (std::size_t i = 0; i < books; ++i) {
+            auto id = domain::BookId::New().ToString();
+            // Every title is shared by two books, so lookups by title have to disambiguate
+            auto title = "Book "s + MakeSampleIndex(i / 2, 8);
+            stream.write_values(id, author_ids[i % authors], title, 1900 + static_cast<int>(i % 125));
+            if (i % sample_step == 0 && sample.book_ids.size() < SAMPLE_SIZE) {
+                sample.book_ids.push_back(id);
+                sample.book_titles.push_back(std::move(title));
+            }
+            book_ids.push_back(std::move(id));
+        }
+        stream.complete();
+    }
+
+    // Only one COPY can be in progress on a connection, so tags go after the books
+    {
+        auto stream = pqxx::stream_to::table(work, {"book_tags"}, {"book_id", "tag"});
+        for (std::size_t i = 0; i < books; ++i) {
+            for (std::size_t t = 0; t < TAGS_PER_BOOK; ++t) {
+                stream.write_values(book_ids[i], "tag "s + std::to_string((i + t * 7) % TAG_POOL_SIZE));
+            }
+        }
+        stream.complete();
+    }
+    work.commit();
+
+    pqxx::nontransaction maintenance{connection};
+    maintenance.exec("VACUUM ANALYZE"_zv);
+    return sample;
+}
+
+const std::string& PrepareLocalCatalog(std::size_t books) {
+    static const TemporaryFile log_file{std::filesystem::temp_directory_path()
+                                        / ("bookypedia_bench_"s + std::to_string(::getpid()) + ".log"s)};
+    static std::size_t local_books = 0;
+    if (local_books == books) {
+        return log_file.GetPath();
+    }
+
+    PrepareCatalog(books);
+    std::filesystem::remove(log_file.GetPath());
+
+    // Syncing every seeded row would take ages; the benchmarks reopen the log with sync on
+    storage::Database local{{log_file.GetPath(), false}};
+    pqxx::connection connection{GetDatabase().GetUrl()};
+    pqxx::read_transaction read{connection};
+
+    for (auto [id, name] : read.query<std::string, std::string>("SELECT id, name FROM authors"sv)) {
+        local.GetAuthors().Save({domain::AuthorId::FromString(id), name});
+    }
+    const auto book_query = R"(
+SELECT books.id, books.author_id, books.title, books.publication_year, string_agg(book_tags.tag, ',')
+FROM books LEFT JOIN book_tags ON book_tags.book_id = books.id
+GROUP BY books.id
+)"sv;
+    for (auto [id, author_id, title, year, tags] :
+         read.query<std::string, std::string, std::string, int, std::optional<std::string>>(book_query)) {
+        std::set<std::string> tag_set;
+        if (tags) {
+            boost::split(tag_set, *tags, boost::is_any_of(","));
+        }
+        local.GetBooks().Save(
+            {domain::BookId::FromString(id), domain::AuthorId::FromString(author_id), title, year, std::move(tag_set)});
+    }
+
+    local_books = books;
+    return log_file.GetPath();
+}
+
+}  // namespace bench
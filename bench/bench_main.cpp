@@ -0,0 +1,27 @@
+#include <catch2/catch_session.hpp>
+#include <string_view>
+#include <vector>
+
+// Unless told otherwise, results are printed to the console and also written to
+// bookypedia_bench.xml, so they can be compared between releases
+int main(int argc, char* argv[]) {
+    using namespace std::literals;
+
+    std::vector<const char*> args{argv, argv + argc};
+    bool has_reporter = false;
+    bool has_samples = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+        has_reporter = has_reporter || arg == "-r"sv || arg.substr(0, "--reporter"sv.size()) == "--reporter"sv;
+        has_samples = has_samples || arg.substr(0, "--benchmark-samples"sv.size()) == "--benchmark-samples"sv;
+    }
+    if (!has_reporter) {
+        args.insert(args.end(), {"--reporter", "console", "--reporter", "xml::out=bookypedia_bench.xml"});
+    }
+    // Catalog-wide reads take seconds on the largest catalogs, so the default of 100 samples is too slow
+    if (!has_samples) {
+        args.insert(args.end(), {"--benchmark-samples", "10"});
+    }
+
+    return Catch::Session().run(static_cast<int>(args.size()), args.data());
+}
@@ -0,0 +1,154 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <pqxx/pqxx>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../src/postgres/postgres.h"
+#include "bench_database.h"
+
+using namespace std::literals;
+using pqxx::operator"" _zv;
+
+namespace {
+
+constexpr std::size_t EDITED_BOOK_TAGS = 50;
+// Edits of each pattern the WAL volume is averaged over
+constexpr int WAL_EDITS = 200;
+
+std::set<std::string> MakeTags(std::string_view prefix) {
+    std::set<std::string> tags;
+    for (std::size_t i = 0; i < EDITED_BOOK_TAGS; ++i) {
+        tags.insert(std::string{prefix} + std::to_string(i));
+    }
+    return tags;
+}
+
+// A book with EDITED_BOOK_TAGS tags by an author of the seeded catalog, removed when the benchmark ends
+class EditedBook {
+public:
+    EditedBook(domain::BookRepository& books, const std::string& author_id)
+        : id_{domain::BookId::New()} {
+        books.Save({id_, domain::AuthorId::FromString(author_id), "Edited book"s, 2000, MakeTags("tag "sv)});
+    }
+
+    ~EditedBook() {
+        try {
+            pqxx::connection connection{bench::GetDatabase().GetUrl()};
+            pqxx::work work{connection};
+            work.exec_params("DELETE FROM book_tags WHERE book_id = $1"_zv, GetId());
+            work.exec_params("DELETE FROM books WHERE id = $1"_zv, GetId());
+            work.commit();
+        } catch (const std::exception&) {
+            // The database is dropped at the end of the run anyway
+        }
+    }
+
+    EditedBook(const EditedBook&) = delete;
+    EditedBook& operator=(const EditedBook&) = delete;
+
+    std::string GetId() const {
+        return id_.ToString();
+    }
+
+private:
+    domain::BookId id_;
+};
+
+// An edit as the user makes it: the title, year and the whole set of tags the book ends up with.
+// Consecutive edits alternate between two versions, so that each one changes what the pattern changes.
+struct EditPattern {
+    std::string_view name;
+    std::function<void(int edit, std::string& title, int& year, std::set<std::string>& tags)> make;
+};
+
+const std::vector<EditPattern>& GetEditPatterns() {
+    static const std::vector<EditPattern> patterns{
+        {"nothing changed"sv, [](int, std::string&, int&, std::set<std::string>&) {}},
+        {"title changed"sv, [](int edit, std::string& title, int&, std::set<std::string>&) {
+             title = edit % 2 ? "Edited book, revised"s : "Edited book"s;
+         }},
+        {"one of 50 tags replaced"sv, [](int edit, std::string&, int&, std::set<std::string>& tags) {
+             tags.erase("tag 0"s);
+             tags.insert(edit % 2 ? "tag 0, revised"s : "tag 0"s);
+         }},
+        {"all 50 tags replaced"sv, [](int edit, std::string&, int&, std::set<std::string>& tags) {
+             tags = MakeTags(edit % 2 ? "other tag "sv : "tag "sv);
+         }},
+    };
+    return patterns;
+}
+
+void Edit(domain::BookRepository& books, std::string book_id, const EditPattern& pattern, int edit) {
+    auto title = "Edited book"s;
+    int year = 2000;
+    auto tags = MakeTags("tag "sv);
+    pattern.make(edit, title, year, tags);
+    books.EditBook(title, year, std::move(tags), book_id);
+}
+
+// WAL written per call of fn, on average over WAL_EDITS calls; the server must be otherwise idle
+double MeasureWalBytes(pqxx::connection& connection, const std::function<void(int)>& fn) {
+    const auto read_lsn = [&connection] {
+        pqxx::nontransaction tx{connection};
+        return tx.exec("SELECT pg_current_wal_insert_lsn()::text"_zv).one_row()[0].as<std::string>();
+    };
+    const auto start = read_lsn();
+    for (int i = 0; i < WAL_EDITS; ++i) {
+        fn(i);
+    }
+    pqxx::nontransaction tx{connection};
+    const auto bytes = tx.exec_params("SELECT pg_wal_lsn_diff(pg_current_wal_insert_lsn(), $1::pg_lsn)"_zv, start)
+                           .one_row()[0].as<double>();
+    return bytes / WAL_EDITS;
+}
+
+// What EditBook did before it took the diff: every tag deleted and inserted again
+void ReplaceAllTags(pqxx::connection& connection, const std::string& book_id, const std::set<std::string>& tags) {
+    pqxx::work work{connection};
+    work.exec_params("UPDATE books SET title = $2, publication_year = $3 WHERE id = $1"_zv, book_id, "Edited book"s, 2000);
+    work.exec_params("DELETE FROM book_tags WHERE book_id = $1"_zv, book_id);
+    work.exec_params("INSERT INTO book_tags (book_id, tag) SELECT $1, unnest($2::varchar[])"_zv, book_id,
+                     std::vector<std::string>{tags.begin(), tags.end()});
+    work.commit();
+}
+
+}  // namespace
+
+TEST_CASE("EditBook", "[edit_book]") {
+    const auto& sample = bench::PrepareCatalog(bench::GetCatalogSizes().front());
+    pqxx::connection connection{bench::GetDatabase().GetUrl()};
+    postgres::Database db{pqxx::connection{bench::GetDatabase().GetUrl()}};
+    auto& books = db.GetBooks();
+    const EditedBook book{books, sample.author_ids.front()};
+
+    // The edit has to leave the book with exactly the tags asked for
+    Edit(books, book.GetId(), GetEditPatterns().back(), 1);
+    const auto edited = std::tuple{"Edited book"s, sample.author_names.front(), 2000, book.GetId(), MakeTags("other tag "sv)};
+    REQUIRE(books.ShowBooksDetails({book.GetId()}).front() == edited);
+    Edit(books, book.GetId(), GetEditPatterns().front(), 0);
+
+    std::cout << "\nWAL bytes per edit of a book with " << EDITED_BOOK_TAGS << " tags\n" << std::fixed << std::setprecision(0);
+    const auto print_wal = [](std::string_view name, double bytes) {
+        std::cout << std::left << std::setw(48) << name << std::right << std::setw(12) << bytes << " bytes" << std::endl;
+    };
+    print_wal("delete and reinsert all tags (before)"sv, MeasureWalBytes(connection, [&](int) {
+        ReplaceAllTags(connection, book.GetId(), MakeTags("tag "sv));
+    }));
+    for (const auto& pattern : GetEditPatterns()) {
+        print_wal(pattern.name, MeasureWalBytes(connection, [&](int edit) {
+            Edit(books, book.GetId(), pattern, edit);
+        }));
+    }
+
+    for (const auto& pattern : GetEditPatterns()) {
+        int edit = 0;
+        BENCHMARK("postgres::EditBook " + std::string{pattern.name}) {
+            return Edit(books, book.GetId(), pattern, ++edit);
+        };
+    }
+}
@@ -0,0 +1,189 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/generators/catch_generators_range.hpp>
+#include <pqxx/pqxx>
+
+#include "../src/postgres/postgres.h"
+#include "bench_database.h"
+
+using namespace std::literals;
+
+namespace {
+
+std::string MakeUniqueName(std::string_view prefix) {
+    static std::size_t counter = 0;
+    return std::string{prefix} + std::to_string(++counter);
+}
+
+std::string SizeSuffix(std::size_t books) {
+    return " ["s + std::to_string(books) + " books]"s;
+}
+
+// Authors created for one benchmark sample outside of the measured code
+std::vector<domain::Author> AddTemporaryAuthors(postgres::AuthorRepositoryImpl& authors, int count) {
+    std::vector<domain::Author> added;
+    for (int i = 0; i < count; ++i) {
+        added.emplace_back(domain::AuthorId::New(), MakeUniqueName("Temporary author "sv));
+        authors.Save(added.back());
+    }
+    return added;
+}
+
+std::vector<std::string> AddTemporaryBooks(postgres::BookRepositoryImpl& books, const bench::CatalogSample& sample,
+                                           int count) {
+    std::vector<std::string> ids;
+    for (int i = 0; i < count; ++i) {
+        const domain::Book book{domain::BookId::New(),
+                                domain::AuthorId::FromString(sample.author_ids[i % sample.author_ids.size()]),
+                                MakeUniqueName("Temporary book "sv), 2000,
+                                std::set<std::string>{"tag 1"s, "tag 2"s, "temporary"s}};
+        books.Save(book);
+        ids.push_back(book.GetBookId().ToString());
+    }
+    return ids;
+}
+
+void DeleteBooks(postgres::BookRepositoryImpl& books, std::vector<std::string>& ids) {
+    for (auto& id : ids) {
+        books.DeleteBook(id);
+    }
+}
+
+}  // namespace
+
+TEST_CASE("AuthorRepositoryImpl", "[authors]") {
+    const auto catalog_size = GENERATE(from_range(bench::GetCatalogSizes()));
+    bench::PrepareCatalog(catalog_size);
+    const auto suffix = SizeSuffix(catalog_size);
+
+    postgres::Database db{pqxx::connection{bench::GetDatabase().GetUrl()}};
+    auto& authors = db.GetAuthors();
+    auto& books = db.GetBooks();
+
+    BENCHMARK("AuthorRepositoryImpl::GetAuthors" + suffix) {
+        return authors.GetAuthors();
+    };
+
+    BENCHMARK_ADVANCED("AuthorRepositoryImpl::Save" + suffix)(Catch::Benchmark::Chronometer meter) {
+        std::vector<domain::Author> new_authors;
+        for (int i = 0; i < meter.runs(); ++i) {
+            new_authors.emplace_back(domain::AuthorId::New(), MakeUniqueName("Saved author "sv));
+        }
+        meter.measure([&](int i) {
+            authors.Save(new_authors[i]);
+        });
+        for (const auto& author : new_authors) {
+            auto name = author.GetName();
+            authors.Delete(name);
+        }
+    };
+
+    BENCHMARK_ADVANCED("AuthorRepositoryImpl::Edit" + suffix)(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::string> old_names;
+        std::vector<std::string> new_names;
+        for (const auto& author : AddTemporaryAuthors(authors, meter.runs())) {
+            old_names.push_back(author.GetName());
+            new_names.push_back(MakeUniqueName("Renamed author "sv));
+        }
+        meter.measure([&](int i) {
+            authors.Edit(new_names[i], old_names[i]);
+        });
+        for (auto& name : new_names) {
+            authors.Delete(name);
+        }
+    };
+
+    BENCHMARK_ADVANCED("AuthorRepositoryImpl::Delete" + suffix)(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::string> names;
+        // Every deleted author has a book with tags, so the cascade is measured too
+        for (const auto& author : AddTemporaryAuthors(authors, meter.runs())) {
+            names.push_back(author.GetName());
+            books.Save({domain::BookId::New(), author.GetId(), MakeUniqueName("Orphan book "sv), 2000,
+                        std::set<std::string>{"temporary"s}});
+        }
+        meter.measure([&](int i) {
+            authors.Delete(names[i]);
+        });
+    };
+}
+
+TEST_CASE("BookRepositoryImpl", "[books]") {
+    const auto catalog_size = GENERATE(from_range(bench::GetCatalogSizes()));
+    const auto& sample = bench::PrepareCatalog(catalog_size);
+    const auto suffix = SizeSuffix(catalog_size);
+
+    postgres::Database db{pqxx::connection{bench::GetDatabase().GetUrl()}};
+    auto& books = db.GetBooks();
+
+    BENCHMARK("BookRepositoryImpl::ShowBooks" + suffix) {
+        return books.ShowBooks();
+    };
+
+    BENCHMARK_ADVANCED("BookRepositoryImpl::ShowBook" + suffix)(Catch::Benchmark::Chronometer meter) {
+        auto titles = sample.book_titles;
+        meter.measure([&](int i) {
+            return books.ShowBook(titles[i % titles.size()]);
+        });
+    };
+
+    BENCHMARK_ADVANCED("BookRepositoryImpl::GetAuthorBooks" + suffix)(Catch::Benchmark::Chronometer meter) {
+        meter.measure([&](int i) {
+            return books.GetAuthorBooks(sample.author_ids[i % sample.author_ids.size()]);
+        });
+    };
+
+    BENCHMARK_ADVANCED("BookRepositoryImpl::Save without tags" + suffix)(Catch::Benchmark::Chronometer meter) {
+        std::vector<domain::Book> new_books;
+        for (int i = 0; i < meter.runs(); ++i) {
+            new_books.emplace_back(domain::BookId::New(),
+                                   domain::AuthorId::FromString(sample.author_ids[i % sample.author_ids.size()]),
+                                   MakeUniqueName("Saved book "sv), 2000, std::nullopt);
+        }
+        meter.measure([&](int i) {
+            books.Save(new_books[i]);
+        });
+        std::vector<std::string> ids;
+        for (const auto& book : new_books) {
+            ids.push_back(book.GetBookId().ToString());
+        }
+        DeleteBooks(books, ids);
+    };
+
+    BENCHMARK_ADVANCED("BookRepositoryImpl::Save with tags" + suffix)(Catch::Benchmark::Chronometer meter) {
+        std::vector<domain::Book> new_books;
+        for (int i = 0; i < meter.runs(); ++i) {
+            new_books.emplace_back(domain::BookId::New(),
+                                   domain::AuthorId::FromString(sample.author_ids[i % sample.author_ids.size()]),
+                                   MakeUniqueName("Saved book "sv), 2000,
+                                   std::set<std::string>{"tag 1"s, "tag 2"s, "tag 3"s});
+        }
+        meter.measure([&](int i) {
+            books.Save(new_books[i]);
+        });
+        std::vector<std::string> ids;
+        for (const auto& book : new_books) {
+            ids.push_back(book.GetBookId().ToString());
+        }
+        DeleteBooks(books, ids);
+    };
+
+    BENCHMARK_ADVANCED("BookRepositoryImpl::EditBook" + suffix)(Catch::Benchmark::Chronometer meter) {
+        auto ids = AddTemporaryBooks(books, sample, meter.runs());
+        std::vector<std::string> titles;
+        for (int i = 0; i < meter.runs(); ++i) {
+            titles.push_back(MakeUniqueName("Edited book "sv));
+        }
+        meter.measure([&](int i) {
+            books.EditBook(titles[i], 2001, {"tag 1"s, "tag 3"s, "temporary"s}, ids[i]);
+        });
+        DeleteBooks(books, ids);
+    };
+
+    BENCHMARK_ADVANCED("BookRepositoryImpl::DeleteBook" + suffix)(Catch::Benchmark::Chronometer meter) {
+        auto ids = AddTemporaryBooks(books, sample, meter.runs());
+        meter.measure([&](int i) {
+            books.DeleteBook(ids[i]);
+        });
+    };
+}
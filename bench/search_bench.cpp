@@ -0,0 +1,72 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../src/search/columnar_catalog.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Optional number of rows of the synthetic columnar catalog, 10000000 by default
+constexpr const char SEARCH_ROWS_ENV_NAME[]{"BOOKYPEDIA_BENCH_SEARCH_ROWS"};
+
+std::size_t GetSearchRows() {
+    const auto* env = std::getenv(SEARCH_ROWS_ENV_NAME);
+    return env ? std::stoul(env) : 10'000'000;
+}
+
+// Built in memory rather than loaded from Postgres: the scan is what is measured,
+// and seeding ten million books would take longer than all the benchmarks together
+const search::ColumnarCatalog& GetCatalog() {
+    static const auto catalog = [] {
+        constexpr std::string_view words[]{"War"sv,   "Peace"sv, "Night"sv, "Garden"sv,
+                                           "River"sv, "Stone"sv, "Glass"sv, "Winter"sv};
+        constexpr std::size_t AUTHORS = 1'000'000;
+        const auto rows = GetSearchRows();
+
+        std::vector<search::ColumnarCatalog::BookRow> books;
+        books.reserve(rows);
+        for (std::size_t i = 0; i < rows; ++i) {
+            books.emplace_back("Book "s + std::string{words[i % 8]} + " "s + std::string{words[i / 8 % 8]} + " "s
+                                   + std::to_string(i),
+                               "Author "s + std::to_string(i % AUTHORS), static_cast<int>(1900 + i % 125),
+                               "00000000-0000-0000-0000-"s + std::to_string(100'000'000'000 + i));
+        }
+        return search::ColumnarCatalog{books};
+    }();
+    return catalog;
+}
+
+}  // namespace
+
+TEST_CASE("ColumnarCatalog", "[search]") {
+    const auto& catalog = GetCatalog();
+    const auto suffix = " ["s + std::to_string(catalog.GetSize()) + " books]"s;
+    const search::Query title_query{"garden river 12"s, {}, {}, {}};
+    const search::Query combined_query{"night"s, "AUTHOR 4242"s, 1950, 1960};
+    const search::Query years_query{{}, {}, 1950, 1951};
+
+    for (auto level = search::ScanLevel::Scalar; level <= search::GetSupportedScanLevel();
+         level = static_cast<search::ScanLevel>(static_cast<int>(level) + 1)) {
+        const auto level_name = std::string{search::GetScanLevelName(level)};
+        for (const std::size_t threads : {std::size_t{1}, std::size_t{0}}) {
+            const search::ScanOptions options{threads, level};
+            const auto name = " ("s + level_name + ", "s + (threads == 1 ? "1 thread"s : "all cores"s) + ")"s + suffix;
+
+            BENCHMARK("ColumnarCatalog::Find title contains"s + name) {
+                return catalog.Find(title_query, options);
+            };
+
+            BENCHMARK("ColumnarCatalog::Find title and author contains, year range"s + name) {
+                return catalog.Find(combined_query, options);
+            };
+        }
+    }
+
+    BENCHMARK("ColumnarCatalog::Find year range (all cores)"s + suffix) {
+        return catalog.Find(years_query);
+    };
+}
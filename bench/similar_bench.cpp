@@ -0,0 +1,67 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../src/search/similar_books.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Optional number of books of the synthetic similarity index, 1000000 by default
+constexpr const char SIMILAR_BOOKS_ENV_NAME[]{"BOOKYPEDIA_BENCH_SIMILAR_BOOKS"};
+constexpr std::size_t TAGS = 300;
+
+std::size_t GetSimilarBooks() {
+    const auto* env = std::getenv(SIMILAR_BOOKS_ENV_NAME);
+    return env ? std::stoul(env) : 1'000'000;
+}
+
+// Book i has 1 to 6 tags; low tag numbers are far more common than high ones,
+// as with real tags, so queries on popular tags touch a large share of the catalog
+const search::SimilarityIndex& GetIndex() {
+    static const auto index = [] {
+        const auto size = GetSimilarBooks();
+        std::vector<search::SimilarityIndex::Book> books;
+        books.reserve(size);
+        std::uint64_t state = 42;
+        const auto next = [&state] {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return state >> 33;
+        };
+        for (std::size_t i = 0; i < size; ++i) {
+            search::SimilarityIndex::Book book{"Book "s + std::to_string(i), "Author "s + std::to_string(i % 100'000),
+                                               static_cast<int>(1900 + i % 125),
+                                               "00000000-0000-0000-0000-"s + std::to_string(100'000'000'000 + i), {}};
+            for (auto tags = 1 + next() % 6; tags > 0; --tags) {
+                book.tags.insert("tag "s + std::to_string(std::min(next() % TAGS, next() % TAGS)));
+            }
+            books.push_back(std::move(book));
+        }
+        return search::SimilarityIndex{std::move(books)};
+    }();
+    return index;
+}
+
+}  // namespace
+
+TEST_CASE("SimilarityIndex", "[search]") {
+    const auto& index = GetIndex();
+    const auto suffix = " ["s + std::to_string(index.GetSize()) + " books]"s;
+    const auto book_id = "00000000-0000-0000-0000-"s + std::to_string(100'000'000'000 + 5);
+
+    REQUIRE(index.FindSimilar(book_id, 10, search::ScanLevel::Scalar).size() == 10);
+    for (auto level = search::ScanLevel::Scalar; level <= search::GetSupportedScanLevel();
+         level = static_cast<search::ScanLevel>(static_cast<int>(level) + 1)) {
+        const auto name = " ("s + std::string{search::GetScanLevelName(level)} + ")"s + suffix;
+        BENCHMARK("SimilarityIndex::FindSimilar top 10"s + name) {
+            return index.FindSimilar(book_id, 10, level);
+        };
+
+        BENCHMARK("SimilarityIndex::FindSimilar top 100"s + name) {
+            return index.FindSimilar(book_id, 100, level);
+        };
+    }
+}
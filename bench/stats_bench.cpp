@@ -0,0 +1,42 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/generators/catch_generators_range.hpp>
+#include <pqxx/pqxx>
+
+#include "../src/postgres/postgres.h"
+#include "../src/storage/storage.h"
+#include "bench_database.h"
+
+using namespace std::literals;
+
+TEST_CASE("CatalogStats", "[stats]") {
+    const auto catalog_size = GENERATE(from_range(bench::GetCatalogSizes()));
+    bench::PrepareCatalog(catalog_size);
+    const auto suffix = " ["s + std::to_string(catalog_size) + " books]"s;
+
+    postgres::Database db{pqxx::connection{bench::GetDatabase().GetUrl()}};
+    auto& books = db.GetBooks();
+    // The summary is only worth measuring if it is right
+    REQUIRE(books.GetCatalogStats(domain::StatsSource::Summary)
+            == books.GetCatalogStats(domain::StatsSource::FullRecompute));
+
+    BENCHMARK("postgres::GetCatalogStats summary" + suffix) {
+        return books.GetCatalogStats(domain::StatsSource::Summary);
+    };
+
+    BENCHMARK("postgres::GetCatalogStats full recompute" + suffix) {
+        return books.GetCatalogStats(domain::StatsSource::FullRecompute);
+    };
+
+    storage::Database local{{bench::PrepareLocalCatalog(catalog_size)}};
+    auto& local_books = local.GetBooks();
+
+    BENCHMARK("storage::GetCatalogStats summary" + suffix) {
+        return local_books.GetCatalogStats(domain::StatsSource::Summary);
+    };
+
+    BENCHMARK("storage::GetCatalogStats full recompute" + suffix) {
+        return local_books.GetCatalogStats(domain::StatsSource::FullRecompute);
+    };
+}
@@ -0,0 +1,152 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/generators/catch_generators_range.hpp>
+#include <atomic>
+#include <memory>
+#include <pqxx/pqxx>
+#include <thread>
+
+#include "../src/postgres/postgres.h"
+#include "../src/storage/storage.h"
+#include "bench_database.h"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr int WRITER_THREADS = 8;
+
+std::string MakeUniqueName(std::string_view prefix) {
+    static std::atomic<std::size_t> counter = 0;
+    return std::string{prefix} + std::to_string(++counter);
+}
+
+domain::Book MakeBook(const bench::CatalogSample& sample, std::size_t i) {
+    return {domain::BookId::New(), domain::AuthorId::FromString(sample.author_ids[i % sample.author_ids.size()]),
+            MakeUniqueName("Stored book "sv), 2000, std::set<std::string>{"tag 1"s, "tag 2"s, "stored"s}};
+}
+
+void DeleteBooks(domain::BookRepository& books, const std::vector<domain::Book>& saved) {
+    for (const auto& book : saved) {
+        auto id = book.GetBookId().ToString();
+        books.DeleteBook(id);
+    }
+}
+
+// The same reads and writes against any backend. `writers` holds a repository per writer thread,
+// the Postgres ones can't share a connection while the storage ones share the catalog.
+void BenchmarkBackend(std::string_view backend, domain::AuthorRepository& authors, domain::BookRepository& books,
+                      const std::vector<domain::BookRepository*>& writers, const bench::CatalogSample& sample,
+                      const std::string& suffix) {
+    const auto name = [&](std::string_view operation) {
+        return std::string{backend} + "::"s + std::string{operation} + suffix;
+    };
+
+    BENCHMARK(name("GetAuthors"sv)) {
+        return authors.GetAuthors();
+    };
+
+    BENCHMARK(name("ShowBooks"sv)) {
+        return books.ShowBooks();
+    };
+
+    BENCHMARK_ADVANCED(name("ShowBook"sv))(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::string> titles;
+        for (int i = 0; i < meter.runs(); ++i) {
+            titles.push_back(sample.book_titles[i % sample.book_titles.size()]);
+        }
+        meter.measure([&](int i) {
+            return books.ShowBook(titles[i]);
+        });
+    };
+
+    BENCHMARK_ADVANCED(name("Save"sv))(Catch::Benchmark::Chronometer meter) {
+        std::vector<domain::Book> new_books;
+        for (int i = 0; i < meter.runs(); ++i) {
+            new_books.push_back(MakeBook(sample, i));
+        }
+        meter.measure([&](int i) {
+            books.Save(new_books[i]);
+        });
+        DeleteBooks(books, new_books);
+    };
+
+    // Every run saves a book from each writer thread at once, which is where group commit pays off
+    BENCHMARK_ADVANCED(name("Save, "s + std::to_string(writers.size()) + " threads"s))(
+        Catch::Benchmark::Chronometer meter) {
+        std::vector<std::vector<domain::Book>> new_books(writers.size());
+        for (std::size_t w = 0; w < writers.size(); ++w) {
+            for (int i = 0; i < meter.runs(); ++i) {
+                new_books[w].push_back(MakeBook(sample, w * meter.runs() + i));
+            }
+        }
+        meter.measure([&](int i) {
+            std::vector<std::jthread> threads;
+            for (std::size_t w = 0; w < writers.size(); ++w) {
+                threads.emplace_back([&, w] {
+                    writers[w]->Save(new_books[w][i]);
+                });
+            }
+        });
+        for (auto& saved : new_books) {
+            DeleteBooks(books, saved);
+        }
+    };
+
+    BENCHMARK_ADVANCED(name("EditBook"sv))(Catch::Benchmark::Chronometer meter) {
+        std::vector<domain::Book> new_books;
+        std::vector<std::string> ids;
+        std::vector<std::string> titles;
+        for (int i = 0; i < meter.runs(); ++i) {
+            new_books.push_back(MakeBook(sample, i));
+            books.Save(new_books.back());
+            ids.push_back(new_books.back().GetBookId().ToString());
+            titles.push_back(MakeUniqueName("Edited book "sv));
+        }
+        meter.measure([&](int i) {
+            books.EditBook(titles[i], 2001, {"tag 3"s, "edited"s}, ids[i]);
+        });
+        DeleteBooks(books, new_books);
+    };
+
+    BENCHMARK_ADVANCED(name("DeleteBook"sv))(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::string> ids;
+        for (int i = 0; i < meter.runs(); ++i) {
+            auto book = MakeBook(sample, i);
+            books.Save(book);
+            ids.push_back(book.GetBookId().ToString());
+        }
+        meter.measure([&](int i) {
+            books.DeleteBook(ids[i]);
+        });
+    };
+}
+
+}  // namespace
+
+TEST_CASE("Storage backends", "[backends]") {
+    const auto catalog_size = GENERATE(from_range(bench::GetCatalogSizes()));
+    const auto& sample = bench::PrepareCatalog(catalog_size);
+    const auto& log_path = bench::PrepareLocalCatalog(catalog_size);
+    const auto suffix = " ["s + std::to_string(catalog_size) + " books]"s;
+
+    {
+        std::vector<std::unique_ptr<postgres::Database>> databases;
+        std::vector<domain::BookRepository*> writers;
+        for (int i = 0; i < WRITER_THREADS; ++i) {
+            databases.push_back(
+                std::make_unique<postgres::Database>(pqxx::connection{bench::GetDatabase().GetUrl()}));
+            writers.push_back(&databases.back()->GetBooks());
+        }
+        BenchmarkBackend("postgres"sv, databases.front()->GetAuthors(), databases.front()->GetBooks(), writers,
+                         sample, suffix);
+    }
+
+    {
+        // Synced like the application runs it
+        storage::Database local{{log_path}};
+        const std::vector<domain::BookRepository*> writers(WRITER_THREADS, &local.GetBooks());
+        BenchmarkBackend("storage"sv, local.GetAuthors(), local.GetBooks(), writers, sample, suffix);
+    }
+}
@@ -0,0 +1,58 @@
+#include "catalog_indexes.h"
+
+#include "../search/columnar_catalog.h"
+#include "../search/similar_books.h"
+
+namespace app {
+
+template <typename Index>
+std::shared_ptr<const Index> CatalogIndexes::Get(Slot<Index>& slot, domain::BookRepository& books) {
+    {
+        std::lock_guard lock{mutex_};
+        if (slot.index && slot.generation == generation_) {
+            return slot.index;
+        }
+    }
+
+    std::lock_guard loading{slot.load_mutex};
+    std::uint64_t generation;
+    {
+        std::lock_guard lock{mutex_};
+        // Loaded by the query this one waited for
+        if (slot.index && slot.generation == generation_) {
+            return slot.index;
+        }
+        generation = generation_;
+    }
+    auto index = std::make_shared<const Index>(Index::Load(books));
+    {
+        std::lock_guard lock{mutex_};
+        if (generation == generation_) {
+            slot.index = index;
+            slot.generation = generation;
+        }
+    }
+    return index;
+}
+
+std::shared_ptr<const search::ColumnarCatalog> CatalogIndexes::GetSearchCatalog(domain::BookRepository& books) {
+    return Get(search_catalog_, books);
+}
+
+std::shared_ptr<const search::SimilarityIndex> CatalogIndexes::GetSimilarityIndex(domain::BookRepository& books) {
+    return Get(similarity_index_, books);
+}
+
+void CatalogIndexes::Invalidate() {
+    std::shared_ptr<const search::ColumnarCatalog> search_catalog;
+    std::shared_ptr<const search::SimilarityIndex> similarity_index;
+    {
+        std::lock_guard lock{mutex_};
+        ++generation_;
+        // Freed outside the lock, unless a query still uses them
+        search_catalog = std::move(search_catalog_.index);
+        similarity_index = std::move(similarity_index_.index);
+    }
+}
+
+}  // namespace app
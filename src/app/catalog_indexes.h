@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "../domain/book_fwd.h"
+
+namespace search {
+class ColumnarCatalog;
+class SimilarityIndex;
+}  // namespace search
+
+namespace app {
+
+/**
+ * In-memory search indexes of the catalog, shared by the use cases of every executor worker,
+ * so the catalog is held once however many workers there are.
+ *
+ * An index is loaded by the first query that needs it and kept until a change of the catalog
+ * made through any of the use cases invalidates them all. Invalidation moves a generation
+ * counter on: an index loaded while a change was being made is handed to the query that
+ * loaded it, but not kept, so the next query loads one that has the change.
+ */
+class CatalogIndexes {
+public:
+    // Loads the index from the repository if there is no current one. Concurrent misses wait for one load.
+    std::shared_ptr<const search::ColumnarCatalog> GetSearchCatalog(domain::BookRepository& books);
+    std::shared_ptr<const search::SimilarityIndex> GetSimilarityIndex(domain::BookRepository& books);
+
+    // Called once a change of the catalog is made
+    void Invalidate();
+
+private:
+    template <typename Index>
+    struct Slot {
+        std::shared_ptr<const Index> index;
+        // The generation it was loaded at
+        std::uint64_t generation = 0;
+        std::mutex load_mutex;
+    };
+
+    template <typename Index>
+    std::shared_ptr<const Index> Get(Slot<Index>& slot, domain::BookRepository& books);
+
+    std::mutex mutex_;
+    std::uint64_t generation_ = 0;
+    Slot<search::ColumnarCatalog> search_catalog_;
+    Slot<search::SimilarityIndex> similarity_index_;
+};
+
+}  // namespace app
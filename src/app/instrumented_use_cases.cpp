@@ -0,0 +1,241 @@
+#include "instrumented_use_cases.h"
+
+#include <exception>
+#include <iomanip>
+#include <optional>
+#include <ostream>
+
+#include "../util/command_context.h"
+
+namespace app {
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Records the duration of the enclosing call and whether it left by an exception.
+// Calls made outside of any user command (e.g. by the HTTP server) are attributed
+// to the use case itself.
+class OperationTimer {
+public:
+    OperationTimer(InstrumentedUseCases::OperationStats& stats, InstrumentedUseCases::Operation operation)
+        : stats_{stats}
+        , exceptions_{std::uncaught_exceptions()}
+        , start_{Clock::now()} {
+        if (util::GetCurrentCommand().name.empty()) {
+            command_.emplace(InstrumentedUseCases::GetOperationName(operation));
+        }
+    }
+
+    ~OperationTimer() {
+        stats_.latency.Record(Clock::now() - start_);
+        if (std::uncaught_exceptions() > exceptions_) {
+            stats_.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    OperationTimer(const OperationTimer&) = delete;
+    OperationTimer& operator=(const OperationTimer&) = delete;
+
+private:
+    InstrumentedUseCases::OperationStats& stats_;
+    int exceptions_;
+    Clock::time_point start_;
+    std::optional<util::CommandScope> command_;
+};
+
+double ToMilliseconds(util::LatencyHistogram::Duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+double ToSeconds(util::LatencyHistogram::Duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+constexpr std::array PROMETHEUS_BUCKETS{
+    100us, 250us, 500us, 1000us, 2500us, 5000us, 10000us, 25000us,
+    50000us, 100000us, 250000us, 500000us, 1000000us, 2500000us, 5000000us, 10000000us,
+};
+
+}  // namespace
+
+void InstrumentedUseCases::AddAuthor(const std::string& name) {
+    OperationTimer timer{GetStats(Operation::AddAuthor), Operation::AddAuthor};
+    use_cases_.AddAuthor(name);
+}
+
+void InstrumentedUseCases::AddBook(int year, const std::string& title, domain::AuthorId id, std::optional<std::set<std::string>> tags) {
+    OperationTimer timer{GetStats(Operation::AddBook), Operation::AddBook};
+    use_cases_.AddBook(year, title, std::move(id), std::move(tags));
+}
+
+void InstrumentedUseCases::DeleteAuthor(std::string& name) {
+    OperationTimer timer{GetStats(Operation::DeleteAuthor), Operation::DeleteAuthor};
+    use_cases_.DeleteAuthor(name);
+}
+
+void InstrumentedUseCases::EditAuthor(std::string& new_name, std::string& old_name) {
+    OperationTimer timer{GetStats(Operation::EditAuthor), Operation::EditAuthor};
+    use_cases_.EditAuthor(new_name, old_name);
+}
+
+std::vector<domain::Author> InstrumentedUseCases::GetAuthors() {
+    OperationTimer timer{GetStats(Operation::GetAuthors), Operation::GetAuthors};
+    return use_cases_.GetAuthors();
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string>> InstrumentedUseCases::ShowBooks() {
+    OperationTimer timer{GetStats(Operation::ShowBooks), Operation::ShowBooks};
+    return use_cases_.ShowBooks();
+}
+
+// Streams are timed up to the first batch, which is when the first row can be shown
+domain::Stream<domain::Author> InstrumentedUseCases::StreamAuthors() {
+    OperationTimer timer{GetStats(Operation::StreamAuthors), Operation::StreamAuthors};
+    auto authors = use_cases_.StreamAuthors();
+    authors.begin();
+    return authors;
+}
+
+domain::Stream<std::tuple<std::string, std::string, int, std::string>> InstrumentedUseCases::StreamBooks() {
+    OperationTimer timer{GetStats(Operation::StreamBooks), Operation::StreamBooks};
+    auto books = use_cases_.StreamBooks();
+    books.begin();
+    return books;
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> InstrumentedUseCases::ShowBook(std::string& book_name) {
+    OperationTimer timer{GetStats(Operation::ShowBook), Operation::ShowBook};
+    return use_cases_.ShowBook(book_name);
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> InstrumentedUseCases::ShowBooksDetails(const std::vector<std::string>& book_ids) {
+    OperationTimer timer{GetStats(Operation::ShowBooksDetails), Operation::ShowBooksDetails};
+    return use_cases_.ShowBooksDetails(book_ids);
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string>> InstrumentedUseCases::SearchBooks(const search::Query& query) {
+    OperationTimer timer{GetStats(Operation::SearchBooks), Operation::SearchBooks};
+    return use_cases_.SearchBooks(query);
+}
+
+domain::CatalogStats InstrumentedUseCases::GetCatalogStats(domain::StatsSource source) {
+    OperationTimer timer{GetStats(Operation::GetCatalogStats), Operation::GetCatalogStats};
+    return use_cases_.GetCatalogStats(source);
+}
+
+std::vector<search::SimilarBook> InstrumentedUseCases::SimilarBooks(const std::string& book_id, std::size_t k) {
+    OperationTimer timer{GetStats(Operation::SimilarBooks), Operation::SimilarBooks};
+    return use_cases_.SimilarBooks(book_id, k);
+}
+
+std::vector<search::DuplicateGroup> InstrumentedUseCases::FindDuplicates() {
+    OperationTimer timer{GetStats(Operation::FindDuplicates), Operation::FindDuplicates};
+    return use_cases_.FindDuplicates();
+}
+
+std::vector<domain::Book> InstrumentedUseCases::GetAuthorBooks(const std::string& author_id) {
+    OperationTimer timer{GetStats(Operation::GetAuthorBooks), Operation::GetAuthorBooks};
+    return use_cases_.GetAuthorBooks(author_id);
+}
+
+std::vector<domain::Book> InstrumentedUseCases::GetAuthorBooksPage(const std::string& author_id,
+                                                                   const std::optional<domain::AuthorBooksCursor>& after,
+                                                                   std::size_t limit) {
+    OperationTimer timer{GetStats(Operation::GetAuthorBooksPage), Operation::GetAuthorBooksPage};
+    return use_cases_.GetAuthorBooksPage(author_id, after, limit);
+}
+
+void InstrumentedUseCases::DeleteBook(std::string& book_id) {
+    OperationTimer timer{GetStats(Operation::DeleteBook), Operation::DeleteBook};
+    use_cases_.DeleteBook(book_id);
+}
+
+void InstrumentedUseCases::EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) {
+    OperationTimer timer{GetStats(Operation::EditBook), Operation::EditBook};
+    use_cases_.EditBook(title, publication_year, std::move(tags), id);
+}
+
+std::uint64_t InstrumentedUseCases::DeleteBooksByTag(const std::string& tag) {
+    OperationTimer timer{GetStats(Operation::DeleteBooksByTag), Operation::DeleteBooksByTag};
+    return use_cases_.DeleteBooksByTag(tag);
+}
+
+std::uint64_t InstrumentedUseCases::RetagBooks(const std::string& from, const std::string& to) {
+    OperationTimer timer{GetStats(Operation::RetagBooks), Operation::RetagBooks};
+    return use_cases_.RetagBooks(from, to);
+}
+
+std::uint64_t InstrumentedUseCases::DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) {
+    OperationTimer timer{GetStats(Operation::DeleteBooksByAuthorAndYearRange), Operation::DeleteBooksByAuthorAndYearRange};
+    return use_cases_.DeleteBooksByAuthorAndYearRange(author_id, min_year, max_year);
+}
+
+std::string_view InstrumentedUseCases::GetOperationName(Operation operation) noexcept {
+    constexpr std::array<std::string_view, static_cast<std::size_t>(Operation::Count)> names{
+        "AddAuthor"sv, "AddBook"sv, "DeleteAuthor"sv, "EditAuthor"sv, "GetAuthors"sv,
+        "ShowBooks"sv, "ShowBook"sv, "GetAuthorBooks"sv, "DeleteBook"sv, "EditBook"sv, "ShowBooksDetails"sv,
+        "SearchBooks"sv, "GetCatalogStats"sv, "SimilarBooks"sv, "FindDuplicates"sv,
+        "DeleteBooksByTag"sv, "RetagBooks"sv, "DeleteBooksByAuthorAndYearRange"sv, "GetAuthorBooksPage"sv,
+        "StreamAuthors"sv, "StreamBooks"sv,
+    };
+    return names[static_cast<std::size_t>(operation)];
+}
+
+void InstrumentedUseCases::PrintStats(std::ostream& out) const {
+    const auto old_flags = out.flags();
+    const auto old_precision = out.precision();
+
+    out << std::left << std::setw(16) << "Operation"sv << std::right
+        << std::setw(10) << "Calls"sv << std::setw(8) << "Errors"sv
+        << std::setw(12) << "p50, ms"sv << std::setw(12) << "p90, ms"sv
+        << std::setw(12) << "p99, ms"sv << std::setw(12) << "max, ms"sv << std::endl;
+    out << std::fixed << std::setprecision(3);
+    for (std::size_t i = 0; i < stats_.size(); ++i) {
+        const auto& stats = stats_[i];
+        const auto& latency = stats.latency;
+        if (latency.GetCount() == 0) {
+            continue;
+        }
+        out << std::left << std::setw(16) << GetOperationName(static_cast<Operation>(i)) << std::right
+            << std::setw(10) << latency.GetCount() << std::setw(8) << stats.errors.load(std::memory_order_relaxed)
+            << std::setw(12) << ToMilliseconds(latency.GetPercentile(50))
+            << std::setw(12) << ToMilliseconds(latency.GetPercentile(90))
+            << std::setw(12) << ToMilliseconds(latency.GetPercentile(99))
+            << std::setw(12) << ToMilliseconds(latency.GetMax()) << std::endl;
+    }
+
+    out.flags(old_flags);
+    out.precision(old_precision);
+}
+
+void InstrumentedUseCases::WritePrometheus(std::ostream& out) const {
+    out << "# HELP bookypedia_use_case_duration_seconds Duration of app::UseCases calls\n"sv
+        << "# TYPE bookypedia_use_case_duration_seconds histogram\n"sv;
+    for (std::size_t i = 0; i < stats_.size(); ++i) {
+        const auto name = GetOperationName(static_cast<Operation>(i));
+        const auto& latency = stats_[i].latency;
+        for (const auto bucket : PROMETHEUS_BUCKETS) {
+            out << "bookypedia_use_case_duration_seconds_bucket{operation=\""sv << name << "\",le=\""sv
+                << ToSeconds(bucket) << "\"} "sv << latency.GetCountAtOrBelow(bucket) << '\n';
+        }
+        out << "bookypedia_use_case_duration_seconds_bucket{operation=\""sv << name << "\",le=\"+Inf\"} "sv
+            << latency.GetCount() << '\n';
+        out << "bookypedia_use_case_duration_seconds_sum{operation=\""sv << name << "\"} "sv
+            << ToSeconds(latency.GetSum()) << '\n';
+        out << "bookypedia_use_case_duration_seconds_count{operation=\""sv << name << "\"} "sv
+            << latency.GetCount() << '\n';
+    }
+
+    out << "# HELP bookypedia_use_case_errors_total app::UseCases calls that ended with an exception\n"sv
+        << "# TYPE bookypedia_use_case_errors_total counter\n"sv;
+    for (std::size_t i = 0; i < stats_.size(); ++i) {
+        out << "bookypedia_use_case_errors_total{operation=\""sv << GetOperationName(static_cast<Operation>(i))
+            << "\"} "sv << stats_[i].errors.load(std::memory_order_relaxed) << '\n';
+    }
+    out.flush();
+}
+
+}  // namespace app
@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <iosfwd>
+#include <string_view>
+
+#include "../util/latency_histogram.h"
+#include "use_cases.h"
+
+namespace app {
+
+// Decorator recording latency, call and error counts of every use case call
+// before passing it on to the wrapped use cases.
+// Recording is lock-free, so the decorator can be shared between threads
+// as long as the wrapped object can.
+class InstrumentedUseCases : public UseCases {
+public:
+    enum class Operation {
+        AddAuthor,
+        AddBook,
+        DeleteAuthor,
+        EditAuthor,
+        GetAuthors,
+        ShowBooks,
+        ShowBook,
+        GetAuthorBooks,
+        DeleteBook,
+        EditBook,
+        ShowBooksDetails,
+        SearchBooks,
+        GetCatalogStats,
+        SimilarBooks,
+        FindDuplicates,
+        DeleteBooksByTag,
+        RetagBooks,
+        DeleteBooksByAuthorAndYearRange,
+        GetAuthorBooksPage,
+        StreamAuthors,
+        StreamBooks,
+        Count
+    };
+
+    struct OperationStats {
+        util::LatencyHistogram latency;
+        std::atomic<std::uint64_t> errors{0};
+    };
+
+    explicit InstrumentedUseCases(UseCases& use_cases)
+        : use_cases_{use_cases}
+    {}
+
+    void AddAuthor(const std::string& name) override;
+    void AddBook(int year, const std::string& title, domain::AuthorId id, std::optional<std::set<std::string>> tags) override;
+    void DeleteAuthor(std::string& name) override;
+    void EditAuthor(std::string& new_name, std::string& old_name) override;
+    std::vector<domain::Author> GetAuthors() override;
+    domain::Stream<domain::Author> StreamAuthors() override;
+    std::vector<std::tuple<std::string, std::string, int, std::string>> ShowBooks() override;
+    domain::Stream<std::tuple<std::string, std::string, int, std::string>> StreamBooks() override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBook(std::string& book_name) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBooksDetails(const std::vector<std::string>& book_ids) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string>> SearchBooks(const search::Query& query) override;
+    domain::CatalogStats GetCatalogStats(domain::StatsSource source) override;
+    std::vector<search::SimilarBook> SimilarBooks(const std::string& book_id, std::size_t k) override;
+    std::vector<search::DuplicateGroup> FindDuplicates() override;
+    std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) override;
+    std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                 const std::optional<domain::AuthorBooksCursor>& after,
+                                                 std::size_t limit) override;
+    void DeleteBook(std::string& book_id) override;
+    void EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) override;
+    std::uint64_t DeleteBooksByTag(const std::string& tag) override;
+    std::uint64_t RetagBooks(const std::string& from, const std::string& to) override;
+    std::uint64_t DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) override;
+
+    static std::string_view GetOperationName(Operation operation) noexcept;
+
+    const OperationStats& GetStats(Operation operation) const noexcept {
+        return stats_[static_cast<std::size_t>(operation)];
+    }
+
+    // Human readable table with call and error counts and p50/p90/p99/max latency
+    void PrintStats(std::ostream& out) const;
+    // Prometheus text exposition format
+    void WritePrometheus(std::ostream& out) const;
+
+private:
+    OperationStats& GetStats(Operation operation) noexcept {
+        return stats_[static_cast<std::size_t>(operation)];
+    }
+
+    UseCases& use_cases_;
+    std::array<OperationStats, static_cast<std::size_t>(Operation::Count)> stats_;
+};
+
+}  // namespace app
@@ -6,6 +6,9 @@
 #include <tuple>
 #include "../domain/author.h"
 #include "../domain/book.h"
+#include "../search/columnar_catalog.h"
+#include "../search/duplicates.h"
+#include "../search/similar_books.h"
 
 namespace app {
 
@@ -17,10 +20,29 @@ public:
     virtual void EditAuthor(std::string& new_name, std::string& old_name) = 0;
     virtual std::vector<domain::Author> GetAuthors() = 0;
     virtual std::vector<std::tuple<std::string, std::string, int, std::string>> ShowBooks() = 0;
+    // GetAuthors and ShowBooks without materializing the whole result
+    virtual domain::Stream<domain::Author> StreamAuthors() = 0;
+    virtual domain::Stream<std::tuple<std::string, std::string, int, std::string>> StreamBooks() = 0;
     virtual std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBook(std::string& book_name) = 0;
+    virtual std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBooksDetails(const std::vector<std::string>& book_ids) = 0;
+    // Substring and year range search over a columnar copy of the catalog
+    virtual std::vector<std::tuple<std::string, std::string, int, std::string>> SearchBooks(const search::Query& query) = 0;
+    virtual domain::CatalogStats GetCatalogStats(domain::StatsSource source) = 0;
+    // Up to k books sharing the most tags with the book, by Jaccard similarity
+    virtual std::vector<search::SimilarBook> SimilarBooks(const std::string& book_id, std::size_t k) = 0;
+    // Groups of books of the same author with near-identical titles
+    virtual std::vector<search::DuplicateGroup> FindDuplicates() = 0;
     virtual std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) = 0;
+    // A page of the author's books with their tags, see domain::AuthorBooksCursor
+    virtual std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                         const std::optional<domain::AuthorBooksCursor>& after,
+                                                         std::size_t limit) = 0;
     virtual void DeleteBook(std::string& book_id) = 0;
     virtual void EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) = 0;
+    // Bulk changes return the number of books changed
+    virtual std::uint64_t DeleteBooksByTag(const std::string& tag) = 0;
+    virtual std::uint64_t RetagBooks(const std::string& from, const std::string& to) = 0;
+    virtual std::uint64_t DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) = 0;
 
 protected:
     ~UseCases() = default;
@@ -0,0 +1,283 @@
+#include "use_cases_executor.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+#include "../domain/author.h"
+#include "../domain/book.h"
+
+namespace app {
+
+namespace {
+
+std::vector<std::shared_ptr<UseCases>> MakeWorkerUseCases(std::size_t threads, const UseCasesExecutor::Factory& factory) {
+    std::vector<std::shared_ptr<UseCases>> use_cases;
+    threads = std::max<std::size_t>(threads, 1);
+    use_cases.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        use_cases.push_back(factory());
+    }
+    return use_cases;
+}
+
+// Rows handed over from the worker at a time, as many as a cursor of the repositories fetches
+constexpr std::size_t STREAM_BATCH_SIZE = 1000;
+
+// Rows of a stream that a worker opens and reads, handed over to the calling thread a batch at a time.
+// The stream keeps a transaction open on the worker's connection between batches, so the worker
+// stays with it until it ends or is dropped rather than taking other calls; a task stolen by
+// another worker could not fetch the next batch on that connection.
+template <typename T>
+class WorkerStreamSource : public domain::Stream<T>::Source {
+public:
+    using Open = std::function<domain::Stream<T>(UseCases&)>;
+
+    WorkerStreamSource(UseCasesExecutor& executor, Open open)
+        : executor_{executor}
+        , open_{std::move(open)}
+        , handover_{std::make_shared<Handover>()} {
+    }
+
+    ~WorkerStreamSource() override {
+        {
+            std::lock_guard lock{handover_->mutex};
+            handover_->dropped = true;
+        }
+        handover_->changed.notify_all();
+    }
+
+    void FetchBatch(std::vector<T>& batch) override {
+        if (!started_) {
+            started_ = true;
+            executor_.Submit([handover = handover_, open = std::move(open_)](UseCases& use_cases) {
+                Read(*handover, open, use_cases);
+            });
+        }
+        std::unique_lock lock{handover_->mutex};
+        handover_->changed.wait(lock, [this] {
+            return handover_->has_batch || handover_->done;
+        });
+        if (handover_->has_batch) {
+            // The rows given back are those the worker fills in next
+            batch.swap(handover_->batch);
+            handover_->has_batch = false;
+            lock.unlock();
+            handover_->changed.notify_all();
+            return;
+        }
+        if (handover_->error) {
+            std::rethrow_exception(handover_->error);
+        }
+        batch.clear();
+    }
+
+private:
+    // One batch at most waits for the calling thread while the worker reads the next one
+    struct Handover {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<T> batch;
+        bool has_batch = false;
+        bool done = false;
+        bool dropped = false;
+        std::exception_ptr error;
+    };
+
+    static void Read(Handover& handover, const Open& open, UseCases& use_cases) {
+        std::vector<T> batch;
+        // Waits for the previous batch to be taken; false once the stream is dropped
+        const auto hand_over = [&handover, &batch] {
+            std::unique_lock lock{handover.mutex};
+            handover.changed.wait(lock, [&handover] {
+                return !handover.has_batch || handover.dropped;
+            });
+            if (handover.dropped) {
+                return false;
+            }
+            batch.swap(handover.batch);
+            handover.has_batch = true;
+            lock.unlock();
+            handover.changed.notify_all();
+            batch.clear();
+            return true;
+        };
+        try {
+            for (const auto& row : open(use_cases)) {
+                batch.push_back(row);
+                if (batch.size() == STREAM_BATCH_SIZE && !hand_over()) {
+                    return;
+                }
+            }
+            if (!batch.empty() && !hand_over()) {
+                return;
+            }
+        } catch (const std::exception&) {
+            std::lock_guard lock{handover.mutex};
+            handover.error = std::current_exception();
+        }
+        {
+            std::lock_guard lock{handover.mutex};
+            handover.done = true;
+        }
+        handover.changed.notify_all();
+    }
+
+    UseCasesExecutor& executor_;
+    Open open_;
+    // Shared with the worker's task, which may still be running when the stream is dropped
+    std::shared_ptr<Handover> handover_;
+    bool started_ = false;
+};
+
+template <typename T>
+domain::Stream<T> StreamOnWorker(UseCasesExecutor& executor, typename WorkerStreamSource<T>::Open open) {
+    return domain::Stream<T>{std::make_unique<WorkerStreamSource<T>>(executor, std::move(open))};
+}
+
+// Books leave the worker with their tags: tags loaded lazily would be read on the worker's
+// connection by the calling thread, while the worker may be running another call on it
+std::vector<domain::Book> WithTagsLoaded(std::vector<domain::Book> books) {
+    for (const auto& book : books) {
+        book.GetTags();
+    }
+    return books;
+}
+
+}  // namespace
+
+UseCasesExecutor::UseCasesExecutor(std::size_t threads, const Factory& factory)
+    : use_cases_{MakeWorkerUseCases(threads, factory)}
+    , pool_{use_cases_.size()} {
+}
+
+void BlockingUseCases::AddAuthor(const std::string& name) {
+    executor_.Submit([&name](UseCases& use_cases) {
+        use_cases.AddAuthor(name);
+    }).get();
+}
+
+void BlockingUseCases::AddBook(int year, const std::string& title, domain::AuthorId id, std::optional<std::set<std::string>> tags) {
+    executor_.Submit([&](UseCases& use_cases) {
+        use_cases.AddBook(year, title, std::move(id), std::move(tags));
+    }).get();
+}
+
+void BlockingUseCases::DeleteAuthor(std::string& name) {
+    executor_.Submit([&name](UseCases& use_cases) {
+        use_cases.DeleteAuthor(name);
+    }).get();
+}
+
+void BlockingUseCases::EditAuthor(std::string& new_name, std::string& old_name) {
+    executor_.Submit([&](UseCases& use_cases) {
+        use_cases.EditAuthor(new_name, old_name);
+    }).get();
+}
+
+std::vector<domain::Author> BlockingUseCases::GetAuthors() {
+    return executor_.Submit([](UseCases& use_cases) {
+        return use_cases.GetAuthors();
+    }).get();
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string>> BlockingUseCases::ShowBooks() {
+    return executor_.Submit([](UseCases& use_cases) {
+        return use_cases.ShowBooks();
+    }).get();
+}
+
+domain::Stream<domain::Author> BlockingUseCases::StreamAuthors() {
+    return StreamOnWorker<domain::Author>(executor_, [](UseCases& use_cases) {
+        return use_cases.StreamAuthors();
+    });
+}
+
+domain::Stream<std::tuple<std::string, std::string, int, std::string>> BlockingUseCases::StreamBooks() {
+    return StreamOnWorker<std::tuple<std::string, std::string, int, std::string>>(executor_, [](UseCases& use_cases) {
+        return use_cases.StreamBooks();
+    });
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> BlockingUseCases::ShowBook(std::string& book_name) {
+    return executor_.Submit([&book_name](UseCases& use_cases) {
+        return use_cases.ShowBook(book_name);
+    }).get();
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> BlockingUseCases::ShowBooksDetails(const std::vector<std::string>& book_ids) {
+    return executor_.Submit([&book_ids](UseCases& use_cases) {
+        return use_cases.ShowBooksDetails(book_ids);
+    }).get();
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string>> BlockingUseCases::SearchBooks(const search::Query& query) {
+    return executor_.Submit([&query](UseCases& use_cases) {
+        return use_cases.SearchBooks(query);
+    }).get();
+}
+
+domain::CatalogStats BlockingUseCases::GetCatalogStats(domain::StatsSource source) {
+    return executor_.Submit([source](UseCases& use_cases) {
+        return use_cases.GetCatalogStats(source);
+    }).get();
+}
+
+std::vector<search::SimilarBook> BlockingUseCases::SimilarBooks(const std::string& book_id, std::size_t k) {
+    return executor_.Submit([&book_id, k](UseCases& use_cases) {
+        return use_cases.SimilarBooks(book_id, k);
+    }).get();
+}
+
+std::vector<search::DuplicateGroup> BlockingUseCases::FindDuplicates() {
+    return executor_.Submit([](UseCases& use_cases) {
+        return use_cases.FindDuplicates();
+    }).get();
+}
+
+std::vector<domain::Book> BlockingUseCases::GetAuthorBooks(const std::string& author_id) {
+    return executor_.Submit([&author_id](UseCases& use_cases) {
+        return WithTagsLoaded(use_cases.GetAuthorBooks(author_id));
+    }).get();
+}
+
+std::vector<domain::Book> BlockingUseCases::GetAuthorBooksPage(const std::string& author_id,
+                                                               const std::optional<domain::AuthorBooksCursor>& after,
+                                                               std::size_t limit) {
+    return executor_.Submit([&author_id, &after, limit](UseCases& use_cases) {
+        return WithTagsLoaded(use_cases.GetAuthorBooksPage(author_id, after, limit));
+    }).get();
+}
+
+void BlockingUseCases::DeleteBook(std::string& book_id) {
+    executor_.Submit([&book_id](UseCases& use_cases) {
+        use_cases.DeleteBook(book_id);
+    }).get();
+}
+
+void BlockingUseCases::EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) {
+    executor_.Submit([&](UseCases& use_cases) {
+        use_cases.EditBook(title, publication_year, std::move(tags), id);
+    }).get();
+}
+
+std::uint64_t BlockingUseCases::DeleteBooksByTag(const std::string& tag) {
+    return executor_.Submit([&tag](UseCases& use_cases) {
+        return use_cases.DeleteBooksByTag(tag);
+    }).get();
+}
+
+std::uint64_t BlockingUseCases::RetagBooks(const std::string& from, const std::string& to) {
+    return executor_.Submit([&from, &to](UseCases& use_cases) {
+        return use_cases.RetagBooks(from, to);
+    }).get();
+}
+
+std::uint64_t BlockingUseCases::DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) {
+    return executor_.Submit([&author_id, min_year, max_year](UseCases& use_cases) {
+        return use_cases.DeleteBooksByAuthorAndYearRange(author_id, min_year, max_year);
+    }).get();
+}
+
+}  // namespace app
@@ -0,0 +1,89 @@
+#pragma once
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "../util/work_stealing_pool.h"
+#include "use_cases.h"
+
+namespace app {
+
+// Runs use case calls concurrently on a work-stealing thread pool.
+// Every worker has its own UseCases instance, typically with its own repositories
+// over a dedicated database connection, so calls never share a connection
+// and reads scale with the number of workers.
+class UseCasesExecutor {
+public:
+    // Creates the UseCases of one worker
+    using Factory = std::function<std::shared_ptr<UseCases>()>;
+
+    // The factory is called on the constructing thread, once per worker, so that
+    // database schema setup is not run concurrently
+    UseCasesExecutor(std::size_t threads, const Factory& factory);
+
+    // Runs fn(UseCases&) on one of the workers
+    template <typename Fn>
+    std::future<std::invoke_result_t<Fn&, UseCases&>> Submit(Fn fn) {
+        using Result = std::invoke_result_t<Fn&, UseCases&>;
+        auto task = std::make_shared<std::packaged_task<Result()>>([this, fn = std::move(fn)]() mutable {
+            return fn(*use_cases_[*pool_.GetWorkerIndex()]);
+        });
+        auto result = task->get_future();
+        pool_.Submit([task = std::move(task)] {
+            (*task)();
+        });
+        return result;
+    }
+
+    std::size_t GetSize() const noexcept {
+        return pool_.GetSize();
+    }
+
+private:
+    std::vector<std::shared_ptr<UseCases>> use_cases_;
+    // Destroyed first, so the workers are stopped before their use cases
+    util::WorkStealingPool pool_;
+};
+
+// UseCases running every call on the executor and waiting for its result.
+// Unlike UseCasesImpl over a single connection, it can be called from many threads at once,
+// but not from the executor's workers, which would wait for themselves. A stream is read on
+// one worker, which hands its rows over a batch at a time and takes no other calls until
+// the stream ends or is dropped.
+class BlockingUseCases : public UseCases {
+public:
+    explicit BlockingUseCases(UseCasesExecutor& executor)
+        : executor_{executor}
+    {}
+
+    void AddAuthor(const std::string& name) override;
+    void AddBook(int year, const std::string& title, domain::AuthorId id, std::optional<std::set<std::string>> tags) override;
+    void DeleteAuthor(std::string& name) override;
+    void EditAuthor(std::string& new_name, std::string& old_name) override;
+    std::vector<domain::Author> GetAuthors() override;
+    domain::Stream<domain::Author> StreamAuthors() override;
+    std::vector<std::tuple<std::string, std::string, int, std::string>> ShowBooks() override;
+    domain::Stream<std::tuple<std::string, std::string, int, std::string>> StreamBooks() override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBook(std::string& book_name) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBooksDetails(const std::vector<std::string>& book_ids) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string>> SearchBooks(const search::Query& query) override;
+    domain::CatalogStats GetCatalogStats(domain::StatsSource source) override;
+    std::vector<search::SimilarBook> SimilarBooks(const std::string& book_id, std::size_t k) override;
+    std::vector<search::DuplicateGroup> FindDuplicates() override;
+    std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) override;
+    std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                 const std::optional<domain::AuthorBooksCursor>& after,
+                                                 std::size_t limit) override;
+    void DeleteBook(std::string& book_id) override;
+    void EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) override;
+    std::uint64_t DeleteBooksByTag(const std::string& tag) override;
+    std::uint64_t RetagBooks(const std::string& from, const std::string& to) override;
+    std::uint64_t DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) override;
+
+private:
+    UseCasesExecutor& executor_;
+};
+
+}  // namespace app
@@ -8,23 +8,49 @@
 namespace app {
 using namespace domain;
 
+namespace {
+
+// Invalidates the indexes when the change is made, or has failed part way
+class IndexInvalidation {
+public:
+    explicit IndexInvalidation(CatalogIndexes& indexes)
+        : indexes_{indexes}
+    {}
+
+    ~IndexInvalidation()
+    {
+        indexes_.Invalidate();
+    }
+
+    IndexInvalidation(const IndexInvalidation&) = delete;
+    IndexInvalidation& operator=(const IndexInvalidation&) = delete;
+
+private:
+    CatalogIndexes& indexes_;
+};
+
+}  // namespace
+
 void app::UseCasesImpl::AddAuthor(const std::string& name) {
     authors_.Save({AuthorId::New(), name});
 }
 
 void app::UseCasesImpl::DeleteAuthor(std::string& name)
 {
+    const IndexInvalidation invalidation{*indexes_};
     authors_.Delete(name);
 }
 
 void app::UseCasesImpl::EditAuthor(std::string& new_name, std::string& old_name)
 {
+    const IndexInvalidation invalidation{*indexes_};
     authors_.Edit(new_name, old_name);
 }
 
 void app::UseCasesImpl::AddBook(int year, const std::string& title, domain::AuthorId id, std::optional<std::set<std::string>> tags)
 {
-    books_.Save({ BookId::New(), id, title, year, tags });
+    const IndexInvalidation invalidation{*indexes_};
+    books_.Save({ BookId::New(), std::move(id), title, year, std::move(tags) });
 }
 
 std::vector<domain::Author> app::UseCasesImpl::GetAuthors()
@@ -37,24 +63,86 @@ std::vector<std::tuple<std::string, std::string, int, std::string>> app::UseCase
     return books_.ShowBooks();
 }
 
+domain::Stream<domain::Author> app::UseCasesImpl::StreamAuthors()
+{
+    return authors_.StreamAuthors();
+}
+
+domain::Stream<std::tuple<std::string, std::string, int, std::string>> app::UseCasesImpl::StreamBooks()
+{
+    return books_.StreamBooks();
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string>> app::UseCasesImpl::SearchBooks(const search::Query& query)
+{
+    return indexes_->GetSearchCatalog(books_)->Search(query);
+}
+
+domain::CatalogStats app::UseCasesImpl::GetCatalogStats(domain::StatsSource source)
+{
+    return books_.GetCatalogStats(source);
+}
+
+std::vector<search::SimilarBook> app::UseCasesImpl::SimilarBooks(const std::string& book_id, std::size_t k)
+{
+    return indexes_->GetSimilarityIndex(books_)->FindSimilar(book_id, k);
+}
+
+std::vector<search::DuplicateGroup> app::UseCasesImpl::FindDuplicates()
+{
+    return search::FindDuplicates(authors_, books_);
+}
+
 std::vector<domain::Book> app::UseCasesImpl::GetAuthorBooks(const std::string& author_id)
 {
     return books_.GetAuthorBooks(author_id);
 }
 
+std::vector<domain::Book> app::UseCasesImpl::GetAuthorBooksPage(const std::string& author_id,
+                                                                const std::optional<domain::AuthorBooksCursor>& after,
+                                                                std::size_t limit)
+{
+    return books_.GetAuthorBooksPage(author_id, after, limit);
+}
+
 std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> app::UseCasesImpl::ShowBook(std::string& book_name)
 {
     return books_.ShowBook(book_name);
 }
 
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> app::UseCasesImpl::ShowBooksDetails(const std::vector<std::string>& book_ids)
+{
+    return books_.ShowBooksDetails(book_ids);
+}
+
 void app::UseCasesImpl::DeleteBook(std::string& book_id)
 {
+    const IndexInvalidation invalidation{*indexes_};
     books_.DeleteBook(book_id);
 }
 
 void app::UseCasesImpl::EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id)
 {
-    books_.EditBook(title, publication_year, tags, id);
+    const IndexInvalidation invalidation{*indexes_};
+    books_.EditBook(title, publication_year, std::move(tags), id);
+}
+
+std::uint64_t app::UseCasesImpl::DeleteBooksByTag(const std::string& tag)
+{
+    const IndexInvalidation invalidation{*indexes_};
+    return books_.DeleteBooksByTag(tag);
+}
+
+std::uint64_t app::UseCasesImpl::RetagBooks(const std::string& from, const std::string& to)
+{
+    const IndexInvalidation invalidation{*indexes_};
+    return books_.RetagBooks(from, to);
+}
+
+std::uint64_t app::UseCasesImpl::DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year)
+{
+    const IndexInvalidation invalidation{*indexes_};
+    return books_.DeleteBooksByAuthorAndYearRange(author_id, min_year, max_year);
 }
 
 }  // namespace app
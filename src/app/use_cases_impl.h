@@ -1,7 +1,9 @@
 #pragma once
+#include <memory>
 #include <optional>
 #include "../domain/author_fwd.h"
 #include "../domain/book_fwd.h"
+#include "catalog_indexes.h"
 #include "use_cases.h"
 #include <set>
 #include <tuple>
@@ -10,9 +12,13 @@ namespace app {
 
 class UseCasesImpl : public UseCases {
 public:
-    explicit UseCasesImpl(domain::AuthorRepository& authors, domain::BookRepository& books)
+    // Use cases of executor workers share their indexes, so that a change made through one
+    // invalidates them for all
+    explicit UseCasesImpl(domain::AuthorRepository& authors, domain::BookRepository& books,
+                          std::shared_ptr<CatalogIndexes> indexes = std::make_shared<CatalogIndexes>())
         : authors_{authors},
-          books_{books}
+          books_{books},
+          indexes_{std::move(indexes)}
     {}
 
     void AddAuthor(const std::string& name) override;
@@ -20,15 +26,29 @@ public:
     void EditAuthor(std::string& new_name, std::string& old_name) override;
     void AddBook(int year, const std::string& title, domain::AuthorId id, std::optional<std::set<std::string>>) override;
     std::vector<domain::Author> GetAuthors() override;
+    domain::Stream<domain::Author> StreamAuthors() override;
     std::vector<std::tuple<std::string, std::string, int, std::string>> ShowBooks() override;
+    domain::Stream<std::tuple<std::string, std::string, int, std::string>> StreamBooks() override;
+    std::vector<std::tuple<std::string, std::string, int, std::string>> SearchBooks(const search::Query& query) override;
+    domain::CatalogStats GetCatalogStats(domain::StatsSource source) override;
+    std::vector<search::SimilarBook> SimilarBooks(const std::string& book_id, std::size_t k) override;
+    std::vector<search::DuplicateGroup> FindDuplicates() override;
     std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) override;
+    std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                 const std::optional<domain::AuthorBooksCursor>& after,
+                                                 std::size_t limit) override;
     std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBook(std::string& book_name) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBooksDetails(const std::vector<std::string>& book_ids) override;
     void DeleteBook(std::string& id) override;
     void EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) override;
+    std::uint64_t DeleteBooksByTag(const std::string& tag) override;
+    std::uint64_t RetagBooks(const std::string& from, const std::string& to) override;
+    std::uint64_t DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) override;
 
 private:
     domain::AuthorRepository& authors_;
     domain::BookRepository& books_;
+    std::shared_ptr<CatalogIndexes> indexes_;
 };
 
 }  // namespace app
@@ -1,21 +1,120 @@
 #include "bookypedia.h"
 
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 
+#include "menu/batch_io.h"
 #include "menu/menu.h"
 #include "postgres/postgres.h"
 #include "ui/view.h"
+#include "util/allocation_tracker.h"
+#include "util/mapped_file.h"
 
 namespace bookypedia {
 
 using namespace std::literals;
 
+namespace {
+
+std::unique_ptr<postgres::QueryTracer> MakeTracer(const AppConfig& config) {
+    if (!config.sql_trace_file) {
+        return nullptr;
+    }
+    postgres::QueryTracer::Config tracer_config;
+    tracer_config.output_file = *config.sql_trace_file;
+    tracer_config.slow_threshold = config.sql_slow_threshold;
+    return std::make_unique<postgres::QueryTracer>(std::move(tracer_config));
+}
+
+}  // namespace
+
+bool UsesSinglePostgres(const AppConfig& config) {
+    return !config.storage_path && !config.snapshot_path && config.shard_urls.empty();
+}
+
 Application::Application(const AppConfig& config)
-    : db_{pqxx::connection{config.db_url}} 
+    : config_{config}
+    , tracer_{MakeTracer(config)}
+    , db_{UsesSinglePostgres(config)
+          ? std::make_unique<postgres::Database>(pqxx::connection{config.db_url}, tracer_.get())
+          : nullptr}
+    , sharded_db_{!config.storage_path && !config.snapshot_path && !config.shard_urls.empty()
+          ? std::make_unique<postgres::ShardedDatabase>(config.shard_urls, config.connections_per_shard, tracer_.get())
+          : nullptr}
+    , local_db_{config.storage_path && !config.snapshot_path
+          ? std::make_unique<storage::Database>(storage::Catalog::Config{*config.storage_path})
+          : nullptr}
+    , snapshot_db_{config.snapshot_path
+          ? std::make_unique<storage::SnapshotDatabase>(*config.snapshot_path)
+          : nullptr}
 {}
 
+domain::AuthorRepository& Application::GetAuthorRepository() {
+    if (snapshot_db_) {
+        return snapshot_db_->GetAuthors();
+    }
+    if (local_db_) {
+        return local_db_->GetAuthors();
+    }
+    if (sharded_db_) {
+        return sharded_db_->GetAuthors();
+    }
+    return db_->GetAuthors();
+}
+
+domain::BookRepository& Application::GetBookRepository() {
+    if (snapshot_db_) {
+        return snapshot_db_->GetBooks();
+    }
+    if (local_db_) {
+        return local_db_->GetBooks();
+    }
+    if (sharded_db_) {
+        return sharded_db_->GetBooks();
+    }
+    return db_->GetBooks();
+}
+
 void Application::Run() {
+    if (config_.batch_script) {
+        RunBatch(*config_.batch_script);
+    } else {
+        RunInteractive();
+    }
+    WriteStatsFile();
+}
+
+void Application::RunInteractive() {
     menu::Menu menu{std::cin, std::cout};
+    AddSystemActions(menu, std::cout);
+
+    ui::View view{menu, instrumented_use_cases_, std::cin, std::cout, &prefetch_stats_};
+    menu.Run();
+}
+
+void Application::RunBatch(const std::string& script_path) {
+    util::MappedFile script{script_path};
+    menu::ScriptBuf script_buf{script.GetData()};
+    std::istream input{&script_buf};
+    menu::BufferedOutputBuf output_buf{stdout};
+    std::ostream output{&output_buf};
+
+    menu::Menu menu{input, output};
+    AddSystemActions(menu, output);
+    ui::View view{menu, instrumented_use_cases_, input, output, &prefetch_stats_};
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto commands = menu.RunBatch(script_buf);
+    output_buf.Flush();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cerr << commands << " commands in "sv << elapsed.count() << " s ("sv
+              << (elapsed.count() > 0 ? commands / elapsed.count() : 0.0) << " commands/s)"sv << std::endl;
+}
+
+void Application::AddSystemActions(menu::Menu& menu, std::ostream& output) {
     menu.AddAction("Help"s, {}, "Show instructions"s, [&menu](std::istream&) {
         menu.ShowInstructions();
         return true;
@@ -23,9 +122,27 @@ void Application::Run() {
     menu.AddAction("Exit"s, {}, "Exit program"s, [&menu](std::istream&) {
         return false;
     });
+    menu.AddAction("Stats"s, {}, "Show latency statistics of operations"s, [this, &output](std::istream&) {
+        instrumented_use_cases_.PrintStats(output);
+        prefetch_stats_.Print(output);
+        if constexpr (util::ALLOCATION_TRACKING_ENABLED) {
+            output << std::endl;
+            util::PrintAllocationStats(output);
+        }
+        return true;
+    });
+}
 
-    ui::View view{menu, use_cases_, std::cin, std::cout};
-    menu.Run();
+void Application::WriteStatsFile() const {
+    if (!config_.stats_file) {
+        return;
+    }
+    std::ofstream out{*config_.stats_file};
+    instrumented_use_cases_.WritePrometheus(out);
+    util::WriteAllocationPrometheus(out);
+    if (!out) {
+        throw std::runtime_error("Failed to write statistics to "s + *config_.stats_file);
+    }
 }
 
 }  // namespace bookypedia
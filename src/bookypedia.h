@@ -1,15 +1,47 @@
 #pragma once
+#include <chrono>
+#include <memory>
+#include <optional>
 #include <pqxx/pqxx>
+#include <string>
+#include <vector>
 
+#include "app/instrumented_use_cases.h"
 #include "app/use_cases_impl.h"
 #include "postgres/postgres.h"
+#include "postgres/sharded.h"
+#include "storage/snapshot.h"
+#include "storage/storage.h"
+#include "ui/view.h"
+
+namespace menu {
+class Menu;
+}
 
 namespace bookypedia {
 
 struct AppConfig {
     std::string db_url;
+    // Script replayed by the batch mode instead of reading commands from std::cin
+    std::optional<std::string> batch_script;
+    // File the use case statistics are written to on exit, in Prometheus text format
+    std::optional<std::string> stats_file;
+    // File SQL statement traces are appended to; tracing is off when not set
+    std::optional<std::string> sql_trace_file;
+    // SELECT statements running longer than this get their EXPLAIN plan traced
+    std::chrono::milliseconds sql_slow_threshold{100};
+    // When given, the catalog is split between these databases instead of living in db_url
+    std::vector<std::string> shard_urls;
+    std::size_t connections_per_shard = 1;
+    // When given, the catalog lives in this log file and Postgres is not used at all
+    std::optional<std::string> storage_path;
+    // When given, the catalog is served read-only from this snapshot written by bookypedia_snapshot
+    std::optional<std::string> snapshot_path;
 };
 
+// False when the catalog is sharded, kept in local storage or served from a snapshot
+bool UsesSinglePostgres(const AppConfig& config);
+
 class Application {
 public:
     explicit Application(const AppConfig& config);
@@ -17,8 +49,23 @@ public:
     void Run();
 
 private:
-    postgres::Database db_;
-    app::UseCasesImpl use_cases_{db_.GetAuthors(), db_.GetBooks()};
+    void RunInteractive();
+    void RunBatch(const std::string& script_path);
+    void AddSystemActions(menu::Menu& menu, std::ostream& output);
+    void WriteStatsFile() const;
+    domain::AuthorRepository& GetAuthorRepository();
+    domain::BookRepository& GetBookRepository();
+
+    AppConfig config_;
+    std::unique_ptr<postgres::QueryTracer> tracer_;
+    // Exactly one of them is set, depending on the configured backend
+    std::unique_ptr<postgres::Database> db_;
+    std::unique_ptr<postgres::ShardedDatabase> sharded_db_;
+    std::unique_ptr<storage::Database> local_db_;
+    std::unique_ptr<storage::SnapshotDatabase> snapshot_db_;
+    app::UseCasesImpl use_cases_{GetAuthorRepository(), GetBookRepository()};
+    app::InstrumentedUseCases instrumented_use_cases_{use_cases_};
+    ui::PrefetchStats prefetch_stats_;
 };
 
 }  // namespace bookypedia
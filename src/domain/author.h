@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 
+#include "stream.h"
 #include "../util/tagged_uuid.h"
 
 namespace domain {
@@ -36,6 +37,8 @@ class AuthorRepository {
 public:
     virtual void Save(const Author& author) = 0;
     virtual std::vector<domain::Author> GetAuthors() = 0;
+    // Same rows as GetAuthors, handed out a batch at a time
+    virtual Stream<domain::Author> StreamAuthors() = 0;
     virtual void Delete(std::string& name) = 0;
     virtual void Edit(std::string& new_name, std::string& old_name) = 0;
 
@@ -4,4 +4,41 @@
 
 namespace domain {
 
+std::set<std::string> TagBatch::Get(const std::string& book_id) {
+    std::lock_guard lock{mutex_};
+    if (!tags_) {
+        tags_ = loader_(book_ids_);
+        loader_ = nullptr;
+        book_ids_ = {};
+    }
+    const auto tags = tags_->find(book_id);
+    return tags != tags_->end() ? tags->second : std::set<std::string>{};
+}
+
+const std::optional<std::set<std::string>>& Book::GetTags() const {
+    if (tag_batch_) {
+        tags_ = tag_batch_->Get(b_id_.ToString());
+        tag_batch_.reset();
+    }
+    return tags_;
+}
+
+void LoadTagsLazily(std::vector<Book>& books, TagBatch::Loader loader) {
+    std::vector<std::string> book_ids;
+    for (const auto& book : books) {
+        if (!book.tags_) {
+            book_ids.push_back(book.b_id_.ToString());
+        }
+    }
+    if (book_ids.empty()) {
+        return;
+    }
+    const auto batch = std::make_shared<TagBatch>(std::move(book_ids), std::move(loader));
+    for (auto& book : books) {
+        if (!book.tags_) {
+            book.tag_batch_ = batch;
+        }
+    }
+}
+
 }  // namespace domain
\ No newline at end of file
@@ -1,10 +1,17 @@
 #pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <optional>
 #include <set>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include "author.h"
+#include "catalog_stats.h"
+#include "stream.h"
 #include "../util/tagged_uuid.h"
 
 namespace domain {
@@ -15,6 +22,35 @@ namespace domain {
 
     using BookId = util::TaggedUUID<detail::BookTag>;
 
+    /**
+     * Tags of the books of one result, which are not read with the books but loaded for all
+     * of them at once, by the loader, when the tags of any of them are first asked for.
+     * The books share the batch, so a list pays for one query whichever books it shows the tags of,
+     * and nothing if it shows none. Only for results whose callers may not show the tags; those
+     * that always do read them with the books instead. The loader may use the repository's connection,
+     * so the tags have to be asked for while the repository exists, on the thread that read the books.
+     */
+    class TagBatch {
+    public:
+        // Tags by book id; books without tags may be left out
+        using Tags = std::unordered_map<std::string, std::set<std::string>>;
+        using Loader = std::function<Tags(const std::vector<std::string>& book_ids)>;
+
+        TagBatch(std::vector<std::string> book_ids, Loader loader)
+            : book_ids_(std::move(book_ids)),
+              loader_(std::move(loader))
+        {}
+
+        // Tags of one of the books; the first call loads those of the whole batch
+        std::set<std::string> Get(const std::string& book_id);
+
+    private:
+        std::mutex mutex_;
+        std::vector<std::string> book_ids_;
+        Loader loader_;
+        std::optional<Tags> tags_;
+    };
+
     class Book {
     public:
         Book(BookId id, AuthorId a_id, std::string title, int year, std::optional<std::set<std::string>> tags)
@@ -41,26 +77,59 @@ namespace domain {
             return publication_year_;
         }
 
-        const std::optional<std::set<std::string>>& GetTags() const noexcept {
-            return tags_;
-        }
+        // Loads the tags of the book's batch on the first call if they are loaded lazily;
+        // not to be called concurrently on the same book
+        const std::optional<std::set<std::string>>& GetTags() const;
 
     private:
+        friend void LoadTagsLazily(std::vector<Book>& books, TagBatch::Loader loader);
+
         BookId b_id_;
         AuthorId a_id_;
         std::string title_;
         int publication_year_;
-        std::optional<std::set<std::string>> tags_;
+        mutable std::optional<std::set<std::string>> tags_;
+        mutable std::shared_ptr<TagBatch> tag_batch_;
+    };
+
+    // Makes the books of a result load their tags as one batch, with the loader, when first asked for.
+    // Books that have their tags already keep them; those of another batch are moved to the new one.
+    void LoadTagsLazily(std::vector<Book>& books, TagBatch::Loader loader);
+
+    // Books of an author are listed by publication year, title and id; a page of them
+    // starts after the book with the cursor's keys, which is the last one of the previous page
+    struct AuthorBooksCursor {
+        int publication_year;
+        std::string title;
+        std::string book_id;
     };
 
     class BookRepository {
     public:
         virtual void Save(const Book& book) = 0;
         virtual std::vector<std::tuple<std::string, std::string, int, std::string>> ShowBooks() = 0;
+        // Same rows as ShowBooks, handed out a batch at a time
+        virtual Stream<std::tuple<std::string, std::string, int, std::string>> StreamBooks() = 0;
+        // Every book, without its tags, grouped by author: the books of an author come one after
+        // another, by publication year and title. The order of the authors is up to the backend.
+        virtual Stream<domain::Book> StreamBooksByAuthor() = 0;
+        // The books of the author with their tags, which every caller shows, so they are read with the books
         virtual std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) = 0;
+        // Up to `limit` books of the author with their tags, from the first one or after the cursor
+        virtual std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                             const std::optional<AuthorBooksCursor>& after,
+                                                             std::size_t limit) = 0;
         virtual std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBook(std::string& book_name) = 0;
+        // Same as ShowBook for every one of the books, in one query
+        virtual std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBooksDetails(const std::vector<std::string>& book_ids) = 0;
         virtual void DeleteBook(std::string& book_id) = 0;
         virtual void EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) = 0;
+        virtual CatalogStats GetCatalogStats(StatsSource source) = 0;
+        // Bulk changes, each applied at once; they return the number of books changed
+        virtual std::uint64_t DeleteBooksByTag(const std::string& tag) = 0;
+        // Replaces the tag with another one in every book that has it
+        virtual std::uint64_t RetagBooks(const std::string& from, const std::string& to) = 0;
+        virtual std::uint64_t DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) = 0;
 
     protected:
         ~BookRepository() = default;
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace domain {
+
+enum class StatsSource {
+    // Counters kept up to date by every change; reading them does not depend on the catalog size
+    Summary,
+    // GROUP BY over the whole catalog, to check the counters against
+    FullRecompute,
+};
+
+// Book counts of the catalog. Every list is sorted by its key and has no zero counts.
+struct CatalogStats {
+    std::uint64_t books = 0;
+    std::vector<std::pair<std::string, std::uint64_t>> books_per_author;
+    std::vector<std::pair<std::string, std::uint64_t>> books_per_tag;
+    std::vector<std::pair<int, std::uint64_t>> books_per_year;
+
+    bool operator==(const CatalogStats&) const = default;
+};
+
+}  // namespace domain
@@ -0,0 +1,135 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace domain {
+
+/**
+ * Rows of a read handed out as they arrive rather than as one vector.
+ *
+ * The source produces the rows in batches, e.g. one FETCH from a server-side cursor,
+ * so the first row is available after the first batch and at most a batch is held
+ * at a time. A stream is an input range: it is iterated once, with range-for or
+ * std::ranges algorithms, and the source may keep backend resources until it ends.
+ */
+template <typename T>
+class Stream {
+public:
+    class Source {
+    public:
+        virtual ~Source() = default;
+        // Replaces the batch with the next rows; an empty batch ends the stream.
+        // The batch holds the rows of the previous one, so a source may assign over them
+        // and reuse the memory they hold instead of allocating it again.
+        virtual void FetchBatch(std::vector<T>& batch) = 0;
+    };
+
+    class Iterator {
+    public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        const T& operator*() const {
+            return stream_->batch_[stream_->position_];
+        }
+
+        const T* operator->() const {
+            return &**this;
+        }
+
+        Iterator& operator++() {
+            stream_->Advance();
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        friend bool operator==(const Iterator& it, std::default_sentinel_t) {
+            return it.IsEnd();
+        }
+
+    private:
+        friend class Stream;
+
+        bool IsEnd() const {
+            return stream_->position_ == stream_->batch_.size();
+        }
+
+        explicit Iterator(Stream* stream)
+            : stream_{stream} {
+        }
+
+        Stream* stream_ = nullptr;
+    };
+
+    explicit Stream(std::unique_ptr<Source> source)
+        : source_{std::move(source)} {
+    }
+
+    // Rows read in full already, for backends that hold them in memory anyway
+    static Stream FromVector(std::vector<T> rows) {
+        return Stream{std::make_unique<VectorSource>(std::move(rows))};
+    }
+
+    // Fetches the first batch; the stream can only be started once
+    Iterator begin() {
+        if (!started_) {
+            started_ = true;
+            Fetch();
+        }
+        return Iterator{this};
+    }
+
+    std::default_sentinel_t end() const noexcept {
+        return std::default_sentinel;
+    }
+
+private:
+    class VectorSource : public Source {
+    public:
+        explicit VectorSource(std::vector<T> rows)
+            : rows_{std::move(rows)} {
+        }
+
+        void FetchBatch(std::vector<T>& batch) override {
+            batch = std::move(rows_);
+            rows_.clear();
+        }
+
+    private:
+        std::vector<T> rows_;
+    };
+
+    void Advance() {
+        if (++position_ == batch_.size()) {
+            Fetch();
+        }
+    }
+
+    void Fetch() {
+        position_ = 0;
+        if (!source_) {
+            batch_.clear();
+            return;
+        }
+        source_->FetchBatch(batch_);
+        if (batch_.empty()) {
+            // Lets the source release what it holds as soon as the rows run out
+            source_.reset();
+        }
+    }
+
+    std::unique_ptr<Source> source_;
+    std::vector<T> batch_;
+    std::size_t position_ = 0;
+    bool started_ = false;
+};
+
+}  // namespace domain
@@ -0,0 +1,494 @@
+#include "api_handler.h"
+
+#include <boost/json.hpp>
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <set>
+#include <stdexcept>
+
+#include "../app/use_cases.h"
+
+namespace http_server {
+
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace {
+
+constexpr std::string_view AUTHORS_PATH = "/api/v1/authors"sv;
+constexpr std::string_view BOOKS_PATH = "/api/v1/books"sv;
+constexpr std::string_view BOOKS_SUFFIX = "/books"sv;
+constexpr std::string_view SEARCH_PATH = "/api/v1/books/search"sv;
+constexpr std::string_view SIMILAR_SUFFIX = "/similar"sv;
+constexpr std::string_view TAGS_PATH = "/api/v1/tags"sv;
+constexpr std::string_view STATS_PATH = "/api/v1/stats"sv;
+constexpr std::string_view DUPLICATES_PATH = "/api/v1/duplicates"sv;
+
+constexpr std::size_t DEFAULT_AUTHOR_BOOKS_PAGE_SIZE = 100;
+constexpr std::size_t MAX_AUTHOR_BOOKS_PAGE_SIZE = 1000;
+constexpr std::size_t DEFAULT_SIMILAR_BOOKS_COUNT = 10;
+
+struct BadRequestError : std::invalid_argument {
+    using std::invalid_argument::invalid_argument;
+};
+
+StringResponse MakeResponse(const StringRequest& request, http::status status, std::string body) {
+    StringResponse response{status, request.version()};
+    response.set(http::field::content_type, "application/json");
+    response.set(http::field::cache_control, "no-cache");
+    response.keep_alive(request.keep_alive());
+    response.body() = std::move(body);
+    response.prepare_payload();
+    return response;
+}
+
+StringResponse MakeJsonResponse(const StringRequest& request, const json::value& value,
+                                http::status status = http::status::ok) {
+    return MakeResponse(request, status, json::serialize(value));
+}
+
+StringResponse MakeError(const StringRequest& request, http::status status, std::string_view code,
+                         std::string_view message) {
+    return MakeJsonResponse(request, json::object{{"code", code}, {"message", message}}, status);
+}
+
+StringResponse MakeMethodNotAllowed(const StringRequest& request, std::string_view allow) {
+    auto response = MakeError(request, http::status::method_not_allowed, "invalidMethod"sv, "Invalid method"sv);
+    response.set(http::field::allow, beast::string_view{allow.data(), allow.size()});
+    return response;
+}
+
+json::object ParseBody(const StringRequest& request) {
+    boost::system::error_code ec;
+    auto value = json::parse(request.body(), ec);
+    if (ec || !value.is_object()) {
+        throw BadRequestError{"Request body must be a JSON object"};
+    }
+    return std::move(value.as_object());
+}
+
+std::string GetString(const json::object& object, std::string_view key) {
+    const auto* value = object.if_contains(key);
+    if (!value || !value->is_string()) {
+        throw BadRequestError{"Field '"s + std::string{key} + "' must be a string"s};
+    }
+    return std::string{value->get_string()};
+}
+
+int GetInt(const json::object& object, std::string_view key) {
+    const auto* value = object.if_contains(key);
+    if (!value || !value->is_int64()) {
+        throw BadRequestError{"Field '"s + std::string{key} + "' must be an integer"s};
+    }
+    return static_cast<int>(value->get_int64());
+}
+
+domain::AuthorId GetAuthorId(const json::object& object) {
+    const auto id = GetString(object, "author_id"sv);
+    try {
+        return domain::AuthorId::FromString(id);
+    } catch (const std::exception&) {
+        throw BadRequestError{"Field 'author_id' must be a UUID"};
+    }
+}
+
+std::optional<std::set<std::string>> GetTags(const json::object& object) {
+    const auto* value = object.if_contains("tags"sv);
+    if (!value || value->is_null()) {
+        return std::nullopt;
+    }
+    if (!value->is_array()) {
+        throw BadRequestError{"Field 'tags' must be an array of strings"};
+    }
+    std::set<std::string> tags;
+    for (const auto& tag : value->get_array()) {
+        if (!tag.is_string()) {
+            throw BadRequestError{"Field 'tags' must be an array of strings"};
+        }
+        tags.emplace(tag.get_string());
+    }
+    return tags;
+}
+
+json::array TagsToJson(const std::set<std::string>& tags) {
+    json::array result;
+    for (const auto& tag : tags) {
+        result.emplace_back(tag);
+    }
+    return result;
+}
+
+// A row of ShowBook and ShowBooksDetails
+json::object BookDetailsToJson(const std::tuple<std::string, std::string, int, std::string, std::set<std::string>>& book) {
+    const auto& [title, author, year, id, tags] = book;
+    return json::object{{"id", id},
+                        {"title", title},
+                        {"author", author},
+                        {"publication_year", year},
+                        {"tags", TagsToJson(tags)}};
+}
+
+int FromHex(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    throw BadRequestError{"Invalid URL encoding"};
+}
+
+std::string UrlDecode(std::string_view text) {
+    std::string result;
+    result.reserve(text.size());
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '%') {
+            if (i + 2 >= text.size()) {
+                throw BadRequestError{"Invalid URL encoding"};
+            }
+            result.push_back(static_cast<char>(FromHex(text[i + 1]) * 16 + FromHex(text[i + 2])));
+            i += 2;
+        } else if (text[i] == '+') {
+            result.push_back(' ');
+        } else {
+            result.push_back(text[i]);
+        }
+    }
+    return result;
+}
+
+// Returns the decoded value of the parameter from the query part of the target
+std::optional<std::string> GetQueryParam(std::string_view query, std::string_view name) {
+    while (!query.empty()) {
+        const auto amp = query.find('&');
+        const auto param = query.substr(0, amp);
+        const auto eq = param.find('=');
+        if (param.substr(0, eq) == name) {
+            return UrlDecode(eq == std::string_view::npos ? std::string_view{} : param.substr(eq + 1));
+        }
+        query = amp == std::string_view::npos ? std::string_view{} : query.substr(amp + 1);
+    }
+    return std::nullopt;
+}
+
+// Returns the parameter as a number if it is in the query; throws if it is not one
+template <typename Int>
+std::optional<Int> GetIntQueryParam(std::string_view query, std::string_view name) {
+    const auto text = GetQueryParam(query, name);
+    if (!text) {
+        return std::nullopt;
+    }
+    Int value{};
+    const auto [end, ec] = std::from_chars(text->data(), text->data() + text->size(), value);
+    if (ec != std::errc{} || end != text->data() + text->size()) {
+        throw BadRequestError{"Parameter '"s + std::string{name} + "' must be an integer"s};
+    }
+    return value;
+}
+
+}  // namespace
+
+ApiHandler::ApiHandler(app::UseCases& use_cases)
+    : use_cases_{use_cases} {
+}
+
+StringResponse ApiHandler::operator()(StringRequest&& request) {
+    const std::string_view target{request.target().data(), request.target().size()};
+    const auto query_pos = target.find('?');
+    const auto path = target.substr(0, query_pos);
+    const auto query = query_pos == std::string_view::npos ? std::string_view{} : target.substr(query_pos + 1);
+
+    try {
+        if (path == AUTHORS_PATH) {
+            return HandleAuthors(request);
+        }
+        if (path.size() > AUTHORS_PATH.size() + BOOKS_SUFFIX.size() + 1
+            && path.substr(0, AUTHORS_PATH.size() + 1) == "/api/v1/authors/"sv
+            && path.substr(path.size() - BOOKS_SUFFIX.size()) == BOOKS_SUFFIX) {
+            const auto id_begin = AUTHORS_PATH.size() + 1;
+            return HandleAuthorBooks(request, path.substr(id_begin, path.size() - BOOKS_SUFFIX.size() - id_begin), query);
+        }
+        if (path == BOOKS_PATH) {
+            return HandleBooks(request, query);
+        }
+        if (path == SEARCH_PATH) {
+            return HandleSearch(request, query);
+        }
+        if (path.size() > BOOKS_PATH.size() + SIMILAR_SUFFIX.size() + 1
+            && path.substr(0, BOOKS_PATH.size() + 1) == "/api/v1/books/"sv
+            && path.substr(path.size() - SIMILAR_SUFFIX.size()) == SIMILAR_SUFFIX) {
+            const auto id_begin = BOOKS_PATH.size() + 1;
+            return HandleSimilarBooks(request, path.substr(id_begin, path.size() - SIMILAR_SUFFIX.size() - id_begin), query);
+        }
+        if (path.size() > BOOKS_PATH.size() + 1 && path.substr(0, BOOKS_PATH.size() + 1) == "/api/v1/books/"sv) {
+            return HandleBook(request, path.substr(BOOKS_PATH.size() + 1));
+        }
+        if (path == TAGS_PATH) {
+            return HandleTags(request);
+        }
+        if (path == STATS_PATH) {
+            return HandleStats(request, query);
+        }
+        if (path == DUPLICATES_PATH) {
+            return HandleDuplicates(request);
+        }
+        return MakeError(request, http::status::not_found, "notFound"sv, "Unknown API endpoint"sv);
+    } catch (const BadRequestError& e) {
+        return MakeError(request, http::status::bad_request, "badRequest"sv, e.what());
+    } catch (const std::exception& e) {
+        return MakeError(request, http::status::internal_server_error, "operationFailed"sv, e.what());
+    }
+}
+
+StringResponse ApiHandler::HandleAuthors(const StringRequest& request) {
+    switch (request.method()) {
+        case http::verb::get: {
+            json::array authors;
+            for (const auto& author : use_cases_.GetAuthors()) {
+                authors.emplace_back(json::object{{"id", author.GetId().ToString()}, {"name", author.GetName()}});
+            }
+            return MakeJsonResponse(request, authors);
+        }
+        case http::verb::post: {
+            const auto name = GetString(ParseBody(request), "name"sv);
+            use_cases_.AddAuthor(name);
+            return MakeJsonResponse(request, json::object{}, http::status::created);
+        }
+        case http::verb::put: {
+            const auto body = ParseBody(request);
+            auto name = GetString(body, "name"sv);
+            auto new_name = GetString(body, "new_name"sv);
+            use_cases_.EditAuthor(new_name, name);
+            return MakeJsonResponse(request, json::object{});
+        }
+        case http::verb::delete_: {
+            auto name = GetString(ParseBody(request), "name"sv);
+            use_cases_.DeleteAuthor(name);
+            return MakeJsonResponse(request, json::object{});
+        }
+        default:
+            return MakeMethodNotAllowed(request, "GET, POST, PUT, DELETE"sv);
+    }
+}
+
+StringResponse ApiHandler::HandleAuthorBooks(const StringRequest& request, std::string_view author_id,
+                                             std::string_view query) {
+    const std::string id{author_id};
+    switch (request.method()) {
+        case http::verb::get: {
+            const auto limit = GetIntQueryParam<std::size_t>(query, "limit"sv).value_or(DEFAULT_AUTHOR_BOOKS_PAGE_SIZE);
+            if (limit == 0 || limit > MAX_AUTHOR_BOOKS_PAGE_SIZE) {
+                throw BadRequestError{"Parameter 'limit' must be from 1 to "s + std::to_string(MAX_AUTHOR_BOOKS_PAGE_SIZE)};
+            }
+            auto after_year = GetIntQueryParam<int>(query, "after_year"sv);
+            auto after_title = GetQueryParam(query, "after_title"sv);
+            auto after_id = GetQueryParam(query, "after_id"sv);
+            std::optional<domain::AuthorBooksCursor> after;
+            if (after_year && after_title && after_id) {
+                after = domain::AuthorBooksCursor{*after_year, std::move(*after_title), std::move(*after_id)};
+            } else if (after_year || after_title || after_id) {
+                throw BadRequestError{"Parameters 'after_year', 'after_title' and 'after_id' go together"};
+            }
+
+            json::array books;
+            for (const auto& book : use_cases_.GetAuthorBooksPage(id, after, limit)) {
+                books.emplace_back(json::object{{"id", book.GetBookId().ToString()},
+                                                {"title", book.GetTitle()},
+                                                {"publication_year", book.GetPublicationYear()},
+                                                {"tags", TagsToJson(book.GetTags().value_or(std::set<std::string>{}))}});
+            }
+            return MakeJsonResponse(request, books);
+        }
+        case http::verb::delete_: {
+            const auto min_year = GetIntQueryParam<int>(query, "min_year"sv).value_or(std::numeric_limits<int>::min());
+            const auto max_year = GetIntQueryParam<int>(query, "max_year"sv).value_or(std::numeric_limits<int>::max());
+            const auto changed = use_cases_.DeleteBooksByAuthorAndYearRange(id, min_year, max_year);
+            return MakeJsonResponse(request, json::object{{"changed", changed}});
+        }
+        default:
+            return MakeMethodNotAllowed(request, "GET, DELETE"sv);
+    }
+}
+
+StringResponse ApiHandler::HandleBooks(const StringRequest& request, std::string_view query) {
+    switch (request.method()) {
+        case http::verb::get: {
+            json::array books;
+            if (auto title = GetQueryParam(query, "title"sv)) {
+                for (const auto& book : use_cases_.ShowBook(*title)) {
+                    books.emplace_back(BookDetailsToJson(book));
+                }
+            } else if (const auto ids = GetQueryParam(query, "ids"sv)) {
+                std::vector<std::string> book_ids;
+                for (std::size_t start = 0; start <= ids->size();) {
+                    const auto comma = std::min(ids->find(',', start), ids->size());
+                    if (comma > start) {
+                        book_ids.push_back(ids->substr(start, comma - start));
+                    }
+                    start = comma + 1;
+                }
+                for (const auto& book : use_cases_.ShowBooksDetails(book_ids)) {
+                    books.emplace_back(BookDetailsToJson(book));
+                }
+            } else {
+                for (const auto& [title, author, year, id] : use_cases_.ShowBooks()) {
+                    books.emplace_back(json::object{{"id", id},
+                                                    {"title", title},
+                                                    {"author", author},
+                                                    {"publication_year", year}});
+                }
+            }
+            return MakeJsonResponse(request, books);
+        }
+        case http::verb::post: {
+            const auto body = ParseBody(request);
+            const auto title = GetString(body, "title"sv);
+            const auto year = GetInt(body, "publication_year"sv);
+            const auto author_id = GetAuthorId(body);
+            auto tags = GetTags(body);
+            use_cases_.AddBook(year, title, author_id, std::move(tags));
+            return MakeJsonResponse(request, json::object{}, http::status::created);
+        }
+        case http::verb::delete_: {
+            const auto tag = GetQueryParam(query, "tag"sv);
+            if (!tag) {
+                throw BadRequestError{"Parameter 'tag' is required"};
+            }
+            const auto changed = use_cases_.DeleteBooksByTag(*tag);
+            return MakeJsonResponse(request, json::object{{"changed", changed}});
+        }
+        default:
+            return MakeMethodNotAllowed(request, "GET, POST, DELETE"sv);
+    }
+}
+
+StringResponse ApiHandler::HandleSearch(const StringRequest& request, std::string_view query) {
+    if (request.method() != http::verb::get) {
+        return MakeMethodNotAllowed(request, "GET"sv);
+    }
+    search::Query search;
+    search.title_contains = GetQueryParam(query, "title"sv).value_or(std::string{});
+    search.author_contains = GetQueryParam(query, "author"sv).value_or(std::string{});
+    search.min_year = GetIntQueryParam<int>(query, "min_year"sv);
+    search.max_year = GetIntQueryParam<int>(query, "max_year"sv);
+    json::array books;
+    for (const auto& [title, author, year, id] : use_cases_.SearchBooks(search)) {
+        books.emplace_back(json::object{{"id", id},
+                                        {"title", title},
+                                        {"author", author},
+                                        {"publication_year", year}});
+    }
+    return MakeJsonResponse(request, books);
+}
+
+StringResponse ApiHandler::HandleBook(const StringRequest& request, std::string_view book_id) {
+    std::string id{book_id};
+    switch (request.method()) {
+        case http::verb::get: {
+            const auto books = use_cases_.ShowBooksDetails({id});
+            if (books.empty()) {
+                return MakeError(request, http::status::not_found, "bookNotFound"sv, "Book not found"sv);
+            }
+            return MakeJsonResponse(request, BookDetailsToJson(books.front()));
+        }
+        case http::verb::put: {
+            const auto body = ParseBody(request);
+            auto title = GetString(body, "title"sv);
+            const auto year = GetInt(body, "publication_year"sv);
+            auto tags = GetTags(body).value_or(std::set<std::string>{});
+            use_cases_.EditBook(title, year, std::move(tags), id);
+            return MakeJsonResponse(request, json::object{});
+        }
+        case http::verb::delete_: {
+            use_cases_.DeleteBook(id);
+            return MakeJsonResponse(request, json::object{});
+        }
+        default:
+            return MakeMethodNotAllowed(request, "GET, PUT, DELETE"sv);
+    }
+}
+
+StringResponse ApiHandler::HandleSimilarBooks(const StringRequest& request, std::string_view book_id,
+                                              std::string_view query) {
+    if (request.method() != http::verb::get) {
+        return MakeMethodNotAllowed(request, "GET"sv);
+    }
+    const auto k = GetIntQueryParam<std::size_t>(query, "k"sv).value_or(DEFAULT_SIMILAR_BOOKS_COUNT);
+    std::vector<search::SimilarBook> similar;
+    try {
+        similar = use_cases_.SimilarBooks(std::string{book_id}, k);
+    } catch (const std::out_of_range&) {
+        return MakeError(request, http::status::not_found, "bookNotFound"sv, "Book not found"sv);
+    }
+    json::array books;
+    for (const auto& book : similar) {
+        books.emplace_back(json::object{{"id", book.id},
+                                        {"title", book.title},
+                                        {"author", book.author},
+                                        {"publication_year", book.publication_year},
+                                        {"similarity", book.similarity}});
+    }
+    return MakeJsonResponse(request, books);
+}
+
+StringResponse ApiHandler::HandleTags(const StringRequest& request) {
+    if (request.method() != http::verb::put) {
+        return MakeMethodNotAllowed(request, "PUT"sv);
+    }
+    const auto body = ParseBody(request);
+    const auto name = GetString(body, "name"sv);
+    const auto new_name = GetString(body, "new_name"sv);
+    const auto changed = use_cases_.RetagBooks(name, new_name);
+    return MakeJsonResponse(request, json::object{{"changed", changed}});
+}
+
+StringResponse ApiHandler::HandleStats(const StringRequest& request, std::string_view query) {
+    if (request.method() != http::verb::get) {
+        return MakeMethodNotAllowed(request, "GET"sv);
+    }
+    auto source = domain::StatsSource::Summary;
+    if (const auto name = GetQueryParam(query, "source"sv)) {
+        if (*name == "full"sv) {
+            source = domain::StatsSource::FullRecompute;
+        } else if (*name != "summary"sv) {
+            throw BadRequestError{"Parameter 'source' must be 'summary' or 'full'"};
+        }
+    }
+    const auto stats = use_cases_.GetCatalogStats(source);
+    const auto counts = [](const auto& pairs) {
+        json::array result;
+        for (const auto& [key, books] : pairs) {
+            result.emplace_back(json::object{{"key", key}, {"books", books}});
+        }
+        return result;
+    };
+    return MakeJsonResponse(request, json::object{{"books", stats.books},
+                                                  {"books_per_author", counts(stats.books_per_author)},
+                                                  {"books_per_tag", counts(stats.books_per_tag)},
+                                                  {"books_per_year", counts(stats.books_per_year)}});
+}
+
+StringResponse ApiHandler::HandleDuplicates(const StringRequest& request) {
+    if (request.method() != http::verb::get) {
+        return MakeMethodNotAllowed(request, "GET"sv);
+    }
+    json::array groups;
+    for (const auto& group : use_cases_.FindDuplicates()) {
+        json::array books;
+        for (const auto& book : group.books) {
+            books.emplace_back(json::object{{"id", book.id},
+                                            {"title", book.title},
+                                            {"publication_year", book.publication_year}});
+        }
+        groups.emplace_back(json::object{{"author_id", group.author_id},
+                                         {"author", group.author},
+                                         {"books", std::move(books)}});
+    }
+    return MakeJsonResponse(request, groups);
+}
+
+}  // namespace http_server
@@ -0,0 +1,66 @@
+#pragma once
+#include <string_view>
+
+#include "server.h"
+
+namespace app {
+class UseCases;
+}
+
+namespace http_server {
+
+// REST front end of app::UseCases. Request and response bodies are JSON.
+//
+//  GET    /api/v1/authors                    list of authors
+//  POST   /api/v1/authors                    {"name"} adds an author
+//  PUT    /api/v1/authors                    {"name", "new_name"} renames an author
+//  DELETE /api/v1/authors                    {"name"} deletes an author with all their books
+//  GET    /api/v1/authors/<author_id>/books  a page of the author's books, including tags;
+//                                            ?limit=<n> (100 by default, at most 1000), and for the
+//                                            next pages ?after_year=&after_title=&after_id= of the
+//                                            last book of the previous one; a shorter page is the last
+//  DELETE /api/v1/authors/<author_id>/books  deletes the author's books, ?min_year=&max_year= for a range
+//  GET    /api/v1/books                      list of all books
+//  GET    /api/v1/books?title=<title>        books with the given title, including tags
+//  GET    /api/v1/books?ids=<id>,<id>...     the books with the given ids, including tags
+//  POST   /api/v1/books                      {"title", "publication_year", "author_id", "tags"} adds a book
+//  DELETE /api/v1/books?tag=<tag>            deletes the books with the tag
+//  GET    /api/v1/books/search               ?title=&author= parts of the title and author name,
+//                                            ?min_year=&max_year=; books matching all of those given
+//  GET    /api/v1/books/<book_id>            the book, including tags
+//  PUT    /api/v1/books/<book_id>            {"title", "publication_year", "tags"} edits a book
+//  DELETE /api/v1/books/<book_id>            deletes a book
+//  GET    /api/v1/books/<book_id>/similar    ?k=<n> (10 by default) books sharing the most tags with it
+//  PUT    /api/v1/tags                       {"name", "new_name"} renames a tag on every book
+//  GET    /api/v1/stats                      book counts per author, tag and year;
+//                                            ?source=full recomputes them over the whole catalog
+//  GET    /api/v1/duplicates                 groups of books of an author with near-identical titles
+//
+// Bulk deletes and renames respond with {"changed": <number of books>}.
+//
+// The use cases are called from all I/O threads concurrently, e.g. app::BlockingUseCases.
+class ApiHandler {
+public:
+    explicit ApiHandler(app::UseCases& use_cases);
+
+    ApiHandler(const ApiHandler&) = delete;
+    ApiHandler& operator=(const ApiHandler&) = delete;
+
+    StringResponse operator()(StringRequest&& request);
+
+private:
+    StringResponse HandleAuthors(const StringRequest& request);
+    StringResponse HandleAuthorBooks(const StringRequest& request, std::string_view author_id, std::string_view query);
+    StringResponse HandleBooks(const StringRequest& request, std::string_view query);
+    StringResponse HandleSearch(const StringRequest& request, std::string_view query);
+    StringResponse HandleBook(const StringRequest& request, std::string_view book_id);
+    StringResponse HandleSimilarBooks(const StringRequest& request, std::string_view book_id, std::string_view query);
+    StringResponse HandleTags(const StringRequest& request);
+    StringResponse HandleStats(const StringRequest& request, std::string_view query);
+    StringResponse HandleDuplicates(const StringRequest& request);
+
+    // Called from all I/O threads at once, so it must be thread-safe
+    app::UseCases& use_cases_;
+};
+
+}  // namespace http_server
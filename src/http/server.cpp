@@ -0,0 +1,102 @@
+#include "server.h"
+
+#include <boost/asio/strand.hpp>
+#include <chrono>
+#include <iostream>
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+void ReportError(beast::error_code ec, std::string_view what) {
+    std::cerr << what << ": "sv << ec.message() << std::endl;
+}
+
+}  // namespace
+
+Session::Session(tcp::socket&& socket, const RequestHandler& handler)
+    : stream_{std::move(socket)}
+    , handler_{handler} {
+}
+
+void Session::Run() {
+    // All handlers of the session run on its strand, one at a time
+    net::dispatch(stream_.get_executor(), beast::bind_front_handler(&Session::Read, shared_from_this()));
+}
+
+void Session::Read() {
+    request_ = {};
+    stream_.expires_after(30s);
+    http::async_read(stream_, buffer_, request_,
+                     beast::bind_front_handler(&Session::OnRead, shared_from_this()));
+}
+
+void Session::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+    if (ec == http::error::end_of_stream) {
+        return Close();
+    }
+    if (ec) {
+        if (ec != beast::error::timeout) {
+            ReportError(ec, "read"sv);
+        }
+        return;
+    }
+    Write(handler_(std::move(request_)));
+}
+
+void Session::Write(StringResponse&& response) {
+    auto safe_response = std::make_shared<StringResponse>(std::move(response));
+    const bool close = safe_response->need_eof();
+    http::async_write(stream_, *safe_response,
+                      [self = shared_from_this(), safe_response, close](beast::error_code ec, std::size_t bytes_written) {
+                          self->OnWrite(close, ec, bytes_written);
+                      });
+}
+
+void Session::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    if (ec) {
+        return ReportError(ec, "write"sv);
+    }
+    if (close) {
+        return Close();
+    }
+    Read();
+}
+
+void Session::Close() {
+    beast::error_code ec;
+    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+}
+
+Listener::Listener(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler handler)
+    : ioc_{ioc}
+    , acceptor_{net::make_strand(ioc)}
+    , handler_{std::move(handler)} {
+    acceptor_.open(endpoint.protocol());
+    acceptor_.set_option(net::socket_base::reuse_address(true));
+    acceptor_.bind(endpoint);
+    acceptor_.listen(net::socket_base::max_listen_connections);
+}
+
+void Listener::Run() {
+    Accept();
+}
+
+void Listener::Accept() {
+    // Every connection gets its own strand, so sessions are spread over all I/O threads
+    acceptor_.async_accept(net::make_strand(ioc_),
+                           beast::bind_front_handler(&Listener::OnAccept, shared_from_this()));
+}
+
+void Listener::OnAccept(beast::error_code ec, tcp::socket socket) {
+    if (ec) {
+        ReportError(ec, "accept"sv);
+    } else {
+        std::make_shared<Session>(std::move(socket), handler_)->Run();
+    }
+    Accept();
+}
+
+}  // namespace http_server
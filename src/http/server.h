@@ -0,0 +1,59 @@
+#pragma once
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <functional>
+#include <memory>
+
+namespace http_server {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = net::ip::tcp;
+
+using StringRequest = http::request<http::string_body>;
+using StringResponse = http::response<http::string_body>;
+
+// Called on one of the I/O threads, so it must be safe to call concurrently
+using RequestHandler = std::function<StringResponse(StringRequest&& request)>;
+
+// One client connection. Requests are read and answered strictly one after another,
+// so pipelined requests already sitting in the read buffer are served in order
+// and the connection is kept open for as long as the client asks for keep-alive.
+class Session : public std::enable_shared_from_this<Session> {
+public:
+    Session(tcp::socket&& socket, const RequestHandler& handler);
+
+    void Run();
+
+private:
+    void Read();
+    void OnRead(beast::error_code ec, std::size_t bytes_read);
+    void Write(StringResponse&& response);
+    void OnWrite(bool close, beast::error_code ec, std::size_t bytes_written);
+    void Close();
+
+    beast::tcp_stream stream_;
+    beast::flat_buffer buffer_;
+    StringRequest request_;
+    const RequestHandler& handler_;
+};
+
+class Listener : public std::enable_shared_from_this<Listener> {
+public:
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler handler);
+
+    void Run();
+
+private:
+    void Accept();
+    void OnAccept(beast::error_code ec, tcp::socket socket);
+
+    net::io_context& ioc_;
+    tcp::acceptor acceptor_;
+    RequestHandler handler_;
+};
+
+}  // namespace http_server
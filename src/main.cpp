@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
@@ -25,17 +26,61 @@ bookypedia::AppConfig GetConfigFromEnv()
     return config;
 }
 
+void ParseCommandLine(int argc, const char* argv[], bookypedia::AppConfig& config)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (argv[i] == "--batch"sv && i + 1 < argc)
+            config.batch_script = argv[++i];
+        else if (argv[i] == "--stats-file"sv && i + 1 < argc)
+            config.stats_file = argv[++i];
+        else if (argv[i] == "--trace-sql"sv && i + 1 < argc)
+            config.sql_trace_file = argv[++i];
+        else if (argv[i] == "--trace-slow-ms"sv && i + 1 < argc)
+            config.sql_slow_threshold = std::chrono::milliseconds{std::stoi(argv[++i])};
+        else if (argv[i] == "--shard"sv && i + 1 < argc)
+            config.shard_urls.push_back(argv[++i]);
+        else if (argv[i] == "--shard-connections"sv && i + 1 < argc)
+            config.connections_per_shard = std::max(1, std::stoi(argv[++i]));
+        else if (argv[i] == "--storage"sv && i + 1 < argc)
+            config.storage_path = argv[++i];
+        else if (argv[i] == "--snapshot"sv && i + 1 < argc)
+            config.snapshot_path = argv[++i];
+        else
+            throw std::invalid_argument("Usage: "s + argv[0]
+                + " [--batch <script file>] [--stats-file <file>] [--trace-sql <file>] [--trace-slow-ms <ms>]"s
+                + " [--shard <db url>]... [--shard-connections <n>] [--storage <log file>]"s
+                + " [--snapshot <snapshot file>]"s);
+    }
+}
+
 }  // namespace
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] const char* argv[]) {
+int main(int argc, const char* argv[]) {
     try 
     {
-        pqxx::connection conn(DB_URL_ENV_NAME);
-        pqxx::work w(conn);
-        w.exec("DROP TABLE authors, books, book_tags;"_zv);
-        w.commit();
+        auto config = GetConfigFromEnv();
+        ParseCommandLine(argc, argv, config);
+
+        if (bookypedia::UsesSinglePostgres(config))
+        {
+            pqxx::connection conn(DB_URL_ENV_NAME);
+            pqxx::work w(conn);
+            w.exec("DROP TABLE authors, books, book_tags;"_zv);
+            // The events of the dropped rows go too. The sequence goes on, so the offsets consumers
+            // keep stay valid, and the reset event tells them to drop what they derived.
+            if (w.query_value<bool>("SELECT to_regclass('catalog_events') IS NOT NULL;"_zv))
+            {
+                w.exec(R"(
+TRUNCATE catalog_events CONTINUE IDENTITY;
+INSERT INTO catalog_events (entity, entity_id, operation)
+VALUES ('catalog', '00000000-0000-0000-0000-000000000000', 'reset');
+)"_zv);
+            }
+            w.commit();
+        }
 
-        bookypedia::Application app{GetConfigFromEnv()};
+        bookypedia::Application app{config};
         app.Run();
     } 
     catch (const std::exception& e) 
@@ -0,0 +1,75 @@
+#include "batch_io.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace menu {
+
+ScriptBuf::ScriptBuf(std::string_view text) {
+    // The get area is never written to, so dropping const is safe here
+    char* begin = const_cast<char*>(text.data());
+    setg(begin, begin, begin + text.size());
+}
+
+std::optional<std::string_view> ScriptBuf::ReadLine() {
+    if (gptr() == egptr()) {
+        return std::nullopt;
+    }
+
+    char* begin = gptr();
+    const auto available = static_cast<std::size_t>(egptr() - begin);
+    char* end = static_cast<char*>(std::memchr(begin, '\n', available));
+    char* next = end ? end + 1 : egptr();
+    if (!end) {
+        end = egptr();
+    }
+    setg(eback(), next, egptr());
+
+    std::string_view line{begin, static_cast<std::size_t>(end - begin)};
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+BufferedOutputBuf::BufferedOutputBuf(std::FILE* file, std::size_t capacity)
+    : file_{file}
+    , buffer_{std::make_unique<char[]>(capacity)}
+    , capacity_{capacity} {
+    setp(buffer_.get(), buffer_.get() + capacity_);
+}
+
+BufferedOutputBuf::~BufferedOutputBuf() {
+    try {
+        Flush();
+    } catch (...) {
+    }
+}
+
+void BufferedOutputBuf::Flush() {
+    WriteBuffered();
+    std::fflush(file_);
+}
+
+BufferedOutputBuf::int_type BufferedOutputBuf::overflow(int_type ch) {
+    WriteBuffered();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int BufferedOutputBuf::sync() {
+    return 0;
+}
+
+void BufferedOutputBuf::WriteBuffered() {
+    const auto size = static_cast<std::size_t>(pptr() - pbase());
+    if (size != 0 && std::fwrite(pbase(), 1, size, file_) != size) {
+        throw std::runtime_error("Failed to write output");
+    }
+    setp(buffer_.get(), buffer_.get() + capacity_);
+}
+
+}  // namespace menu
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <streambuf>
+#include <string_view>
+
+namespace menu {
+
+// Input buffer over text owned by someone else (e.g. a mapped script file).
+// Reading through it never copies the text, and ReadLine hands out views
+// while keeping the buffer position shared with any std::istream using it.
+class ScriptBuf : public std::streambuf {
+public:
+    explicit ScriptBuf(std::string_view text);
+
+    // Returns the next line without the trailing "\n" or "\r\n", or nullopt at the end
+    std::optional<std::string_view> ReadLine();
+};
+
+// Output buffer that accumulates everything written to it and writes to the file
+// in large chunks. Flushes requested by std::endl are ignored: data leaves the buffer
+// only when it is full, on Flush() or on destruction.
+class BufferedOutputBuf : public std::streambuf {
+public:
+    explicit BufferedOutputBuf(std::FILE* file, std::size_t capacity = 1 << 20);
+    ~BufferedOutputBuf() override;
+
+    BufferedOutputBuf(const BufferedOutputBuf&) = delete;
+    BufferedOutputBuf& operator=(const BufferedOutputBuf&) = delete;
+
+    void Flush();
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+private:
+    void WriteBuffered();
+
+    std::FILE* file_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t capacity_;
+};
+
+}  // namespace menu
@@ -3,6 +3,9 @@
 #include <iomanip>
 #include <sstream>
 
+#include "../util/command_context.h"
+#include "batch_io.h"
+
 namespace menu {
 
 Menu::Menu(std::istream& input, std::ostream& output)
@@ -12,12 +15,12 @@ Menu::Menu(std::istream& input, std::ostream& output)
 
 void Menu::AddAction(std::string action_name, std::string args, std::string description,
                      Handler handler) {
-    if (!actions_
-             .try_emplace(std::move(action_name), std::move(handler), std::move(args),
-                          std::move(description))
-             .second) {
+    const auto [it, inserted] = actions_.try_emplace(std::move(action_name), std::move(handler),
+                                                     std::move(args), std::move(description));
+    if (!inserted) {
         throw std::invalid_argument("A command has been added already");
     }
+    dispatch_.emplace(it->first, &it->second);
 }
 
 void Menu::Run() {
@@ -30,6 +33,17 @@ void Menu::Run() {
     }
 }
 
+std::size_t Menu::RunBatch(ScriptBuf& script) {
+    std::size_t commands = 0;
+    while (const auto line = script.ReadLine()) {
+        ++commands;
+        if (!ExecuteLine(*line)) {
+            break;
+        }
+    }
+    return commands;
+}
+
 void Menu::ShowInstructions() const {
     if (actions_.empty()) {
         return;
@@ -70,6 +84,7 @@ bool Menu::ParseCommand(std::istream& input) {
         if (input >> cmd) {
             if (const auto it = actions_.find(cmd); it != actions_.cend()) 
             {
+                util::CommandScope scope{it->first};
                 if (!it->second.handler(input)) {
                     return false;
                 }
@@ -85,4 +100,39 @@ bool Menu::ParseCommand(std::istream& input) {
     return true;
 }
 
+bool Menu::ExecuteLine(std::string_view line) {
+    using namespace std::literals;
+
+    constexpr auto whitespace = " \t"sv;
+    const auto cmd_begin = line.find_first_not_of(whitespace);
+    if (cmd_begin == std::string_view::npos) {
+        output_ << "Invalid command"sv << std::endl;
+        return true;
+    }
+    line.remove_prefix(cmd_begin);
+
+    const auto cmd_end = std::min(line.find_first_of(whitespace), line.size());
+    const auto cmd = line.substr(0, cmd_end);
+    const auto it = dispatch_.find(cmd);
+    if (it == dispatch_.cend()) {
+        output_ << "Command '"sv << cmd << "' has not been found."sv << std::endl;
+        return true;
+    }
+
+    // Arguments are read by the handler straight from the script memory
+    ScriptBuf args_buf{line.substr(cmd_end)};
+    std::istream args{&args_buf};
+    util::CommandScope scope{it->first};
+    return Invoke(*it->second, args);
+}
+
+bool Menu::Invoke(const ActionInfo& action, std::istream& args) {
+    try {
+        return action.handler(args);
+    } catch (const std::exception& e) {
+        output_ << e.what() << std::endl;
+    }
+    return true;
+}
+
 }  // namespace menu
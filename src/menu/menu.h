@@ -3,9 +3,13 @@
 #include <iosfwd>
 #include <map>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace menu {
 
+class ScriptBuf;
+
 class Menu {
 public:
     using Handler = std::function<bool(std::istream&)>;
@@ -17,6 +21,11 @@ public:
 
     void Run();
 
+    // Replays commands from the script without copying its lines.
+    // Follow-up prompts of the commands read from the same script.
+    // Returns the number of executed commands
+    std::size_t RunBatch(ScriptBuf& script);
+
     void ShowInstructions() const;
 
 private:
@@ -27,10 +36,14 @@ private:
     };
 
     [[nodiscard]] bool ParseCommand(std::istream& input);
+    [[nodiscard]] bool ExecuteLine(std::string_view line);
+    [[nodiscard]] bool Invoke(const ActionInfo& action, std::istream& args);
 
     std::istream& input_;
     std::ostream& output_;
     std::map<std::string, ActionInfo> actions_;
+    // Keys refer to the names stored in actions_, whose nodes are never moved
+    std::unordered_map<std::string_view, const ActionInfo*> dispatch_;
 };
 
 }  // namespace menu
\ No newline at end of file
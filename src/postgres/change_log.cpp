@@ -0,0 +1,28 @@
+#include "change_log.h"
+
+#include <pqxx/pqxx>
+
+namespace postgres {
+
+using pqxx::operator"" _zv;
+
+std::vector<CatalogEvent> ChangeLogReader::ReadBatch(std::size_t max_events) {
+    std::vector<CatalogEvent> events;
+    pqxx::read_transaction read{connection_};
+    const auto rows = Exec(tracer_, read, R"(
+SELECT sequence, entity, entity_id, operation, COALESCE(changes::text, '')
+FROM catalog_events WHERE sequence > $1 ORDER BY sequence LIMIT $2;
+)"_zv, static_cast<std::int64_t>(offset_), static_cast<std::int64_t>(max_events));
+    events.reserve(rows.size());
+    for (auto [sequence, entity, entity_id, operation, changes] :
+         rows.iter<std::int64_t, std::string, std::string, std::string, std::string>()) {
+        events.push_back({static_cast<std::uint64_t>(sequence), std::move(entity), std::move(entity_id),
+                          std::move(operation), std::move(changes)});
+    }
+    if (!events.empty()) {
+        offset_ = events.back().sequence;
+    }
+    return events;
+}
+
+}  // namespace postgres
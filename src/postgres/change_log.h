@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <pqxx/connection>
+#include <string>
+#include <vector>
+
+#include "query_tracer.h"
+
+namespace postgres {
+
+// Change of one author or book, as appended to catalog_events by the repositories
+struct CatalogEvent {
+    // Grows with the commit order; gaps are left by rolled back transactions
+    std::uint64_t sequence = 0;
+    // "author" or "book", or "catalog" for the reset of the whole catalog
+    std::string entity;
+    // The nil UUID for the catalog
+    std::string entity_id;
+    // "insert", "update" or "delete"; "reset" for the catalog, after which it is empty
+    std::string operation;
+    // JSON object of the fields the change set, empty for deletions.
+    // Deleting an author deletes the author's books, and each of them gets its own event.
+    std::string changes;
+};
+
+/**
+ * Follows the change-data-capture log of the catalog.
+ *
+ * The reader starts after an offset, the sequence number of the last event its consumer
+ * has applied, and moves it forward batch by batch. A consumer that stores the offset
+ * with its derived state resumes where it stopped and sees every later change once.
+ * Each shard of a sharded catalog keeps its own log.
+ */
+class ChangeLogReader {
+public:
+    explicit ChangeLogReader(pqxx::connection& connection, std::uint64_t offset = 0, QueryTracer* tracer = nullptr)
+        : connection_{connection}
+        , offset_{offset}
+        , tracer_{tracer} {
+    }
+
+    // Up to max_events events committed after the offset, oldest first; the offset moves past them
+    std::vector<CatalogEvent> ReadBatch(std::size_t max_events);
+
+    std::uint64_t GetOffset() const noexcept {
+        return offset_;
+    }
+
+private:
+    pqxx::connection& connection_;
+    std::uint64_t offset_;
+    QueryTracer* tracer_;
+};
+
+}  // namespace postgres
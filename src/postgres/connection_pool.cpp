@@ -0,0 +1,38 @@
+#include "connection_pool.h"
+
+#include <algorithm>
+
+namespace postgres {
+
+ConnectionPool::ConnectionPool(const std::string& db_url, std::size_t size,
+                               const std::function<void(pqxx::connection&)>& setup) {
+    size = std::max<std::size_t>(size, 1);
+    free_.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        free_.push_back(std::make_unique<pqxx::connection>(db_url));
+        if (setup) {
+            setup(*free_.back());
+        }
+    }
+}
+
+ConnectionPool::Lease ConnectionPool::Acquire() {
+    std::unique_lock lock{mutex_};
+    connection_returned_.wait(lock, [this] {
+        return !free_.empty();
+    });
+    auto connection = std::move(free_.back());
+    free_.pop_back();
+    return {std::move(connection), *this};
+}
+
+void ConnectionPool::Return(std::unique_ptr<pqxx::connection> connection) noexcept {
+    {
+        std::lock_guard lock{mutex_};
+        // Capacity was reserved for all connections, so this does not allocate
+        free_.push_back(std::move(connection));
+    }
+    connection_returned_.notify_one();
+}
+
+}  // namespace postgres
@@ -0,0 +1,63 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <pqxx/connection>
+#include <string>
+#include <vector>
+
+namespace postgres {
+
+// Fixed number of connections to one database, opened up front.
+// Acquire() blocks until a connection is free.
+class ConnectionPool {
+public:
+    // Returns the connection to the pool when destroyed
+    class Lease {
+    public:
+        Lease(std::unique_ptr<pqxx::connection> connection, ConnectionPool& pool) noexcept
+            : connection_{std::move(connection)}
+            , pool_{&pool} {
+        }
+
+        Lease(Lease&&) = default;
+        Lease& operator=(Lease&&) = delete;
+
+        ~Lease() {
+            if (connection_) {
+                pool_->Return(std::move(connection_));
+            }
+        }
+
+        pqxx::connection& operator*() const noexcept {
+            return *connection_;
+        }
+
+        pqxx::connection* operator->() const noexcept {
+            return connection_.get();
+        }
+
+    private:
+        std::unique_ptr<pqxx::connection> connection_;
+        ConnectionPool* pool_;
+    };
+
+    // Runs setup on each connection once it is opened
+    ConnectionPool(const std::string& db_url, std::size_t size,
+                   const std::function<void(pqxx::connection&)>& setup = {});
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    Lease Acquire();
+
+private:
+    void Return(std::unique_ptr<pqxx::connection> connection) noexcept;
+
+    std::mutex mutex_;
+    std::condition_variable connection_returned_;
+    std::vector<std::unique_ptr<pqxx::connection>> free_;
+};
+
+}  // namespace postgres
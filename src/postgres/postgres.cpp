@@ -1,9 +1,12 @@
 #include "postgres.h"
+#include "typed_query.h"
 #include "../util/tagged_uuid.h"
 #include <pqxx/zview.hxx>
 #include <pqxx/pqxx>
 #include "../app/use_cases.h"
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <vector>
 #include <tuple>
@@ -13,36 +16,256 @@ namespace postgres {
 using namespace std::literals;
 using pqxx::operator"" _zv;
 
+namespace {
+
+// Every write appends its events to catalog_events in the same transaction. The exclusive lock,
+// held until commit, hands out event sequence numbers in commit order, so a reader that has seen
+// an event never misses one committed later with a smaller sequence number.
+// Writes lock the tables they change first, in the order authors, books, book_tags, and this
+// one last; a write holding it never waits for a data table another writer has locked.
+void LockChangeLog(QueryTracer* tracer, pqxx::transaction_base& work)
+{
+    Exec(tracer, work, "LOCK TABLE catalog_events IN EXCLUSIVE MODE"_zv);
+}
+
+// Tags are left out of the event when the write leaves them as they are
+void AppendBookEvent(QueryTracer* tracer, pqxx::transaction_base& work, std::string_view operation,
+                     const std::string& book_id, const std::string* author_id, const std::string& title,
+                     int publication_year, const std::set<std::string>* tags)
+{
+    std::optional<std::vector<std::string>> tag_list;
+    if (tags)
+        tag_list.emplace(tags->begin(), tags->end());
+    Exec(tracer, work, R"(
+INSERT INTO catalog_events (entity, entity_id, operation, changes)
+VALUES ('book', $1, $2, jsonb_strip_nulls(jsonb_build_object(
+    'author_id', $3::uuid, 'title', $4::text, 'publication_year', $5::integer, 'tags', $6::text[])))
+)"_zv, book_id, operation, author_id ? std::optional<std::string>{*author_id} : std::nullopt, title, publication_year, tag_list);
+}
+
+using BookRow = std::tuple<std::string, std::string, int, std::string>;
+using BookDetails = std::tuple<std::string, std::string, int, std::string, std::set<std::string>>;
+// A row per tag of a book, or a single row with a NULL tag for a book without tags
+using BookTagRow = std::tuple<std::string, std::string, std::string, int, std::optional<std::string>>;
+
+// Lists are sorted bytewise whatever the database collation, as the storage backend sorts them,
+// and so that ShardedAuthorRepository and ShardedBookRepository can merge them bytewise
+using GetAuthorsQuery = Query<"SELECT id, name FROM authors ORDER BY name COLLATE \"C\";", domain::Author>;
+
+using ShowBooksQuery = Query<R"(
+SELECT books.title, authors.name, books.publication_year, books.id
+FROM authors, books WHERE authors.id=books.author_id
+ORDER BY books.title COLLATE "C" ASC, authors.name COLLATE "C" ASC, books.publication_year ASC;
+)", BookRow>;
+
+using AuthorBookRow = std::tuple<std::string, std::string, std::string, int, std::optional<std::string>>;
+
+// Books of an author come from books_author_idx in (publication_year, title, id) order,
+// which is the order of the pages and of the keys of the cursor
+using AuthorBooksQuery = Query<R"(
+SELECT b.id, b.author_id, b.title, b.publication_year, t.tag
+FROM books b
+LEFT JOIN book_tags t ON t.book_id = b.id
+WHERE b.author_id = $1
+ORDER BY b.publication_year, b.title, b.id;
+)", AuthorBookRow, Params<std::string>>;
+
+using FirstAuthorBooksPageQuery = Query<R"(
+SELECT b.id, b.author_id, b.title, b.publication_year, t.tag
+FROM (
+    SELECT id, author_id, title, publication_year FROM books
+    WHERE author_id = $1
+    ORDER BY publication_year, title, id
+    LIMIT $2
+) b
+LEFT JOIN book_tags t ON t.book_id = b.id
+ORDER BY b.publication_year, b.title, b.id;
+)", AuthorBookRow, Params<std::string, std::int64_t>>;
+
+using NextAuthorBooksPageQuery = Query<R"(
+SELECT b.id, b.author_id, b.title, b.publication_year, t.tag
+FROM (
+    SELECT id, author_id, title, publication_year FROM books
+    WHERE author_id = $1 AND (publication_year, title, id) > ($2, $3, $4::uuid)
+    ORDER BY publication_year, title, id
+    LIMIT $5
+) b
+LEFT JOIN book_tags t ON t.book_id = b.id
+ORDER BY b.publication_year, b.title, b.id;
+)", AuthorBookRow, Params<std::string, int, std::string, std::string, std::int64_t>>;
+
+// Every book in the order of books_author_idx, which groups them by author
+using BooksByAuthorQuery = Query<R"(
+SELECT id, author_id, title, publication_year FROM books
+ORDER BY author_id, publication_year, title, id;
+)", domain::Book>;
+
+using BookTagsByTitleQuery = Query<R"(
+SELECT books.id, books.title, authors.name, books.publication_year, book_tags.tag
+FROM books
+JOIN authors ON authors.id = books.author_id
+LEFT JOIN book_tags ON book_tags.book_id = books.id
+WHERE books.title = $1
+ORDER BY books.id;
+)", BookTagRow, Params<std::string>>;
+
+using BookTagsByIdQuery = Query<R"(
+SELECT books.id, books.title, authors.name, books.publication_year, book_tags.tag
+FROM books
+JOIN authors ON authors.id = books.author_id
+LEFT JOIN book_tags ON book_tags.book_id = books.id
+WHERE books.id = ANY($1::uuid[])
+ORDER BY books.id;
+)", BookTagRow, Params<std::vector<std::string>>>;
+
+// Folds the rows of a book into one, rows of a book must be adjacent
+std::vector<BookDetails> GroupBookTags(std::vector<BookTagRow> rows)
+{
+    std::vector<BookDetails> books;
+    for (auto& [id, title, name, year, tag] : rows)
+    {
+        if (books.empty() || std::get<3>(books.back()) != id)
+            books.emplace_back(std::move(title), std::move(name), year, std::move(id), std::set<std::string>{});
+        if (tag)
+            std::get<4>(books.back()).insert(std::move(*tag));
+    }
+    return books;
+}
+
+// Makes a book with its tags of the rows of each book, which must be adjacent
+std::vector<domain::Book> GroupAuthorBooks(std::vector<AuthorBookRow> rows)
+{
+    std::vector<domain::Book> books;
+    for (auto first = rows.begin(); first != rows.end();)
+    {
+        std::set<std::string> tags;
+        auto last = first;
+        for (; last != rows.end() && std::get<0>(*last) == std::get<0>(*first); ++last)
+        {
+            if (auto& tag = std::get<4>(*last))
+                tags.insert(std::move(*tag));
+        }
+        auto& [id, author_id, title, year, tag] = *first;
+        books.emplace_back(domain::BookId::FromString(id), domain::AuthorId::FromString(author_id), std::move(title),
+                           year, std::move(tags));
+        first = last;
+    }
+    return books;
+}
+
+// Deletes the books the condition selects, with their tags and change events, in one statement
+template <typename... Args>
+std::uint64_t DeleteBooksWhere(QueryTracer* tracer, pqxx::transaction_base& work, std::string_view condition,
+                               const Args&... args)
+{
+    const auto query = R"(
+WITH deleted AS (DELETE FROM books WHERE )"s + std::string{condition} + R"( RETURNING id),
+deleted_tags AS (DELETE FROM book_tags WHERE book_id IN (SELECT id FROM deleted)),
+events AS (INSERT INTO catalog_events (entity, entity_id, operation) SELECT 'book', id, 'delete' FROM deleted)
+SELECT count(*) FROM deleted;
+)"s;
+    const pqxx::result rows = Exec(tracer, work, query, args...);
+    return rows.one_row()[0].as<std::uint64_t>();
+}
+
+void LockForSaveAuthor(QueryTracer* tracer, pqxx::transaction_base& work)
+{
+    Exec(tracer, work, "LOCK table authors"_zv);
+    LockChangeLog(tracer, work);
+}
+
+// Statements of AuthorRepositoryImpl::Save, in the caller's transaction or a savepoint of a batch.
+// The locks are taken already, by LockForSaveAuthor or by the batch.
+void SaveAuthor(QueryTracer* tracer, pqxx::transaction_base& work, const domain::Author& author)
+{
+    // xmax is zero only in a row version that the statement inserted
+    const bool inserted = Exec(tracer, work, 
+        R"(
+INSERT INTO authors (id, name) VALUES ($1, $2)
+ON CONFLICT (id) DO UPDATE SET name=$2
+RETURNING xmax = 0
+)"_zv,
+        author.GetId().ToString(), author.GetName()).one_row()[0].as<bool>();
+    Exec(tracer, work, R"(
+INSERT INTO catalog_events (entity, entity_id, operation, changes)
+VALUES ('author', $1, $2, jsonb_build_object('name', $3::text))
+)"_zv, author.GetId().ToString(), inserted ? "insert"sv : "update"sv, author.GetName());
+}
+
+void LockForSaveBook(QueryTracer* tracer, pqxx::transaction_base& work, const domain::Book& book)
+{
+    if (!book.GetTags().has_value())
+    {
+        // The lock the upsert takes anyway, taken before the change log's; readers are not blocked
+        Exec(tracer, work, "LOCK TABLE books IN ROW EXCLUSIVE MODE"_zv);
+    }
+    else
+    {
+        Exec(tracer, work, "LOCK TABLE books, book_tags"_zv);
+    }
+    LockChangeLog(tracer, work);
+}
+
+// Statements of BookRepositoryImpl::Save, in the caller's transaction or a savepoint of a batch.
+// The locks are taken already, by LockForSaveBook or by the batch.
+void SaveBook(QueryTracer* tracer, pqxx::transaction_base& work, const domain::Book& book)
+{
+    const auto book_id = book.GetBookId().ToString();
+    const auto author_id = book.GetAuthorId().ToString();
+    if (!book.GetTags().has_value())
+    {
+        const bool inserted = Exec(tracer, work, 
+            R"(
+INSERT INTO books (id, author_id, title, publication_year) VALUES ($1, $2, $3, $4)
+ON CONFLICT (id) DO UPDATE SET author_id=$2, title=$3, publication_year=$4
+RETURNING xmax = 0;
+)"_zv,
+book_id, author_id, book.GetTitle(), book.GetPublicationYear()).one_row()[0].as<bool>();
+        AppendBookEvent(tracer, work, inserted ? "insert"sv : "update"sv, book_id, &author_id, book.GetTitle(),
+                        book.GetPublicationYear(), nullptr);
+        return;
+    }
+
+    Exec(tracer, work, 
+        R"(
+INSERT INTO books (id, author_id, title, publication_year) VALUES ($1, $2, $3, $4)
+)"_zv,
+book_id, author_id, book.GetTitle(), book.GetPublicationYear());
+
+    const auto& tags = *book.GetTags();
+    Exec(tracer, work, "INSERT INTO book_tags (book_id, tag) SELECT $1::uuid, unnest($2::varchar[])"_zv,
+         book_id, std::vector<std::string>{tags.begin(), tags.end()});
+    AppendBookEvent(tracer, work, "insert"sv, book_id, &author_id, book.GetTitle(), book.GetPublicationYear(), &tags);
+}
+
+}  // namespace
+
 void AuthorRepositoryImpl::Save(const domain::Author& author) {
     // Пока каждое обращение к репозиторию выполняется внутри отдельной транзакции
     // В будущих уроках вы узнаете про паттерн Unit of Work, при помощи которого сможете несколько
     // запросов выполнить в рамках одной транзакции.
     // Вы также может самостоятельно почитать информацию про этот паттерн и применить его здесь.
+    if (batcher_) {
+        batcher_->Submit([tracer = tracer_, author](pqxx::transaction_base& work) {
+            SaveAuthor(tracer, work, author);
+        }).get();
+        return;
+    }
     pqxx::work work{connection_};
-    work.exec("BEGIN;");
-    work.exec("LOCK table authors");
-    work.exec_params(
-        R"(
-INSERT INTO authors (id, name) VALUES ($1, $2)
-ON CONFLICT (id) DO UPDATE SET name=$2
-)"_zv,
-        author.GetId().ToString(), author.GetName());
-    work.exec("END;");
+    LockForSaveAuthor(tracer_, work);
+    SaveAuthor(tracer_, work, author);
     work.commit();
 }
 
 std::vector<domain::Author> postgres::AuthorRepositoryImpl::GetAuthors()
 {
-    std::vector<domain::Author> authors;
     pqxx::read_transaction r{ connection_ };
+    return Fetch<GetAuthorsQuery>(tracer_, r);
+}
 
-    for (const auto& [id, name] : r.query<std::string, std::string>("SELECT id, name FROM authors ORDER BY name;"_zv))
-    {
-        auto author_id_t = util::TaggedUUID<domain::detail::AuthorTag>::FromString(id);
-        authors.emplace_back(author_id_t, name);
-    }
-
-    return authors;
+domain::Stream<domain::Author> postgres::AuthorRepositoryImpl::StreamAuthors()
+{
+    return StreamRows<GetAuthorsQuery>(connection_, tracer_);
 }
 
 void postgres::AuthorRepositoryImpl::Delete(std::string& name)
@@ -50,146 +273,130 @@ void postgres::AuthorRepositoryImpl::Delete(std::string& name)
     //pqxx::read_transaction{ connection_ };
     pqxx::work work{ connection_ };
     std::vector<std::string> books_id;
-    work.exec("BEGIN;");
-    work.exec("LOCK TABLE authors, books, book_tags");
-    std::string author_id = work.query_value<std::string>("SELECT id FROM authors WHERE name = " + work.quote(name));
+    Exec(tracer_, work, "BEGIN;");
+    Exec(tracer_, work, "LOCK TABLE authors, books, book_tags");
+    LockChangeLog(tracer_, work);
+    std::string author_id = Exec(tracer_, work, "SELECT id FROM authors WHERE name = $1"_zv, name).one_row()[0].as<std::string>();
 
     if (author_id.empty())
         throw std::runtime_error("");
 
-    work.exec("DELETE FROM authors WHERE id = " + work.quote(author_id));
-    for (auto [book_id] : work.query<std::string>("SELECT id FROM books WHERE author_id = " + work.quote(author_id)))
+    // The author's books go with the author, each gets an event of its own
+    Exec(tracer_, work, R"(
+INSERT INTO catalog_events (entity, entity_id, operation)
+SELECT 'book', id, 'delete' FROM books WHERE author_id = $1 ORDER BY id
+)"_zv, author_id);
+    Exec(tracer_, work, "INSERT INTO catalog_events (entity, entity_id, operation) VALUES ('author', $1, 'delete')"_zv, author_id);
+
+    Exec(tracer_, work, "DELETE FROM authors WHERE id = $1"_zv, author_id);
+    const auto book_rows = Exec(tracer_, work, "SELECT id FROM books WHERE author_id = $1"_zv, author_id);
+    for (auto [book_id] : book_rows.iter<std::string>())
     {
         books_id.push_back(book_id);
     }
 
-    work.exec("DELETE FROM books WHERE author_id = " + work.quote(author_id));
+    Exec(tracer_, work, "DELETE FROM books WHERE author_id = $1"_zv, author_id);
 
     for (const auto& book_id : books_id)
     {
-        work.exec("DELETE FROM book_tags WHERE book_id = " + work.quote(book_id));
+        Exec(tracer_, work, "DELETE FROM book_tags WHERE book_id = $1"_zv, book_id);
     }
 
-    work.exec("END;");
+    Exec(tracer_, work, "END;");
     work.commit();
 }
 
 void postgres::AuthorRepositoryImpl::Edit(std::string& new_name, std::string& old_name)
 {
     pqxx::work work{ connection_ };
-    work.exec("BEGIN;");
-    work.exec("LOCK TABLE authors");
-    std::string author_id = work.query_value<std::string>("SELECT id FROM authors WHERE name = " + work.quote(old_name));
+    Exec(tracer_, work, "BEGIN;");
+    Exec(tracer_, work, "LOCK TABLE authors");
+    LockChangeLog(tracer_, work);
+    std::string author_id = Exec(tracer_, work, "SELECT id FROM authors WHERE name = $1"_zv, old_name).one_row()[0].as<std::string>();
     if (author_id.empty())
         throw std::runtime_error("");
 
-    work.exec("UPDATE authors SET name =" + work.quote(new_name) + " WHERE name = " + work.quote(old_name));
-    work.exec("END;");
+    Exec(tracer_, work, "UPDATE authors SET name = $1 WHERE name = $2"_zv, new_name, old_name);
+    Exec(tracer_, work, R"(
+INSERT INTO catalog_events (entity, entity_id, operation, changes)
+VALUES ('author', $1, 'update', jsonb_build_object('name', $2::text))
+)"_zv, author_id, new_name);
+    Exec(tracer_, work, "END;");
     work.commit();
 }
 
 void BookRepositoryImpl::Save(const domain::Book& book)
 {
-    pqxx::work work{ connection_ };
-    
-    if (!book.GetTags().has_value())
+    if (batcher_)
     {
-        work.exec_params(
-            R"(
-INSERT INTO books (id, author_id, title, publication_year) VALUES ($1, $2, $3, $4)
-ON CONFLICT (id) DO UPDATE SET author_id=$2, title=$3, publication_year=$4;
-)"_zv,
-book.GetBookId().ToString(), book.GetAuthorId().ToString(), book.GetTitle(), book.GetPublicationYear());
-        work.commit();
+        // Lazily loaded tags are read here, as the batcher's thread must not use this connection
+        book.GetTags();
+        batcher_->Submit([tracer = tracer_, book](pqxx::transaction_base& work) {
+            SaveBook(tracer, work, book);
+        }).get();
         return;
     }
-    
-    work.exec("BEGIN;");
-    work.exec("LOCK TABLE books, book_tags");
-
-    work.exec_params(
-        R"(
-INSERT INTO books (id, author_id, title, publication_year) VALUES ($1, $2, $3, $4)
-)"_zv,
-book.GetBookId().ToString(), book.GetAuthorId().ToString(), book.GetTitle(), book.GetPublicationYear());
-
-    std::string query = "INSERT INTO book_tags(book_id, tag) VALUES ";
-    auto book_id = book.GetBookId().ToString();
-    auto tags = book.GetTags().value();
-    for (auto tag = tags.begin(); tag != tags.end(); ++tag)
-    {
-        if (tag == std::prev(tags.end()))
-        {
-            query.append("('" + book_id + "', '" + *tag + "')");
-            break;
-        }
-        query.append("('" + book_id + "', '" + *tag + "'), ");
-    }
-    work.exec(query);
-    work.exec("END;");
+    pqxx::work work{ connection_ };
+    LockForSaveBook(tracer_, work, book);
+    SaveBook(tracer_, work, book);
     work.commit();
 }
 
 std::vector<std::tuple<std::string, std::string, int, std::string>> postgres::BookRepositoryImpl::ShowBooks()
 {
-    std::vector<std::tuple<std::string, std::string, int, std::string>> tv;
-
     pqxx::read_transaction read_trans(connection_);
-    auto query_text = "SELECT books.title, authors.name, books.publication_year, books.id FROM authors, books WHERE authors.id=books.author_id ORDER BY books.title ASC, authors.name ASC, books.publication_year ASC;"_zv;
-    
-    for (auto [title, name, year, id] : read_trans.query<std::string, std::string, int, std::string>(query_text)) {
-        tv.push_back({ title, name, year, id});
-    }
-    return tv;
+    return Fetch<ShowBooksQuery>(tracer_, read_trans);
+}
+
+domain::Stream<std::tuple<std::string, std::string, int, std::string>> postgres::BookRepositoryImpl::StreamBooks()
+{
+    return StreamRows<ShowBooksQuery>(connection_, tracer_);
+}
+
+domain::Stream<domain::Book> postgres::BookRepositoryImpl::StreamBooksByAuthor()
+{
+    return StreamRows<BooksByAuthorQuery>(connection_, tracer_);
 }
 
 std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> postgres::BookRepositoryImpl::ShowBook(std::string& book_name)
 {
-    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> res;
-    std::set<std::string> tags;
     pqxx::read_transaction r(connection_);
+    return GroupBookTags(Fetch<BookTagsByTitleQuery>(tracer_, r, book_name));
+}
 
-    auto query_text = "SELECT books.title, authors.name, books.publication_year, books.id FROM authors, books WHERE books.title = " + r.quote(book_name) + " AND authors.id=books.author_id;";
-
-    for (auto [title, name, year, id] : r.query<std::string, std::string, int, std::string>(query_text))
-    {
-        auto second_query = "SELECT tag FROM book_tags WHERE book_id = " + r.quote(id) + ";";
-        for (auto [tag] : r.query<std::string>(second_query))
-        {
-            tags.insert(tag);
-        }
-        res.push_back({ title, name, year, id, tags });
-        tags.clear();
-    }
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> postgres::BookRepositoryImpl::ShowBooksDetails(const std::vector<std::string>& book_ids)
+{
+    if (book_ids.empty())
+        return {};
 
-    return res;
+    pqxx::read_transaction r(connection_);
+    return GroupBookTags(Fetch<BookTagsByIdQuery>(tracer_, r, book_ids));
 }
 
 void postgres::BookRepositoryImpl::EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id)
 {
     pqxx::work work{ connection_ };
-    work.exec("BEGIN;");
-    work.exec("LOCK TABLE books, book_tags");
-    std::string book_title = work.query_value<std::string>("SELECT title FROM books WHERE id = " + work.quote(id));
+    Exec(tracer_, work, "BEGIN;");
+    Exec(tracer_, work, "LOCK TABLE books, book_tags");
+    LockChangeLog(tracer_, work);
+    std::string book_title = Exec(tracer_, work, "SELECT title FROM books WHERE id = $1"_zv, id).one_row()[0].as<std::string>();
     if (book_title.empty())
         throw std::runtime_error("");
-    work.exec("UPDATE books SET title =" + work.quote(title) + " WHERE id = " + work.quote(id));
-    work.exec("UPDATE books SET publication_year =" + std::to_string(publication_year) + " WHERE id = " + work.quote(id));
-    work.exec("DELETE FROM book_tags WHERE book_id = " + work.quote(id));
-    std::string query = "INSERT INTO book_tags(book_id, tag) VALUES ";
-
-    for (auto tag = tags.begin(); tag != tags.end(); ++tag)
-    {
-        if (tag == std::prev(tags.end()))
-        {
-            query.append("('" + id + "', '" + *tag + "')");
-            break;
-        }
-        query.append("('" + id + "', '" + *tag + "'), ");
-    }
-
-    work.exec(query);
-    work.exec("END;");
+    // Only what changes is written: the book row if its title or year does, and of the tags,
+    // those no longer wanted are deleted and the new ones inserted. Every part of the statement
+    // sees book_tags as it was before it, so the diff is taken against the stored tags.
+    const std::vector<std::string> tag_list{tags.begin(), tags.end()};
+    Exec(tracer_, work, R"(
+WITH edited AS (
+    UPDATE books SET title = $2::varchar, publication_year = $3::integer
+    WHERE id = $1::uuid AND (title, publication_year) IS DISTINCT FROM ($2::varchar, $3::integer)),
+removed AS (DELETE FROM book_tags WHERE book_id = $1::uuid AND tag <> ALL($4::varchar[]))
+INSERT INTO book_tags (book_id, tag)
+SELECT $1::uuid, wanted.tag FROM unnest($4::varchar[]) AS wanted(tag)
+WHERE NOT EXISTS (SELECT 1 FROM book_tags t WHERE t.book_id = $1::uuid AND t.tag = wanted.tag);
+)"_zv, id, title, publication_year, tag_list);
+    AppendBookEvent(tracer_, work, "update"sv, id, nullptr, title, publication_year, &tags);
+    Exec(tracer_, work, "END;");
     work.commit();
 }
 
@@ -197,61 +404,284 @@ void postgres::BookRepositoryImpl::DeleteBook(std::string& book_id)
 {
     pqxx::work work(connection_);
 
-    work.exec("BEGIN;");
-    work.exec("LOCK TABLE books, book_tags");
+    Exec(tracer_, work, "BEGIN;");
+    Exec(tracer_, work, "LOCK TABLE books, book_tags");
+    LockChangeLog(tracer_, work);
 
-    std::string book_name = work.query_value<std::string>("SELECT title FROM books WHERE id = " + work.quote(book_id));
+    std::string book_name = Exec(tracer_, work, "SELECT title FROM books WHERE id = $1"_zv, book_id).one_row()[0].as<std::string>();
     if (book_name.empty())
         throw std::runtime_error("");
 
-    work.exec("DELETE FROM books WHERE id = " + work.quote(book_id));
-    work.exec("DELETE FROM book_tags WHERE book_id = " + work.quote(book_id));
+    Exec(tracer_, work, "DELETE FROM books WHERE id = $1"_zv, book_id);
+    Exec(tracer_, work, "DELETE FROM book_tags WHERE book_id = $1"_zv, book_id);
+    Exec(tracer_, work, "INSERT INTO catalog_events (entity, entity_id, operation) VALUES ('book', $1, 'delete')"_zv, book_id);
     work.commit();
 }
 
 std::vector<domain::Book> postgres::BookRepositoryImpl::GetAuthorBooks(const std::string& author_id)
 {
-    std::vector<domain::Book> books;
+    pqxx::read_transaction r{ connection_ };
+    return GroupAuthorBooks(Fetch<AuthorBooksQuery>(tracer_, r, author_id));
+}
+
+std::vector<domain::Book> postgres::BookRepositoryImpl::GetAuthorBooksPage(const std::string& author_id,
+                                                                           const std::optional<domain::AuthorBooksCursor>& after,
+                                                                           std::size_t limit)
+{
+    const auto page_size = static_cast<std::int64_t>(std::min<std::size_t>(limit, std::numeric_limits<std::int64_t>::max()));
+    pqxx::read_transaction r{ connection_ };
+    if (!after)
+        return GroupAuthorBooks(Fetch<FirstAuthorBooksPageQuery>(tracer_, r, author_id, page_size));
+    return GroupAuthorBooks(Fetch<NextAuthorBooksPageQuery>(tracer_, r, author_id, after->publication_year,
+                                                            after->title, after->book_id, page_size));
+}
+
+domain::CatalogStats postgres::BookRepositoryImpl::GetCatalogStats(domain::StatsSource source)
+{
+    const bool summary = source == domain::StatsSource::Summary;
+    domain::CatalogStats stats;
     pqxx::read_transaction r{ connection_ };
 
-    for (
-        const auto& [id, author_id, title, publication_year] :
-        r.query<std::string, std::string, std::string, int>("SELECT id, author_id, title, publication_year FROM books WHERE author_id = "s + r.quote(author_id) + " ORDER BY publication_year, title ASC;"s))
+    const auto author_rows = Exec(tracer_, r, summary
+        ? "SELECT authors.name, counts.books FROM author_book_counts counts JOIN authors ON authors.id = counts.author_id ORDER BY authors.name;"_zv
+        : "SELECT authors.name, count(*) FROM books JOIN authors ON authors.id = books.author_id GROUP BY authors.name ORDER BY authors.name;"_zv);
+    for (auto [name, books] : author_rows.iter<std::string, std::uint64_t>())
+        stats.books_per_author.emplace_back(std::move(name), books);
+
+    const auto tag_rows = Exec(tracer_, r, summary
+        ? "SELECT tag, books FROM tag_book_counts ORDER BY tag;"_zv
+        : "SELECT tag, count(*) FROM book_tags GROUP BY tag ORDER BY tag;"_zv);
+    for (auto [tag, books] : tag_rows.iter<std::string, std::uint64_t>())
+        stats.books_per_tag.emplace_back(std::move(tag), books);
+
+    const auto year_rows = Exec(tracer_, r, summary
+        ? "SELECT year, books FROM year_book_counts ORDER BY year;"_zv
+        : "SELECT publication_year, count(*) FROM books GROUP BY publication_year ORDER BY publication_year;"_zv);
+    for (auto [year, books] : year_rows.iter<int, std::uint64_t>())
     {
-        auto book_id_t = util::TaggedUUID<domain::detail::BookTag>::FromString(id);
-        auto author_id_t = util::TaggedUUID<domain::detail::AuthorTag>::FromString(author_id);
-        //books.emplace_back(book_id_t, author_id_t, title, publication_year); //todo
+        stats.books_per_year.emplace_back(year, books);
+        stats.books += books;
     }
 
-    return books;
+    return stats;
 }
 
-Database::Database(pqxx::connection connection)
-    : connection_{std::move(connection)} {
-    pqxx::work work{connection_};
-    work.exec(R"(
+std::uint64_t postgres::BookRepositoryImpl::DeleteBooksByTag(const std::string& tag)
+{
+    pqxx::work work{ connection_ };
+    Exec(tracer_, work, "LOCK TABLE books, book_tags"_zv);
+    LockChangeLog(tracer_, work);
+    const auto deleted = DeleteBooksWhere(tracer_, work, "id IN (SELECT book_id FROM book_tags WHERE tag = $1)"sv, tag);
+    work.commit();
+    return deleted;
+}
+
+std::uint64_t postgres::BookRepositoryImpl::RetagBooks(const std::string& from, const std::string& to)
+{
+    if (from == to)
+        return 0;
+
+    pqxx::work work{ connection_ };
+    Exec(tracer_, work, "LOCK TABLE books, book_tags"_zv);
+    LockChangeLog(tracer_, work);
+    // Every part of the statement sees book_tags as it was before it, so the new tag is only
+    // added where it was missing, and the events list the tags each book ends up with
+    const auto retagged = Exec(tracer_, work, R"(
+WITH retagged AS (SELECT DISTINCT book_id FROM book_tags WHERE tag = $1::varchar),
+removed AS (DELETE FROM book_tags WHERE tag = $1::varchar),
+added AS (
+    INSERT INTO book_tags (book_id, tag)
+    SELECT book_id, $2::varchar FROM retagged r
+    WHERE NOT EXISTS (SELECT 1 FROM book_tags t WHERE t.book_id = r.book_id AND t.tag = $2::varchar)),
+events AS (
+    INSERT INTO catalog_events (entity, entity_id, operation, changes)
+    SELECT 'book', book_id, 'update', jsonb_build_object('tags', ARRAY(
+        SELECT tag FROM book_tags t WHERE t.book_id = r.book_id AND t.tag <> $1::varchar
+        UNION SELECT $2::varchar ORDER BY 1))
+    FROM retagged r)
+SELECT count(*) FROM retagged;
+)"_zv, from, to).one_row()[0].as<std::uint64_t>();
+    work.commit();
+    return retagged;
+}
+
+std::uint64_t postgres::BookRepositoryImpl::DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year)
+{
+    pqxx::work work{ connection_ };
+    Exec(tracer_, work, "LOCK TABLE books, book_tags"_zv);
+    LockChangeLog(tracer_, work);
+    const auto deleted = DeleteBooksWhere(tracer_, work, "author_id = $1 AND publication_year BETWEEN $2 AND $3"sv,
+                                          author_id, min_year, max_year);
+    work.commit();
+    return deleted;
+}
+
+Database::Database(pqxx::connection connection, QueryTracer* tracer, WriteBatcher* batcher)
+    : connection_{std::move(connection)},
+      tracer_{tracer},
+      batcher_{batcher} {
+    InitializeSchema(connection_, tracer_);
+    PrepareStatements(connection_);
+}
+
+void PrepareStatements(pqxx::connection& connection) {
+    PrepareQueries<GetAuthorsQuery, ShowBooksQuery, AuthorBooksQuery, FirstAuthorBooksPageQuery,
+                   NextAuthorBooksPageQuery, BookTagsByTitleQuery, BookTagsByIdQuery>(connection);
+}
+
+void InitializeSchema(pqxx::connection& connection, QueryTracer* tracer) {
+    pqxx::work work{connection};
+    // Summary tables created next to an existing catalog, or left behind by dropped
+    // catalog tables, have to be filled from the catalog once
+    const bool summaries_valid = Exec(tracer, work, R"(
+SELECT to_regclass('books') IS NOT NULL AND to_regclass('book_tags') IS NOT NULL
+    AND to_regclass('author_book_counts') IS NOT NULL AND to_regclass('tag_book_counts') IS NOT NULL
+    AND to_regclass('year_book_counts') IS NOT NULL;
+)"_zv).one_row()[0].as<bool>();
+
+    Exec(tracer, work, R"(
 CREATE TABLE IF NOT EXISTS authors (
     id UUID CONSTRAINT author_id_constraint PRIMARY KEY,
     name varchar(100) UNIQUE NOT NULL
 );
 )"_zv);
 
-    work.exec(R"(
+    Exec(tracer, work, R"(
 CREATE TABLE IF NOT EXISTS books (
     id UUID CONSTRAINT book_id_constraint PRIMARY KEY,
     author_id UUID NOT NULL,
     title varchar(100) NOT NULL,
     publication_year integer NOT NULL
 );
+CREATE INDEX IF NOT EXISTS books_author_idx ON books (author_id, publication_year, title, id);
 )"_zv);
 
-    work.exec(R"(
+    Exec(tracer, work, R"(
 CREATE TABLE IF NOT EXISTS book_tags (
     book_id UUID,
     tag varchar(30) NOT NULL
 );
+CREATE INDEX IF NOT EXISTS book_tags_tag_idx ON book_tags (tag);
+CREATE INDEX IF NOT EXISTS book_tags_book_id_idx ON book_tags (book_id);
+)"_zv);
+
+    // Change-data-capture log: every repository write appends its events here in the same
+    // transaction; readers follow it by sequence number (see change_log.h)
+    Exec(tracer, work, R"(
+CREATE TABLE IF NOT EXISTS catalog_events (
+    sequence bigserial PRIMARY KEY,
+    entity varchar(10) NOT NULL,
+    entity_id UUID NOT NULL,
+    operation varchar(10) NOT NULL,
+    changes jsonb,
+    recorded_at timestamptz NOT NULL DEFAULT now()
+);
 )"_zv);
 
+    // Book counts for CatalogStats. Statement-level triggers keep them up to date with one
+    // aggregated change per statement, so bulk inserts and COPY do not update a hot row per book.
+    Exec(tracer, work, R"(
+CREATE TABLE IF NOT EXISTS author_book_counts (
+    author_id UUID PRIMARY KEY,
+    books bigint NOT NULL
+);
+CREATE TABLE IF NOT EXISTS tag_book_counts (
+    tag varchar(30) PRIMARY KEY,
+    books bigint NOT NULL
+);
+CREATE TABLE IF NOT EXISTS year_book_counts (
+    year integer PRIMARY KEY,
+    books bigint NOT NULL
+);
+)"_zv);
+
+    Exec(tracer, work, R"(
+CREATE OR REPLACE FUNCTION count_books() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+    IF TG_OP IN ('DELETE', 'UPDATE') THEN
+        UPDATE author_book_counts counts SET books = counts.books - changes.books
+        FROM (SELECT author_id, count(*) AS books FROM old_rows GROUP BY author_id) changes
+        WHERE counts.author_id = changes.author_id;
+        UPDATE year_book_counts counts SET books = counts.books - changes.books
+        FROM (SELECT publication_year, count(*) AS books FROM old_rows GROUP BY publication_year) changes
+        WHERE counts.year = changes.publication_year;
+    END IF;
+    IF TG_OP IN ('INSERT', 'UPDATE') THEN
+        INSERT INTO author_book_counts AS counts (author_id, books)
+        SELECT author_id, count(*) FROM new_rows GROUP BY author_id
+        ON CONFLICT (author_id) DO UPDATE SET books = counts.books + EXCLUDED.books;
+        INSERT INTO year_book_counts AS counts (year, books)
+        SELECT publication_year, count(*) FROM new_rows GROUP BY publication_year
+        ON CONFLICT (year) DO UPDATE SET books = counts.books + EXCLUDED.books;
+    END IF;
+    IF TG_OP IN ('DELETE', 'UPDATE') THEN
+        DELETE FROM author_book_counts WHERE books = 0 AND author_id IN (SELECT author_id FROM old_rows);
+        DELETE FROM year_book_counts WHERE books = 0 AND year IN (SELECT publication_year FROM old_rows);
+    END IF;
+    RETURN NULL;
+END $$;
+
+CREATE OR REPLACE FUNCTION count_book_tags() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+    IF TG_OP = 'INSERT' THEN
+        INSERT INTO tag_book_counts AS counts (tag, books)
+        SELECT tag, count(*) FROM new_rows GROUP BY tag
+        ON CONFLICT (tag) DO UPDATE SET books = counts.books + EXCLUDED.books;
+    ELSE
+        UPDATE tag_book_counts counts SET books = counts.books - changes.books
+        FROM (SELECT tag, count(*) AS books FROM old_rows GROUP BY tag) changes
+        WHERE counts.tag = changes.tag;
+        DELETE FROM tag_book_counts WHERE books = 0 AND tag IN (SELECT tag FROM old_rows);
+    END IF;
+    RETURN NULL;
+END $$;
+
+CREATE OR REPLACE FUNCTION reset_book_counts() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+    IF TG_TABLE_NAME = 'books' THEN
+        TRUNCATE author_book_counts, year_book_counts;
+    ELSE
+        TRUNCATE tag_book_counts;
+    END IF;
+    RETURN NULL;
+END $$;
+)"_zv);
+
+    // Transition tables cannot be shared between events, hence a trigger per event
+    Exec(tracer, work, R"(
+DROP TRIGGER IF EXISTS books_inserted ON books;
+CREATE TRIGGER books_inserted AFTER INSERT ON books
+    REFERENCING NEW TABLE AS new_rows FOR EACH STATEMENT EXECUTE FUNCTION count_books();
+DROP TRIGGER IF EXISTS books_updated ON books;
+CREATE TRIGGER books_updated AFTER UPDATE ON books
+    REFERENCING OLD TABLE AS old_rows NEW TABLE AS new_rows FOR EACH STATEMENT EXECUTE FUNCTION count_books();
+DROP TRIGGER IF EXISTS books_deleted ON books;
+CREATE TRIGGER books_deleted AFTER DELETE ON books
+    REFERENCING OLD TABLE AS old_rows FOR EACH STATEMENT EXECUTE FUNCTION count_books();
+DROP TRIGGER IF EXISTS books_truncated ON books;
+CREATE TRIGGER books_truncated AFTER TRUNCATE ON books
+    FOR EACH STATEMENT EXECUTE FUNCTION reset_book_counts();
+DROP TRIGGER IF EXISTS book_tags_inserted ON book_tags;
+CREATE TRIGGER book_tags_inserted AFTER INSERT ON book_tags
+    REFERENCING NEW TABLE AS new_rows FOR EACH STATEMENT EXECUTE FUNCTION count_book_tags();
+DROP TRIGGER IF EXISTS book_tags_deleted ON book_tags;
+CREATE TRIGGER book_tags_deleted AFTER DELETE ON book_tags
+    REFERENCING OLD TABLE AS old_rows FOR EACH STATEMENT EXECUTE FUNCTION count_book_tags();
+DROP TRIGGER IF EXISTS book_tags_truncated ON book_tags;
+CREATE TRIGGER book_tags_truncated AFTER TRUNCATE ON book_tags
+    FOR EACH STATEMENT EXECUTE FUNCTION reset_book_counts();
+)"_zv);
+
+    if (!summaries_valid)
+    {
+        Exec(tracer, work, R"(
+TRUNCATE author_book_counts, tag_book_counts, year_book_counts;
+INSERT INTO author_book_counts (author_id, books) SELECT author_id, count(*) FROM books GROUP BY author_id;
+INSERT INTO tag_book_counts (tag, books) SELECT tag, count(*) FROM book_tags GROUP BY tag;
+INSERT INTO year_book_counts (year, books) SELECT publication_year, count(*) FROM books GROUP BY publication_year;
+)"_zv);
+    }
+
     // коммитим изменения
     work.commit();
 }
@@ -4,46 +4,81 @@
 
 #include "../domain/author.h"
 #include "../domain/book.h"
+#include "query_tracer.h"
+#include "write_batcher.h"
 #include <tuple>
 
 namespace postgres {
 
 class AuthorRepositoryImpl : public domain::AuthorRepository {
 public:
-    explicit AuthorRepositoryImpl(pqxx::connection& connection)
-        : connection_{connection} 
+    // With a batcher, Save waits for the batch it is committed in, while everything else
+    // runs on the repository's own connection
+    explicit AuthorRepositoryImpl(pqxx::connection& connection, QueryTracer* tracer = nullptr,
+                                  WriteBatcher* batcher = nullptr)
+        : connection_{connection},
+          tracer_{tracer},
+          batcher_{batcher}
     {}
 
     void Save(const domain::Author& author) override;
     std::vector<domain::Author> GetAuthors() override;
+    domain::Stream<domain::Author> StreamAuthors() override;
     void Delete(std::string& name) override;
     void Edit(std::string& new_name, std::string& old_name) override;
 
 private:
     pqxx::connection& connection_;
+    QueryTracer* tracer_;
+    WriteBatcher* batcher_;
 };
 
 class BookRepositoryImpl : public domain::BookRepository
 {
 public:
-    explicit BookRepositoryImpl(pqxx::connection& connection)
-        : connection_{ connection }
+    // Saves are batched as in AuthorRepositoryImpl
+    explicit BookRepositoryImpl(pqxx::connection& connection, QueryTracer* tracer = nullptr,
+                                WriteBatcher* batcher = nullptr)
+        : connection_{ connection },
+          tracer_{ tracer },
+          batcher_{ batcher }
     {}
 
     void Save(const domain::Book& book) override;
     std::vector<std::tuple<std::string, std::string, int, std::string>> ShowBooks() override;
+    domain::Stream<std::tuple<std::string, std::string, int, std::string>> StreamBooks() override;
+    domain::Stream<domain::Book> StreamBooksByAuthor() override;
     std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) override;
+    std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                 const std::optional<domain::AuthorBooksCursor>& after,
+                                                 std::size_t limit) override;
     std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBook(std::string& book_name) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBooksDetails(const std::vector<std::string>& book_ids) override;
     void DeleteBook(std::string& book_id) override;
     void EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) override;
+    domain::CatalogStats GetCatalogStats(domain::StatsSource source) override;
+    std::uint64_t DeleteBooksByTag(const std::string& tag) override;
+    std::uint64_t RetagBooks(const std::string& from, const std::string& to) override;
+    std::uint64_t DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) override;
 
 private:
+
     pqxx::connection& connection_;
+    QueryTracer* tracer_;
+    WriteBatcher* batcher_;
 };
 
+// Creates the tables unless they exist
+void InitializeSchema(pqxx::connection& connection, QueryTracer* tracer = nullptr);
+
+// Prepares the statements of the repositories on a connection to a database with the schema.
+// The repositories run on connections set up with it; Database does so for its own.
+void PrepareStatements(pqxx::connection& connection);
+
 class Database {
 public:
-    explicit Database(pqxx::connection connection);
+    // The batcher, if any, must outlive the database
+    explicit Database(pqxx::connection connection, QueryTracer* tracer = nullptr, WriteBatcher* batcher = nullptr);
 
     AuthorRepositoryImpl& GetAuthors() & {
         return authors_;
@@ -55,8 +90,10 @@ public:
 
 private:
     pqxx::connection connection_;
-    AuthorRepositoryImpl authors_{connection_};
-    BookRepositoryImpl books_{ connection_ };
+    QueryTracer* tracer_;
+    WriteBatcher* batcher_;
+    AuthorRepositoryImpl authors_{connection_, tracer_, batcher_};
+    BookRepositoryImpl books_{ connection_, tracer_, batcher_ };
 };
 
 }  // namespace postgres
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "query_tracer.h"
+
+#include <cctype>
+#include <stdexcept>
+#include <utility>
+
+#include "../util/command_context.h"
+
+namespace postgres {
+
+using namespace std::literals;
+
+namespace {
+
+bool IsIdentifierChar(char c) noexcept {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+void WriteJsonString(std::ostream& out, std::string_view text) {
+    out << '"';
+    for (const char c : text) {
+        switch (c) {
+            case '"':
+                out << "\\\""sv;
+                break;
+            case '\\':
+                out << "\\\\"sv;
+                break;
+            case '\n':
+                out << "\\n"sv;
+                break;
+            case '\t':
+                out << "\\t"sv;
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out << ' ';
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+}
+
+}  // namespace
+
+QueryTracer::QueryTracer(Config config)
+    : config_{std::move(config)}
+    , output_{config_.output_file, std::ios::app}
+    , ring_(std::max<std::size_t>(config_.capacity, 1)) {
+    if (!output_) {
+        throw std::runtime_error("Failed to open SQL trace file "s + config_.output_file);
+    }
+    writer_ = std::thread{&QueryTracer::FlushLoop, this};
+}
+
+QueryTracer::~QueryTracer() {
+    {
+        std::lock_guard lock{mutex_};
+        stopping_ = true;
+    }
+    flush_requested_.notify_one();
+    writer_.join();
+}
+
+std::string QueryTracer::Normalize(std::string_view sql) {
+    std::string result;
+    result.reserve(sql.size());
+
+    for (std::size_t i = 0; i < sql.size();) {
+        const char c = sql[i];
+        if (c == '\'') {
+            // String literal, '' inside is an escaped quote
+            ++i;
+            while (i < sql.size()) {
+                if (sql[i] == '\'' && (i + 1 == sql.size() || sql[i + 1] != '\'')) {
+                    ++i;
+                    break;
+                }
+                i += sql[i] == '\'' ? 2 : 1;
+            }
+            result += '?';
+        } else if (std::isdigit(static_cast<unsigned char>(c)) && (result.empty() || !IsIdentifierChar(result.back()))) {
+            while (i < sql.size() && (std::isdigit(static_cast<unsigned char>(sql[i])) || sql[i] == '.')) {
+                ++i;
+            }
+            result += '?';
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            while (i < sql.size() && std::isspace(static_cast<unsigned char>(sql[i]))) {
+                ++i;
+            }
+            if (!result.empty() && i < sql.size()) {
+                result += ' ';
+            }
+        } else {
+            result += c;
+            ++i;
+        }
+    }
+    return result;
+}
+
+bool QueryTracer::IsExplainable(std::string_view sql) noexcept {
+    const auto begin = sql.find_first_not_of(" \t\r\n"sv);
+    if (begin == std::string_view::npos || sql.size() - begin < "SELECT"sv.size()) {
+        return false;
+    }
+    const auto keyword = sql.substr(begin, "SELECT"sv.size());
+    for (std::size_t i = 0; i < keyword.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(keyword[i])) != "SELECT"sv[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string QueryTracer::JoinPlan(const pqxx::result& plan) {
+    std::string text;
+    for (const auto& row : plan) {
+        if (!text.empty()) {
+            text += '\n';
+        }
+        text += row[0].c_str();
+    }
+    return text;
+}
+
+void QueryTracer::Record(std::string_view sql, std::size_t rows, std::chrono::nanoseconds duration, std::string plan) {
+    const auto command = util::GetCurrentCommand();
+    Trace trace{Normalize(sql), std::string{command.name}, command.invocation, rows, duration, std::move(plan)};
+
+    bool half_full = false;
+    {
+        std::lock_guard lock{mutex_};
+        ring_[(head_ + size_) % ring_.size()] = std::move(trace);
+        if (size_ == ring_.size()) {
+            head_ = (head_ + 1) % ring_.size();
+            ++dropped_;
+        } else {
+            ++size_;
+        }
+        half_full = size_ * 2 >= ring_.size();
+    }
+    if (half_full) {
+        flush_requested_.notify_one();
+    }
+}
+
+void QueryTracer::FlushLoop() {
+    std::vector<Trace> batch;
+    std::unique_lock lock{mutex_};
+    while (true) {
+        flush_requested_.wait_for(lock, config_.flush_interval, [this] {
+            return stopping_ || size_ * 2 >= ring_.size();
+        });
+
+        batch.clear();
+        batch.reserve(size_);
+        for (; size_ > 0; --size_) {
+            batch.push_back(std::move(ring_[head_]));
+            head_ = (head_ + 1) % ring_.size();
+        }
+        const auto dropped = std::exchange(dropped_, 0);
+        const bool stopping = stopping_;
+
+        lock.unlock();
+        if (dropped != 0) {
+            output_ << "{\"dropped\":"sv << dropped << "}\n"sv;
+        }
+        Write(batch);
+        if (stopping) {
+            WriteSummary();
+            output_.flush();
+            return;
+        }
+        output_.flush();
+        lock.lock();
+    }
+}
+
+void QueryTracer::Write(std::vector<Trace>& traces) {
+    for (const auto& trace : traces) {
+        output_ << "{\"command\":"sv;
+        WriteJsonString(output_, trace.command);
+        output_ << ",\"invocation\":"sv << trace.invocation << ",\"rows\":"sv << trace.rows
+                << ",\"duration_us\":"sv << std::chrono::duration<double, std::micro>(trace.duration).count()
+                << ",\"sql\":"sv;
+        WriteJsonString(output_, trace.sql);
+        if (!trace.plan.empty()) {
+            output_ << ",\"plan\":"sv;
+            WriteJsonString(output_, trace.plan);
+        }
+        output_ << "}\n"sv;
+
+        auto& stats = command_stats_[trace.command];
+        ++stats.statements;
+        if (stats.last_invocation != trace.invocation) {
+            stats.last_invocation = trace.invocation;
+            ++stats.invocations;
+        }
+    }
+}
+
+void QueryTracer::WriteSummary() {
+    for (const auto& [command, stats] : command_stats_) {
+        output_ << "{\"summary\":"sv;
+        WriteJsonString(output_, command);
+        output_ << ",\"invocations\":"sv << stats.invocations << ",\"statements\":"sv << stats.statements
+                << ",\"round_trips_per_invocation\":"sv
+                << static_cast<double>(stats.statements) / static_cast<double>(std::max<std::size_t>(stats.invocations, 1))
+                << "}\n"sv;
+    }
+}
+
+}  // namespace postgres
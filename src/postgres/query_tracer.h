@@ -0,0 +1,126 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <pqxx/result>
+#include <pqxx/transaction>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace postgres {
+
+/**
+ * Traces SQL statements issued by the repositories.
+ * For every statement it keeps the normalized text (literals replaced by '?'),
+ * the number of rows returned, the wall time and the user command it was issued for.
+ * For SELECT statements slower than the threshold the plan is kept too. It comes from plain
+ * EXPLAIN in the same transaction, which plans the statement without running it again.
+ *
+ * Traces go to a fixed-size ring buffer. A background thread drains it to the
+ * output file as JSON lines, so the statement itself only pays for normalization
+ * and a short critical section. When the writer falls behind, the oldest traces
+ * are overwritten and counted as dropped.
+ */
+class QueryTracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        std::string output_file;
+        std::chrono::nanoseconds slow_threshold = std::chrono::milliseconds{100};
+        std::size_t capacity = 4096;
+        std::chrono::milliseconds flush_interval{200};
+    };
+
+    explicit QueryTracer(Config config);
+    ~QueryTracer();
+
+    QueryTracer(const QueryTracer&) = delete;
+    QueryTracer& operator=(const QueryTracer&) = delete;
+
+    template <typename... Args>
+    pqxx::result Exec(pqxx::transaction_base& tx, pqxx::zview sql, const Args&... args) {
+        const auto start = Clock::now();
+        auto result = Run(tx, sql, args...);
+        const auto duration = Clock::now() - start;
+
+        std::string plan;
+        if (duration >= config_.slow_threshold && IsExplainable(sql)) {
+            const auto explain_sql = "EXPLAIN " + std::string{sql};
+            plan = JoinPlan(Run(tx, explain_sql, args...));
+        }
+        Record(sql, result.size(), duration, std::move(plan));
+        return result;
+    }
+
+    // Replaces string and numeric literals with '?' and collapses whitespace,
+    // so that executions of the same statement group together
+    static std::string Normalize(std::string_view sql);
+
+private:
+    struct Trace {
+        std::string sql;
+        std::string command;
+        std::uint64_t invocation = 0;
+        std::size_t rows = 0;
+        std::chrono::nanoseconds duration{};
+        std::string plan;
+    };
+
+    struct CommandStats {
+        std::size_t invocations = 0;
+        std::size_t statements = 0;
+        std::uint64_t last_invocation = 0;
+    };
+
+    template <typename... Args>
+    static pqxx::result Run(pqxx::transaction_base& tx, pqxx::zview sql, const Args&... args) {
+        if constexpr (sizeof...(Args) == 0) {
+            return tx.exec(sql);
+        } else {
+            return tx.exec_params(sql, args...);
+        }
+    }
+
+    static bool IsExplainable(std::string_view sql) noexcept;
+    static std::string JoinPlan(const pqxx::result& plan);
+
+    void Record(std::string_view sql, std::size_t rows, std::chrono::nanoseconds duration, std::string plan);
+    void FlushLoop();
+    void Write(std::vector<Trace>& traces);
+    void WriteSummary();
+
+    Config config_;
+    std::ofstream output_;
+
+    std::mutex mutex_;
+    std::condition_variable flush_requested_;
+    std::vector<Trace> ring_;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+    std::size_t dropped_ = 0;
+    bool stopping_ = false;
+
+    // Round trips per command, maintained by the writer thread only
+    std::map<std::string, CommandStats, std::less<>> command_stats_;
+
+    std::thread writer_;
+};
+
+// Runs the statement through the tracer if there is one
+template <typename... Args>
+pqxx::result Exec(QueryTracer* tracer, pqxx::transaction_base& tx, pqxx::zview sql, const Args&... args) {
+    if (tracer) {
+        return tracer->Exec(tx, sql, args...);
+    }
+    if constexpr (sizeof...(Args) == 0) {
+        return tx.exec(sql);
+    } else {
+        return tx.exec_params(sql, args...);
+    }
+}
+
+}  // namespace postgres
@@ -0,0 +1,460 @@
+#include "sharded.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+
+#include "postgres.h"
+
+namespace postgres {
+
+using pqxx::operator"" _zv;
+
+namespace {
+
+// Merges lists that are each sorted by less, taking one element at a time
+// from the list whose head is the smallest
+template <typename T, typename Less>
+std::vector<T> MergeSorted(std::vector<std::vector<T>> lists, Less less) {
+    struct Head {
+        std::size_t list;
+        std::size_t index;
+    };
+
+    std::size_t total = 0;
+    for (const auto& list : lists) {
+        total += list.size();
+    }
+
+    auto greater = [&lists, &less](const Head& lhs, const Head& rhs) {
+        return less(lists[rhs.list][rhs.index], lists[lhs.list][lhs.index]);
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads{greater};
+    for (std::size_t i = 0; i < lists.size(); ++i) {
+        if (!lists[i].empty()) {
+            heads.push({i, 0});
+        }
+    }
+
+    std::vector<T> merged;
+    merged.reserve(total);
+    while (!heads.empty()) {
+        auto head = heads.top();
+        heads.pop();
+        merged.push_back(std::move(lists[head.list][head.index]));
+        if (++head.index < lists[head.list].size()) {
+            heads.push(head);
+        }
+    }
+    return merged;
+}
+
+// Rows of one shard's stream, with the connection its cursor is on
+template <typename T>
+struct ShardRows {
+    ConnectionPool::Lease connection;
+    domain::Stream<T> rows;
+    typename domain::Stream<T>::Iterator current;
+};
+
+// Opens open(pqxx::connection&)'s stream on a connection of the shard and fetches its first batch
+template <typename T, typename Open>
+std::unique_ptr<ShardRows<T>> OpenShardRows(ShardSet& shards, std::size_t shard, const Open& open) {
+    auto connection = shards.Acquire(shard);
+    auto rows = open(*connection);
+    auto shard_rows = std::make_unique<ShardRows<T>>(ShardRows<T>{std::move(connection), std::move(rows), {}});
+    shard_rows->current = shard_rows->rows.begin();
+    return shard_rows;
+}
+
+// Rows handed out per batch of a merged or chained stream, as many as a shard's cursor fetches
+constexpr std::size_t STREAM_BATCH_SIZE = 1000;
+
+// MergeSorted over the shards' streams: the heap holds the current row of every shard,
+// so no more than a batch of each is in memory
+template <typename T, typename Less, typename Open>
+class MergedSource : public domain::Stream<T>::Source {
+public:
+    MergedSource(ShardSet& shards, Less less, Open open)
+        : shards_{shards}
+        , heads_{Greater{inputs_, less}}
+        , open_{std::move(open)} {
+    }
+
+    void FetchBatch(std::vector<T>& batch) override {
+        if (!started_) {
+            started_ = true;
+            for (std::size_t i = 0; i < shards_.GetSize(); ++i) {
+                inputs_.push_back(OpenShardRows<T>(shards_, i, open_));
+                if (inputs_.back()->current != std::default_sentinel) {
+                    heads_.push(i);
+                } else {
+                    inputs_.back().reset();
+                }
+            }
+        }
+        batch.clear();
+        while (batch.size() < STREAM_BATCH_SIZE && !heads_.empty()) {
+            const auto shard = heads_.top();
+            heads_.pop();
+            auto& input = *inputs_[shard];
+            batch.push_back(*input.current);
+            if (++input.current != std::default_sentinel) {
+                heads_.push(shard);
+            } else {
+                // Gives the connection back as soon as the shard runs out of rows
+                inputs_[shard].reset();
+            }
+        }
+    }
+
+private:
+    struct Greater {
+        const std::vector<std::unique_ptr<ShardRows<T>>>& inputs;
+        Less less;
+
+        bool operator()(std::size_t lhs, std::size_t rhs) const {
+            return less(*inputs[rhs]->current, *inputs[lhs]->current);
+        }
+    };
+
+    ShardSet& shards_;
+    std::vector<std::unique_ptr<ShardRows<T>>> inputs_;
+    std::priority_queue<std::size_t, std::vector<std::size_t>, Greater> heads_;
+    Open open_;
+    bool started_ = false;
+};
+
+template <typename T, typename Less, typename Open>
+domain::Stream<T> MergeShardStreams(ShardSet& shards, Less less, Open open) {
+    return domain::Stream<T>{std::make_unique<MergedSource<T, Less, Open>>(shards, std::move(less), std::move(open))};
+}
+
+// The shards' streams one after another, each opened once the previous one has run out
+template <typename T, typename Open>
+class ChainedSource : public domain::Stream<T>::Source {
+public:
+    ChainedSource(ShardSet& shards, Open open)
+        : shards_{shards}
+        , open_{std::move(open)} {
+    }
+
+    void FetchBatch(std::vector<T>& batch) override {
+        batch.clear();
+        while (batch.size() < STREAM_BATCH_SIZE) {
+            if (!input_) {
+                if (next_shard_ == shards_.GetSize()) {
+                    return;
+                }
+                input_ = OpenShardRows<T>(shards_, next_shard_++, open_);
+            }
+            if (input_->current == std::default_sentinel) {
+                input_.reset();
+                continue;
+            }
+            batch.push_back(*input_->current);
+            ++input_->current;
+        }
+    }
+
+private:
+    ShardSet& shards_;
+    Open open_;
+    std::size_t next_shard_ = 0;
+    std::unique_ptr<ShardRows<T>> input_;
+};
+
+template <typename T, typename Open>
+domain::Stream<T> ChainShardStreams(ShardSet& shards, Open open) {
+    return domain::Stream<T>{std::make_unique<ChainedSource<T, Open>>(shards, std::move(open))};
+}
+
+// The order of ShowBooks, StreamBooks and ShowBook rows: title, author name, publication year
+struct TitleAuthorYearLess {
+    template <typename Row>
+    bool operator()(const Row& lhs, const Row& rhs) const {
+        return std::tie(std::get<0>(lhs), std::get<1>(lhs), std::get<2>(lhs))
+             < std::tie(std::get<0>(rhs), std::get<1>(rhs), std::get<2>(rhs));
+    }
+};
+
+template <typename T>
+std::vector<T> Concatenate(std::vector<std::vector<T>> lists) {
+    std::vector<T> result;
+    for (auto& list : lists) {
+        std::move(list.begin(), list.end(), std::back_inserter(result));
+    }
+    return result;
+}
+
+}  // namespace
+
+ShardSet::ShardSet(const std::vector<std::string>& shard_urls, std::size_t connections_per_shard, QueryTracer* tracer)
+    : tracer_{tracer}
+    , names_url_{shard_urls.empty() ? std::string{} : shard_urls.front()} {
+    if (shard_urls.empty()) {
+        throw std::invalid_argument("No shards given");
+    }
+    shards_.reserve(shard_urls.size());
+    for (const auto& url : shard_urls) {
+        // The statements of the pool's connections are prepared on the schema, so it comes first
+        {
+            pqxx::connection connection{url};
+            InitializeSchema(connection, tracer_);
+        }
+        shards_.push_back(std::make_unique<ConnectionPool>(url, connections_per_shard, PrepareStatements));
+    }
+}
+
+std::size_t ShardSet::GetShardOf(std::string_view author_id) const noexcept {
+    // FNV-1a of the textual UUID: stable between processes and builds, unlike std::hash
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : author_id) {
+        hash ^= static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(c)));
+        hash *= 1099511628211ull;
+    }
+    return hash % shards_.size();
+}
+
+void ShardSet::LockAuthorName(std::string_view name, const std::function<void()>& fn) {
+    // FNV-1a again, as every process has to take the same key for a name
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    const auto key = static_cast<std::int64_t>(hash);
+
+    std::lock_guard lock{names_mutex_};
+    ExecOnNamesConnection("SELECT pg_advisory_lock($1)"_zv, key);
+    try {
+        fn();
+    } catch (...) {
+        try {
+            ExecOnNamesConnection("SELECT pg_advisory_unlock($1)"_zv, key);
+        } catch (const std::exception&) {
+            // The lock goes with the broken connection
+        }
+        throw;
+    }
+    ExecOnNamesConnection("SELECT pg_advisory_unlock($1)"_zv, key);
+}
+
+void ShardSet::ExecOnNamesConnection(pqxx::zview sql, std::int64_t key) {
+    if (!names_connection_ || !names_connection_->is_open()) {
+        // The previous one may have broken, and its locks with it
+        names_connection_ = std::make_unique<pqxx::connection>(names_url_);
+    }
+    pqxx::nontransaction tx{*names_connection_};
+    Exec(tracer_, tx, sql, key);
+}
+
+void ShardedAuthorRepository::Save(const domain::Author& author) {
+    const auto id = author.GetId().ToString();
+    const auto shard = shards_.GetShardOf(id);
+    shards_.LockAuthorName(author.GetName(), [&] {
+        // The shard of the author itself enforces the name with its unique index
+        for (const auto name_shard : FindNameShards(author.GetName())) {
+            if (name_shard != shard) {
+                throw std::runtime_error("Author " + author.GetName() + " already exists");
+            }
+        }
+        shards_.OnShard(shard, [&](pqxx::connection& connection) {
+            AuthorRepositoryImpl{connection, shards_.GetTracer()}.Save(author);
+        });
+    });
+}
+
+std::vector<domain::Author> ShardedAuthorRepository::GetAuthors() {
+    auto lists = shards_.OnAllShards([this](pqxx::connection& connection) {
+        return AuthorRepositoryImpl{connection, shards_.GetTracer()}.GetAuthors();
+    });
+    return MergeSorted(std::move(lists), [](const domain::Author& lhs, const domain::Author& rhs) {
+        return lhs.GetName() < rhs.GetName();
+    });
+}
+
+domain::Stream<domain::Author> ShardedAuthorRepository::StreamAuthors() {
+    auto less = [](const domain::Author& lhs, const domain::Author& rhs) {
+        return lhs.GetName() < rhs.GetName();
+    };
+    return MergeShardStreams<domain::Author>(shards_, less, [tracer = shards_.GetTracer()](pqxx::connection& connection) {
+        return AuthorRepositoryImpl{connection, tracer}.StreamAuthors();
+    });
+}
+
+void ShardedAuthorRepository::Delete(std::string& name) {
+    shards_.OnShard(GetNameShard(name), [&](pqxx::connection& connection) {
+        AuthorRepositoryImpl{connection, shards_.GetTracer()}.Delete(name);
+    });
+}
+
+void ShardedAuthorRepository::Edit(std::string& new_name, std::string& old_name) {
+    shards_.LockAuthorName(new_name, [&] {
+        const auto shard = GetNameShard(old_name);
+        for (const auto name_shard : FindNameShards(new_name)) {
+            if (name_shard != shard) {
+                throw std::runtime_error("Author " + new_name + " already exists");
+            }
+        }
+        shards_.OnShard(shard, [&](pqxx::connection& connection) {
+            AuthorRepositoryImpl{connection, shards_.GetTracer()}.Edit(new_name, old_name);
+        });
+    });
+}
+
+std::vector<std::size_t> ShardedAuthorRepository::FindNameShards(const std::string& name) {
+    const auto found = shards_.OnAllShards([&](pqxx::connection& connection) {
+        pqxx::read_transaction read{connection};
+        return Exec(shards_.GetTracer(), read, "SELECT count(*) FROM authors WHERE name = $1"_zv, name)
+                   .one_row()[0].as<std::int64_t>() > 0;
+    });
+    std::vector<std::size_t> shards;
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        if (found[i]) {
+            shards.push_back(i);
+        }
+    }
+    return shards;
+}
+
+std::size_t ShardedAuthorRepository::GetNameShard(const std::string& name) {
+    const auto shards = FindNameShards(name);
+    if (shards.empty()) {
+        throw std::runtime_error("Author " + name + " not found");
+    }
+    if (shards.size() > 1) {
+        throw std::runtime_error("Author " + name + " exists on more than one shard");
+    }
+    return shards.front();
+}
+
+void ShardedBookRepository::Save(const domain::Book& book) {
+    shards_.OnShard(shards_.GetShardOf(book.GetAuthorId().ToString()), [&](pqxx::connection& connection) {
+        BookRepositoryImpl{connection, shards_.GetTracer()}.Save(book);
+    });
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string>> ShardedBookRepository::ShowBooks() {
+    auto lists = shards_.OnAllShards([this](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, shards_.GetTracer()}.ShowBooks();
+    });
+    return MergeSorted(std::move(lists), TitleAuthorYearLess{});
+}
+
+domain::Stream<std::tuple<std::string, std::string, int, std::string>> ShardedBookRepository::StreamBooks() {
+    using Row = std::tuple<std::string, std::string, int, std::string>;
+    return MergeShardStreams<Row>(shards_, TitleAuthorYearLess{}, [tracer = shards_.GetTracer()](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, tracer}.StreamBooks();
+    });
+}
+
+domain::Stream<domain::Book> ShardedBookRepository::StreamBooksByAuthor() {
+    // All books of an author are on its shard, so the shards' streams one after another keep them grouped
+    return ChainShardStreams<domain::Book>(shards_, [tracer = shards_.GetTracer()](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, tracer}.StreamBooksByAuthor();
+    });
+}
+
+std::vector<domain::Book> ShardedBookRepository::GetAuthorBooks(const std::string& author_id) {
+    const auto shard = shards_.GetShardOf(author_id);
+    return shards_.OnShard(shard, [&](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, shards_.GetTracer()}.GetAuthorBooks(author_id);
+    });
+}
+
+std::vector<domain::Book> ShardedBookRepository::GetAuthorBooksPage(const std::string& author_id,
+                                                                    const std::optional<domain::AuthorBooksCursor>& after,
+                                                                    std::size_t limit) {
+    const auto shard = shards_.GetShardOf(author_id);
+    return shards_.OnShard(shard, [&](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, shards_.GetTracer()}.GetAuthorBooksPage(author_id, after, limit);
+    });
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShardedBookRepository::ShowBook(std::string& book_name) {
+    auto lists = shards_.OnAllShards([&](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, shards_.GetTracer()}.ShowBook(book_name);
+    });
+    // A shard lists its books of the title by id, so they are put in the merged order first
+    for (auto& list : lists) {
+        std::stable_sort(list.begin(), list.end(), TitleAuthorYearLess{});
+    }
+    return MergeSorted(std::move(lists), TitleAuthorYearLess{});
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShardedBookRepository::ShowBooksDetails(const std::vector<std::string>& book_ids) {
+    return Concatenate(shards_.OnAllShards([&](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, shards_.GetTracer()}.ShowBooksDetails(book_ids);
+    }));
+}
+
+void ShardedBookRepository::DeleteBook(std::string& book_id) {
+    shards_.OnOwningShard([&](pqxx::connection& connection) {
+        BookRepositoryImpl{connection, shards_.GetTracer()}.DeleteBook(book_id);
+    });
+}
+
+void ShardedBookRepository::EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) {
+    shards_.OnOwningShard([&](pqxx::connection& connection) {
+        BookRepositoryImpl{connection, shards_.GetTracer()}.EditBook(title, publication_year, tags, id);
+    });
+}
+
+domain::CatalogStats ShardedBookRepository::GetCatalogStats(domain::StatsSource source) {
+    auto shard_stats = shards_.OnAllShards([&](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, shards_.GetTracer()}.GetCatalogStats(source);
+    });
+
+    // An author lives on one shard, while tags and years are spread over all of them
+    domain::CatalogStats stats;
+    std::map<std::string, std::uint64_t> books_per_tag;
+    std::map<int, std::uint64_t> books_per_year;
+    for (auto& shard : shard_stats) {
+        stats.books += shard.books;
+        stats.books_per_author.insert(stats.books_per_author.end(), std::make_move_iterator(shard.books_per_author.begin()),
+                                      std::make_move_iterator(shard.books_per_author.end()));
+        for (auto& [tag, books] : shard.books_per_tag) {
+            books_per_tag[std::move(tag)] += books;
+        }
+        for (const auto& [year, books] : shard.books_per_year) {
+            books_per_year[year] += books;
+        }
+    }
+    std::sort(stats.books_per_author.begin(), stats.books_per_author.end());
+    stats.books_per_tag.assign(std::make_move_iterator(books_per_tag.begin()), std::make_move_iterator(books_per_tag.end()));
+    stats.books_per_year.assign(books_per_year.begin(), books_per_year.end());
+    return stats;
+}
+
+// Bulk changes by tag run on every shard, each shard in its own transaction
+std::uint64_t ShardedBookRepository::DeleteBooksByTag(const std::string& tag) {
+    const auto counts = shards_.OnAllShards([&](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, shards_.GetTracer()}.DeleteBooksByTag(tag);
+    });
+    return std::accumulate(counts.begin(), counts.end(), std::uint64_t{0});
+}
+
+std::uint64_t ShardedBookRepository::RetagBooks(const std::string& from, const std::string& to) {
+    const auto counts = shards_.OnAllShards([&](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, shards_.GetTracer()}.RetagBooks(from, to);
+    });
+    return std::accumulate(counts.begin(), counts.end(), std::uint64_t{0});
+}
+
+std::uint64_t ShardedBookRepository::DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) {
+    return shards_.OnShard(shards_.GetShardOf(author_id), [&](pqxx::connection& connection) {
+        return BookRepositoryImpl{connection, shards_.GetTracer()}.DeleteBooksByAuthorAndYearRange(author_id, min_year, max_year);
+    });
+}
+
+ShardedDatabase::ShardedDatabase(const std::vector<std::string>& shard_urls, std::size_t connections_per_shard,
+                                 QueryTracer* tracer)
+    : shards_{shard_urls, connections_per_shard, tracer} {
+}
+
+}  // namespace postgres
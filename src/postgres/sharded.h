@@ -0,0 +1,188 @@
+#pragma once
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <pqxx/except>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "../domain/author.h"
+#include "../domain/book.h"
+#include "connection_pool.h"
+#include "query_tracer.h"
+
+namespace postgres {
+
+// Postgres databases the catalog is split between. An author and all of the
+// author's books live on shard hash(AuthorId) % N, so the shard count must
+// not change once data is written.
+//
+// Queries that are not bound to one author are scattered over all shards
+// in parallel. Merged results keep the order of the per-shard results by
+// comparing strings bytewise, as the shards sort them with COLLATE "C".
+//
+// Streams read every shard through a cursor of its own, so one holds a connection of
+// each shard it reads until it ends or is dropped.
+//
+// Author names are unique across shards. The unique index of a shard only sees
+// its own names, so a name is checked on every shard while LockAuthorName holds it.
+class ShardSet {
+public:
+    ShardSet(const std::vector<std::string>& shard_urls, std::size_t connections_per_shard, QueryTracer* tracer = nullptr);
+
+    std::size_t GetSize() const noexcept {
+        return shards_.size();
+    }
+
+    QueryTracer* GetTracer() const noexcept {
+        return tracer_;
+    }
+
+    std::size_t GetShardOf(std::string_view author_id) const noexcept;
+
+    // A connection of the shard, held until the lease is dropped, e.g. for the cursor of a stream
+    ConnectionPool::Lease Acquire(std::size_t shard) {
+        return shards_[shard]->Acquire();
+    }
+
+    // Runs fn(pqxx::connection&) on the shard
+    template <typename Fn>
+    auto OnShard(std::size_t shard, Fn&& fn) {
+        auto connection = Acquire(shard);
+        return fn(*connection);
+    }
+
+    // Runs fn(pqxx::connection&) on every shard in parallel and returns the results in shard order
+    template <typename Fn>
+    auto OnAllShards(const Fn& fn) {
+        using Result = std::invoke_result_t<const Fn&, pqxx::connection&>;
+        std::vector<std::future<Result>> futures;
+        futures.reserve(shards_.size());
+        for (std::size_t i = 0; i < shards_.size(); ++i) {
+            futures.push_back(std::async(std::launch::async, [this, i, &fn] {
+                return OnShard(i, fn);
+            }));
+        }
+        if constexpr (std::is_void_v<Result>) {
+            for (auto& future : futures) {
+                future.get();
+            }
+        } else {
+            std::vector<Result> results;
+            results.reserve(futures.size());
+            for (auto& future : futures) {
+                results.push_back(future.get());
+            }
+            return results;
+        }
+    }
+
+    // For operations addressed by a book id, which does not tell the shard: runs fn on the
+    // shards one by one until it finds the row there. The repositories look the row up with
+    // one_row(), so pqxx::unexpected_rows means "not on this shard" and moves on to the next;
+    // any other error is thrown right away. The last not-found error is rethrown if no shard has it.
+    template <typename Fn>
+    void OnOwningShard(const Fn& fn) {
+        std::exception_ptr not_found;
+        for (std::size_t i = 0; i < shards_.size(); ++i) {
+            try {
+                OnShard(i, fn);
+                return;
+            } catch (const pqxx::unexpected_rows&) {
+                not_found = std::current_exception();
+            }
+        }
+        std::rethrow_exception(not_found);
+    }
+
+    // Runs fn() while no other writer, in this process or another one, gives an author the name.
+    // The lock is a session advisory lock on the first shard, keyed by a hash of the name.
+    void LockAuthorName(std::string_view name, const std::function<void()>& fn);
+
+private:
+    void ExecOnNamesConnection(pqxx::zview sql, std::int64_t key);
+
+    std::vector<std::unique_ptr<ConnectionPool>> shards_;
+    QueryTracer* tracer_;
+    // A connection of its own, so that the lock does not hold one of the pool's
+    std::string names_url_;
+    std::mutex names_mutex_;
+    std::unique_ptr<pqxx::connection> names_connection_;
+};
+
+class ShardedAuthorRepository : public domain::AuthorRepository {
+public:
+    explicit ShardedAuthorRepository(ShardSet& shards)
+        : shards_{shards}
+    {}
+
+    void Save(const domain::Author& author) override;
+    // Merged in name order
+    std::vector<domain::Author> GetAuthors() override;
+    domain::Stream<domain::Author> StreamAuthors() override;
+    void Delete(std::string& name) override;
+    void Edit(std::string& new_name, std::string& old_name) override;
+
+private:
+    // Shards having an author with the name, at most one unless written before names were checked
+    std::vector<std::size_t> FindNameShards(const std::string& name);
+    // The shard of the author with the name; throws if there is none or more than one
+    std::size_t GetNameShard(const std::string& name);
+
+    ShardSet& shards_;
+};
+
+class ShardedBookRepository : public domain::BookRepository {
+public:
+    explicit ShardedBookRepository(ShardSet& shards)
+        : shards_{shards}
+    {}
+
+    void Save(const domain::Book& book) override;
+    // k-way merge of the shards' lists, keeping the title, author, year order
+    std::vector<std::tuple<std::string, std::string, int, std::string>> ShowBooks() override;
+    domain::Stream<std::tuple<std::string, std::string, int, std::string>> StreamBooks() override;
+    domain::Stream<domain::Book> StreamBooksByAuthor() override;
+    std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) override;
+    std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                 const std::optional<domain::AuthorBooksCursor>& after,
+                                                 std::size_t limit) override;
+    // Merged in the order of ShowBooks
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBook(std::string& book_name) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBooksDetails(const std::vector<std::string>& book_ids) override;
+    void DeleteBook(std::string& book_id) override;
+    void EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) override;
+    domain::CatalogStats GetCatalogStats(domain::StatsSource source) override;
+    std::uint64_t DeleteBooksByTag(const std::string& tag) override;
+    std::uint64_t RetagBooks(const std::string& from, const std::string& to) override;
+    std::uint64_t DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) override;
+
+private:
+    ShardSet& shards_;
+};
+
+// Counterpart of Database for a sharded catalog
+class ShardedDatabase {
+public:
+    ShardedDatabase(const std::vector<std::string>& shard_urls, std::size_t connections_per_shard,
+                    QueryTracer* tracer = nullptr);
+
+    ShardedAuthorRepository& GetAuthors() & {
+        return authors_;
+    }
+
+    ShardedBookRepository& GetBooks() & {
+        return books_;
+    }
+
+private:
+    ShardSet shards_;
+    ShardedAuthorRepository authors_{shards_};
+    ShardedBookRepository books_{shards_};
+};
+
+}  // namespace postgres
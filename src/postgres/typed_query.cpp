@@ -0,0 +1,13 @@
+#include "typed_query.h"
+
+#include <cstdio>
+
+namespace postgres::detail {
+
+std::string GetStatementName(std::uint64_t statement_id) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "typed_%016llx", static_cast<unsigned long long>(statement_id));
+    return name;
+}
+
+}  // namespace postgres::detail
@@ -0,0 +1,329 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <pqxx/connection>
+#include <pqxx/result>
+#include <pqxx/transaction>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../domain/author.h"
+#include "../domain/book.h"
+#include "../domain/stream.h"
+#include "query_tracer.h"
+
+namespace postgres {
+
+// SQL text as a template argument
+template <std::size_t N>
+struct SqlText {
+    constexpr SqlText(const char (&text)[N]) {
+        std::copy_n(text, N, data);
+    }
+
+    constexpr std::string_view View() const noexcept {
+        return {data, N - 1};
+    }
+
+    char data[N]{};
+};
+
+template <typename... Ts>
+struct Columns {
+    static constexpr std::size_t COUNT = sizeof...(Ts);
+};
+
+template <typename... Ts>
+struct Params {
+    static constexpr std::size_t COUNT = sizeof...(Ts);
+};
+
+namespace sql {
+
+constexpr char ToUpper(char c) noexcept {
+    return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+constexpr bool IsWordChar(char c) noexcept {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+constexpr bool IsKeywordAt(std::string_view text, std::size_t pos, std::string_view keyword) noexcept {
+    if (text.size() - pos < keyword.size() || (pos > 0 && IsWordChar(text[pos - 1]))) {
+        return false;
+    }
+    for (std::size_t i = 0; i < keyword.size(); ++i) {
+        if (ToUpper(text[pos + i]) != keyword[i]) {
+            return false;
+        }
+    }
+    return pos + keyword.size() == text.size() || !IsWordChar(text[pos + keyword.size()]);
+}
+
+// Position after the literal or quoted identifier starting at pos
+constexpr std::size_t SkipQuoted(std::string_view text, std::size_t pos) noexcept {
+    const auto quote = text[pos];
+    for (++pos; pos < text.size(); ++pos) {
+        if (text[pos] == quote) {
+            // A doubled quote stands for the quote itself
+            if (pos + 1 < text.size() && text[pos + 1] == quote) {
+                ++pos;
+            } else {
+                return pos + 1;
+            }
+        }
+    }
+    return pos;
+}
+
+// Number of result columns: items of the first SELECT or RETURNING list outside parentheses,
+// which is the outer query of a WITH statement too
+constexpr std::size_t CountResultColumns(std::string_view text) noexcept {
+    int depth = 0;
+    std::size_t columns = 0;
+    for (std::size_t pos = 0; pos < text.size();) {
+        const auto c = text[pos];
+        if (c == '\'' || c == '"') {
+            pos = SkipQuoted(text, pos);
+            continue;
+        }
+        if (c == '(') {
+            ++depth;
+        } else if (c == ')') {
+            --depth;
+        } else if (depth == 0) {
+            if (columns == 0) {
+                for (const auto keyword : {std::string_view{"SELECT"}, std::string_view{"RETURNING"}}) {
+                    if (IsKeywordAt(text, pos, keyword)) {
+                        columns = 1;
+                        pos += keyword.size();
+                        break;
+                    }
+                }
+                if (columns != 0) {
+                    continue;
+                }
+            } else if (c == ',') {
+                ++columns;
+            } else if (c == ';' || IsKeywordAt(text, pos, "FROM")) {
+                return columns;
+            }
+        }
+        ++pos;
+    }
+    return columns;
+}
+
+// Highest $n placeholder of the statement
+constexpr std::size_t CountParams(std::string_view text) noexcept {
+    std::size_t params = 0;
+    for (std::size_t pos = 0; pos < text.size();) {
+        if (text[pos] == '\'' || text[pos] == '"') {
+            pos = SkipQuoted(text, pos);
+            continue;
+        }
+        if (text[pos++] == '$') {
+            std::size_t number = 0;
+            for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+                number = number * 10 + static_cast<std::size_t>(text[pos] - '0');
+            }
+            params = std::max(params, number);
+        }
+    }
+    return params;
+}
+
+constexpr std::uint64_t Hash(std::string_view text) noexcept {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}  // namespace sql
+
+/**
+ * How rows are turned into a type: the column types, and a static Make taking one
+ * argument per column. Specializations for domain types follow the query descriptor.
+ * A mapping may take std::string_view columns; such rows only live as long as
+ * the pqxx::result, so they are read with ForEachRow rather than Fetch.
+ */
+template <typename Row>
+struct RowMapping;
+
+template <typename... Ts>
+struct RowMapping<std::tuple<Ts...>> {
+    using ColumnTypes = Columns<Ts...>;
+
+    static std::tuple<Ts...> Make(Ts... values) {
+        return {std::move(values)...};
+    }
+};
+
+/**
+ * Statement with its parameter and result types checked at compile time.
+ *
+ * The statement must take exactly ParamTypes::COUNT placeholders, and its result list
+ * must have as many columns as the row mapping decodes, whose Make must accept them.
+ * Without a tracer, the statement runs by name, so it must have been prepared with PrepareQueries
+ * when the connection was set up; with one, it runs as text, so the tracer can normalize and explain it.
+ */
+template <SqlText Text, typename Row, typename ParamTypes = Params<>>
+struct Query;
+
+template <SqlText Text, typename Row, typename... ParamTs>
+struct Query<Text, Row, Params<ParamTs...>> {
+    using RowType = Row;
+    using Mapping = RowMapping<Row>;
+
+    static constexpr std::string_view SQL = Text.View();
+    static constexpr std::uint64_t ID = sql::Hash(SQL);
+
+    static_assert(sql::CountParams(SQL) == sizeof...(ParamTs),
+                  "The statement's placeholders differ from the declared parameters");
+    static_assert(sql::CountResultColumns(SQL) == Mapping::ColumnTypes::COUNT,
+                  "The statement's result columns differ from the columns of the row mapping");
+
+    template <typename... Args>
+    static constexpr bool ACCEPTS = sizeof...(Args) == sizeof...(ParamTs) && (std::is_convertible_v<const Args&, ParamTs> && ...);
+};
+
+namespace detail {
+
+template <typename Mapping, typename... ColumnTs, std::size_t... I>
+auto DecodeRow(const pqxx::row& row, Columns<ColumnTs...>, std::index_sequence<I...>) {
+    static_assert(std::is_invocable_v<decltype(&Mapping::Make), ColumnTs...>,
+                  "The row mapping's Make does not take the mapping's column types");
+    return Mapping::Make(row[static_cast<int>(I)].template as<ColumnTs>()...);
+}
+
+template <typename Mapping, typename... ColumnTs>
+auto DecodeRow(const pqxx::row& row, Columns<ColumnTs...> columns) {
+    return DecodeRow<Mapping>(row, columns, std::index_sequence_for<ColumnTs...>{});
+}
+
+std::string GetStatementName(std::uint64_t statement_id);
+
+template <typename... Args>
+pqxx::result RunText(QueryTracer* tracer, pqxx::transaction_base& tx, pqxx::zview sql, const Args&... args) {
+    return tracer ? tracer->Exec(tx, sql, args...) : tx.exec_params(sql, args...);
+}
+
+template <typename Q, typename... Args>
+pqxx::result Run(QueryTracer* tracer, pqxx::transaction_base& tx, const Args&... args) {
+    static_assert(Q::template ACCEPTS<Args...>, "The arguments do not match the declared parameters");
+    const pqxx::zview sql{Q::SQL.data(), Q::SQL.size()};
+    if (tracer) {
+        return RunText(tracer, tx, sql, args...);
+    }
+    return tx.exec_prepared(GetStatementName(Q::ID), args...);
+}
+
+}  // namespace detail
+
+// Prepares the queries on the connection under the names they are run by. Prepared statements
+// live as long as the connection's session, so this is done once, right after connecting;
+// the tables they read must exist by then.
+template <typename... Qs>
+void PrepareQueries(pqxx::connection& connection) {
+    (connection.prepare(detail::GetStatementName(Qs::ID), pqxx::zview{Qs::SQL.data(), Qs::SQL.size()}), ...);
+}
+
+// Runs the query and decodes every row into the query's row type
+template <typename Q, typename... Args>
+std::vector<typename Q::RowType> Fetch(QueryTracer* tracer, pqxx::transaction_base& tx, const Args&... args) {
+    const auto result = detail::Run<Q>(tracer, tx, args...);
+    std::vector<typename Q::RowType> rows;
+    rows.reserve(result.size());
+    for (const auto& row : result) {
+        rows.push_back(detail::DecodeRow<typename Q::Mapping>(row, typename Q::Mapping::ColumnTypes{}));
+    }
+    return rows;
+}
+
+// Runs the query and calls fn with every decoded row, while the result is alive
+template <typename Q, typename Fn, typename... Args>
+void ForEachRow(QueryTracer* tracer, pqxx::transaction_base& tx, Fn&& fn, const Args&... args) {
+    const auto result = detail::Run<Q>(tracer, tx, args...);
+    for (const auto& row : result) {
+        fn(detail::DecodeRow<typename Q::Mapping>(row, typename Q::Mapping::ColumnTypes{}));
+    }
+}
+
+/**
+ * Stream source reading the query's rows through a server-side cursor, a FETCH per batch.
+ *
+ * The cursor lives in a read transaction of its own, which takes the connection: nothing else
+ * can run on it until the last batch has been fetched, which ends the transaction, or the
+ * source is dropped. Cursor statements can't be prepared, so they always run as text.
+ */
+template <typename Q>
+class CursorSource : public domain::Stream<typename Q::RowType>::Source {
+public:
+    static constexpr std::size_t BATCH_SIZE = 1000;
+
+    template <typename... Args>
+    CursorSource(pqxx::connection& connection, QueryTracer* tracer, const Args&... args)
+        : tracer_{tracer}
+        , tx_{std::make_unique<pqxx::read_transaction>(connection)} {
+        static_assert(Q::template ACCEPTS<Args...>, "The arguments do not match the declared parameters");
+        const auto declare = "DECLARE typed_cursor NO SCROLL CURSOR FOR " + std::string{Q::SQL};
+        detail::RunText(tracer_, *tx_, declare, args...);
+    }
+
+    void FetchBatch(std::vector<typename Q::RowType>& batch) override {
+        batch.clear();
+        if (!tx_) {
+            return;
+        }
+        static const auto fetch = "FETCH " + std::to_string(BATCH_SIZE) + " FROM typed_cursor;";
+        const auto result = detail::RunText(tracer_, *tx_, fetch);
+        batch.reserve(result.size());
+        for (const auto& row : result) {
+            batch.push_back(detail::DecodeRow<typename Q::Mapping>(row, typename Q::Mapping::ColumnTypes{}));
+        }
+        if (result.size() < BATCH_SIZE) {
+            tx_->commit();
+            tx_.reset();
+        }
+    }
+
+private:
+    QueryTracer* tracer_;
+    std::unique_ptr<pqxx::read_transaction> tx_;
+};
+
+// Streams the query's rows, see CursorSource
+template <typename Q, typename... Args>
+domain::Stream<typename Q::RowType> StreamRows(pqxx::connection& connection, QueryTracer* tracer, const Args&... args) {
+    return domain::Stream<typename Q::RowType>{std::make_unique<CursorSource<Q>>(connection, tracer, args...)};
+}
+
+template <>
+struct RowMapping<domain::Author> {
+    using ColumnTypes = Columns<std::string, std::string>;
+
+    static domain::Author Make(std::string id, std::string name) {
+        return {domain::AuthorId::FromString(id), std::move(name)};
+    }
+};
+
+// Books without their tags: id, author id, title, publication year
+template <>
+struct RowMapping<domain::Book> {
+    using ColumnTypes = Columns<std::string, std::string, std::string, int>;
+
+    static domain::Book Make(std::string id, std::string author_id, std::string title, int publication_year) {
+        return {domain::BookId::FromString(id), domain::AuthorId::FromString(author_id), std::move(title),
+                publication_year, std::nullopt};
+    }
+};
+
+}  // namespace postgres
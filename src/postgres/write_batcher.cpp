@@ -0,0 +1,26 @@
+#include "write_batcher.h"
+
+namespace postgres {
+
+using pqxx::operator"" _zv;
+
+namespace {
+
+void LockForSaves(pqxx::transaction_base& work) {
+    work.exec("LOCK TABLE authors, books, book_tags IN SHARE ROW EXCLUSIVE MODE"_zv);
+    work.exec("LOCK TABLE catalog_events IN EXCLUSIVE MODE"_zv);
+}
+
+}  // namespace
+
+WriteBatcher::WriteBatcher(std::string db_url, Config config, std::function<void(pqxx::connection&)> setup)
+    : BasicWriteBatcher{[db_url = std::move(db_url), setup = std::move(setup)] {
+        pqxx::connection connection{db_url};
+        if (setup) {
+            setup(connection);
+        }
+        return connection;
+    }, config, LockForSaves} {
+}
+
+}  // namespace postgres
@@ -0,0 +1,204 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <pqxx/connection>
+#include <pqxx/except>
+#include <pqxx/subtransaction>
+#include <pqxx/transaction>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace postgres {
+
+/**
+ * Group commit for small writes of many sessions.
+ *
+ * Writes submitted from any thread are queued and run on the batcher's own connection,
+ * in one transaction per batch, so a batch waits for one WAL flush instead of one per write.
+ * A batch is taken when the window since its first write has passed or it has max_writes
+ * writes, whichever comes first. Every write runs under a savepoint of its own: one that
+ * fails is rolled back alone, and the rest of the batch is still committed.
+ *
+ * The transaction of a batch starts with the lock step, which takes every lock the writes
+ * need at once and in a fixed order; the writes take none of their own.
+ *
+ * A batch that loses the connection, BrokenConnection thrown by a write or the commit, fails
+ * as a whole. The batcher then opens a new connection with connect before the next batch;
+ * if that fails too, the next batch gets the error and the one after it tries again.
+ *
+ * The connection, transaction, savepoint and error types are parameters so that tests can run
+ * the batching on stubs; WriteBatcher below is the one for Postgres.
+ */
+template <typename Connection, typename Work, typename Savepoint, typename Transaction, typename BrokenConnection>
+class BasicWriteBatcher {
+public:
+    // Runs the statements of one write in the transaction of its batch
+    using Write = std::function<void(Transaction& tx)>;
+    // Opens a connection ready for the writes, with whatever they prepare on it
+    using Connect = std::function<Connection()>;
+
+    struct Config {
+        // How long the first write of a batch waits for others to join it
+        std::chrono::microseconds window{1000};
+        // A batch is committed as soon as it has this many writes
+        std::size_t max_writes = 64;
+    };
+
+    // The first connection is opened right away, so that a database that can't be reached is reported here
+    BasicWriteBatcher(Connect connect, Config config, Write lock)
+        : connect_{std::move(connect)}
+        , connection_{connect_()}
+        , config_{config.window, std::max<std::size_t>(config.max_writes, 1)}
+        , lock_{std::move(lock)}
+        , thread_{[this] {
+            Run();
+        }} {
+    }
+
+    // Commits the writes queued so far
+    ~BasicWriteBatcher() {
+        {
+            std::lock_guard lock{mutex_};
+            stopping_ = true;
+        }
+        queue_changed_.notify_one();
+        thread_.join();
+    }
+
+    BasicWriteBatcher(const BasicWriteBatcher&) = delete;
+    BasicWriteBatcher& operator=(const BasicWriteBatcher&) = delete;
+
+    // The future becomes ready when the batch of the write is committed. It holds the write's
+    // error if the write failed, or the error of the lock step or the commit if the batch could not be committed.
+    std::future<void> Submit(Write write) {
+        Pending pending{std::move(write), {}, Clock::now()};
+        auto committed = pending.committed.get_future();
+        bool wake = false;
+        {
+            std::lock_guard lock{mutex_};
+            queue_.push_back(std::move(pending));
+            // The batcher waits either for a first write or for a batch to fill up
+            wake = queue_.size() == 1 || queue_.size() >= config_.max_writes;
+        }
+        if (wake) {
+            queue_changed_.notify_one();
+        }
+        return committed;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        Write write;
+        std::promise<void> committed;
+        Clock::time_point queued;
+    };
+
+    void Run() {
+        std::vector<Pending> batch;
+        while (true) {
+            {
+                std::unique_lock lock{mutex_};
+                queue_changed_.wait(lock, [this] {
+                    return stopping_ || !queue_.empty();
+                });
+                if (queue_.empty()) {
+                    return;
+                }
+                queue_changed_.wait_until(lock, queue_.front().queued + config_.window, [this] {
+                    return stopping_ || queue_.size() >= config_.max_writes;
+                });
+                const auto size = static_cast<std::ptrdiff_t>(std::min(queue_.size(), config_.max_writes));
+                batch.assign(std::make_move_iterator(queue_.begin()), std::make_move_iterator(queue_.begin() + size));
+                queue_.erase(queue_.begin(), queue_.begin() + size);
+            }
+            Commit(batch);
+            batch.clear();
+        }
+    }
+
+    void Commit(std::vector<Pending>& batch) {
+        std::vector<std::exception_ptr> errors(batch.size());
+        try {
+            if (!connection_) {
+                connection_.emplace(connect_());
+            }
+            Work work{*connection_};
+            lock_(work);
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                Savepoint savepoint{work};
+                try {
+                    batch[i].write(savepoint);
+                    savepoint.commit();
+                } catch (const BrokenConnection&) {
+                    // Not the write's fault; nothing else can run on the connection either
+                    throw;
+                } catch (const std::exception&) {
+                    // The savepoint is rolled back as it goes out of scope, undoing this write only
+                    errors[i] = std::current_exception();
+                }
+            }
+            work.commit();
+        } catch (const BrokenConnection&) {
+            // The transaction using it is gone by now; the next batch opens another one
+            connection_.reset();
+            FailAll(batch, std::current_exception());
+            return;
+        } catch (const std::exception&) {
+            FailAll(batch, std::current_exception());
+            return;
+        }
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            if (errors[i]) {
+                batch[i].committed.set_exception(errors[i]);
+            } else {
+                batch[i].committed.set_value();
+            }
+        }
+    }
+
+    // Nothing of the batch is committed, so every write gets the error
+    static void FailAll(std::vector<Pending>& batch, const std::exception_ptr& error) {
+        for (auto& pending : batch) {
+            pending.committed.set_exception(error);
+        }
+    }
+
+    Connect connect_;
+    // Empty after the connection broke, until the next batch opens another one
+    std::optional<Connection> connection_;
+    Config config_;
+    Write lock_;
+    std::mutex mutex_;
+    std::condition_variable queue_changed_;
+    std::deque<Pending> queue_;
+    bool stopping_ = false;
+    // Started last, once everything it uses is constructed
+    std::thread thread_;
+};
+
+/**
+ * Group commit of AuthorRepositoryImpl::Save and BookRepositoryImpl::Save.
+ *
+ * A batch locks authors, books and book_tags in SHARE ROW EXCLUSIVE mode and then the change log,
+ * the order every write of the repositories follows. The mode keeps other writers out as the
+ * locks of a single save do, but lets readers in while the batch runs.
+ */
+class WriteBatcher : public BasicWriteBatcher<pqxx::connection, pqxx::work, pqxx::subtransaction,
+                                              pqxx::transaction_base, pqxx::broken_connection> {
+public:
+    // Runs setup on each connection it opens, the first one and those replacing a broken one
+    WriteBatcher(std::string db_url, Config config, std::function<void(pqxx::connection&)> setup = {});
+};
+
+}  // namespace postgres
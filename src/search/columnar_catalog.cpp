@@ -0,0 +1,159 @@
+#include "columnar_catalog.h"
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include "../domain/book.h"
+
+namespace search {
+
+namespace {
+
+// Smaller ranges are not worth a thread of their own
+constexpr std::size_t MIN_ROWS_PER_THREAD = 1 << 16;
+
+}  // namespace
+
+void ColumnarCatalog::StringColumn::Reserve(std::size_t rows, std::size_t bytes) {
+    offsets_.reserve(rows + 1);
+    bytes_.reserve(bytes + rows);
+}
+
+void ColumnarCatalog::StringColumn::Append(std::string_view value) {
+    bytes_ += value;
+    bytes_ += '\0';
+    offsets_.push_back(bytes_.size());
+}
+
+std::string_view ColumnarCatalog::StringColumn::Get(std::size_t row) const noexcept {
+    return std::string_view{bytes_}.substr(offsets_[row], offsets_[row + 1] - offsets_[row] - 1);
+}
+
+void ColumnarCatalog::StringColumn::Filter(std::string_view lower_needle, std::uint32_t begin, std::uint32_t end,
+                                           ScanLevel level, std::vector<char>& selected) const {
+    std::vector<char> found(end - begin, 0);
+    const std::string_view bytes{bytes_};
+    auto position = offsets_[begin];
+    const auto stop = offsets_[end];
+    auto row = begin;
+    // One scan over the whole range; after a match the rest of its row is skipped
+    while (position < stop) {
+        const auto match = FindIgnoreCase(bytes.substr(position, stop - position), lower_needle, level);
+        if (match == std::string_view::npos) {
+            break;
+        }
+        const auto match_position = position + match;
+        row = static_cast<std::uint32_t>(
+            std::upper_bound(offsets_.begin() + row + 1, offsets_.begin() + end + 1, match_position)
+            - offsets_.begin() - 1);
+        if (match_position + lower_needle.size() < offsets_[row + 1]) {
+            found[row - begin] = 1;
+        }
+        position = offsets_[row + 1];
+    }
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        selected[i] &= found[i];
+    }
+}
+
+ColumnarCatalog::ColumnarCatalog(const std::vector<BookRow>& rows) {
+    if (rows.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error("Too many books for a columnar catalog");
+    }
+    std::size_t title_bytes = 0;
+    std::size_t author_bytes = 0;
+    std::size_t id_bytes = 0;
+    for (const auto& [title, author, year, id] : rows) {
+        title_bytes += title.size();
+        author_bytes += author.size();
+        id_bytes += id.size();
+    }
+    titles_.Reserve(rows.size(), title_bytes);
+    authors_.Reserve(rows.size(), author_bytes);
+    ids_.Reserve(rows.size(), id_bytes);
+    years_.reserve(rows.size());
+
+    for (const auto& [title, author, year, id] : rows) {
+        titles_.Append(title);
+        authors_.Append(author);
+        ids_.Append(id);
+        years_.push_back(year);
+    }
+}
+
+ColumnarCatalog ColumnarCatalog::Load(domain::BookRepository& books) {
+    return ColumnarCatalog{books.ShowBooks()};
+}
+
+ColumnarCatalog::BookRow ColumnarCatalog::GetRow(std::size_t index) const {
+    return {std::string{titles_.Get(index)}, std::string{authors_.Get(index)}, years_.at(index),
+            std::string{ids_.Get(index)}};
+}
+
+void ColumnarCatalog::FindInRange(const Query& query, std::uint32_t begin, std::uint32_t end, ScanLevel level,
+                                  std::vector<std::uint32_t>& rows) const {
+    std::vector<char> selected(end - begin, 1);
+    if (query.min_year || query.max_year) {
+        const auto min_year = query.min_year.value_or(std::numeric_limits<int>::min());
+        const auto max_year = query.max_year.value_or(std::numeric_limits<int>::max());
+        // Branch-free, so the compiler vectorizes it
+        for (std::uint32_t i = begin; i < end; ++i) {
+            selected[i - begin] = (years_[i] >= min_year) & (years_[i] <= max_year);
+        }
+    }
+    if (!query.title_contains.empty()) {
+        titles_.Filter(query.title_contains, begin, end, level, selected);
+    }
+    if (!query.author_contains.empty()) {
+        authors_.Filter(query.author_contains, begin, end, level, selected);
+    }
+    for (std::uint32_t i = begin; i < end; ++i) {
+        if (selected[i - begin]) {
+            rows.push_back(i);
+        }
+    }
+}
+
+std::vector<std::uint32_t> ColumnarCatalog::Find(const Query& query, const ScanOptions& options) const {
+    Query lower_query = query;
+    lower_query.title_contains = ToLowerAscii(query.title_contains);
+    lower_query.author_contains = ToLowerAscii(query.author_contains);
+
+    const auto size = static_cast<std::uint32_t>(GetSize());
+    const std::size_t cores = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const auto parts = std::clamp<std::size_t>(size / MIN_ROWS_PER_THREAD, 1, cores);
+    const auto part_size = static_cast<std::uint32_t>((size + parts - 1) / parts);
+
+    std::vector<std::vector<std::uint32_t>> part_rows(parts);
+    std::vector<std::future<void>> scans;
+    for (std::size_t part = 1; part < parts; ++part) {
+        const auto begin = static_cast<std::uint32_t>(std::min<std::size_t>(part * part_size, size));
+        const auto end = static_cast<std::uint32_t>(std::min<std::size_t>(begin + std::size_t{part_size}, size));
+        scans.push_back(std::async(std::launch::async, [&, part, begin, end] {
+            FindInRange(lower_query, begin, end, options.level, part_rows[part]);
+        }));
+    }
+    FindInRange(lower_query, 0, std::min(part_size, size), options.level, part_rows[0]);
+    for (auto& scan : scans) {
+        scan.get();
+    }
+
+    std::vector<std::uint32_t> rows;
+    for (const auto& part : part_rows) {
+        rows.insert(rows.end(), part.begin(), part.end());
+    }
+    return rows;
+}
+
+std::vector<ColumnarCatalog::BookRow> ColumnarCatalog::Search(const Query& query, const ScanOptions& options) const {
+    std::vector<BookRow> result;
+    for (const auto row : Find(query, options)) {
+        result.push_back(GetRow(row));
+    }
+    return result;
+}
+
+}  // namespace search
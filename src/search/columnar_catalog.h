@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "../domain/book_fwd.h"
+#include "substring_scan.h"
+
+namespace search {
+
+// Conditions a book has to meet, all of them; empty strings and missing years match anything
+struct Query {
+    std::string title_contains;
+    std::string author_contains;
+    std::optional<int> min_year;
+    std::optional<int> max_year;
+};
+
+struct ScanOptions {
+    // 0 uses every core
+    std::size_t threads = 0;
+    ScanLevel level = GetSupportedScanLevel();
+};
+
+/**
+ * Copy of the catalog laid out column by column, for substring searches nothing is indexed for.
+ *
+ * Titles, author names and ids are each concatenated into one byte column with an offset array;
+ * years are an int32 column. A query brute-forces the columns: the year range is filtered first,
+ * then every string condition scans its whole column with a vectorized, ASCII case-insensitive
+ * substring search. Row ranges are scanned on all cores in parallel.
+ *
+ * The copy does not follow later changes of the catalog; load a new one instead.
+ */
+class ColumnarCatalog {
+public:
+    // Title, author name, publication year and id, as listed by ShowBooks
+    using BookRow = std::tuple<std::string, std::string, int, std::string>;
+
+    ColumnarCatalog() = default;
+    explicit ColumnarCatalog(const std::vector<BookRow>& rows);
+
+    static ColumnarCatalog Load(domain::BookRepository& books);
+
+    std::size_t GetSize() const noexcept {
+        return years_.size();
+    }
+
+    BookRow GetRow(std::size_t index) const;
+
+    // Indexes of the matching rows in catalog order
+    std::vector<std::uint32_t> Find(const Query& query, const ScanOptions& options = {}) const;
+    std::vector<BookRow> Search(const Query& query, const ScanOptions& options = {}) const;
+
+private:
+    // Row i is bytes[offsets[i], offsets[i + 1] - 1) followed by a '\0' separator,
+    // so a match of a needle without '\0' never spans two rows
+    class StringColumn {
+    public:
+        void Reserve(std::size_t rows, std::size_t bytes);
+        void Append(std::string_view value);
+        std::string_view Get(std::size_t row) const noexcept;
+        // Clears `selected` for the rows of [begin, end) not containing the needle
+        void Filter(std::string_view lower_needle, std::uint32_t begin, std::uint32_t end, ScanLevel level,
+                    std::vector<char>& selected) const;
+
+    private:
+        std::string bytes_;
+        std::vector<std::uint64_t> offsets_{0};
+    };
+
+    void FindInRange(const Query& query, std::uint32_t begin, std::uint32_t end, ScanLevel level,
+                     std::vector<std::uint32_t>& rows) const;
+
+    StringColumn titles_;
+    StringColumn authors_;
+    StringColumn ids_;
+    std::vector<std::int32_t> years_;
+};
+
+}  // namespace search
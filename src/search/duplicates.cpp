@@ -0,0 +1,259 @@
+#include "duplicates.h"
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+#include "../domain/author.h"
+#include "../domain/book.h"
+
+namespace search {
+
+namespace {
+
+// Authors are buffered until the batch holds this many books
+constexpr std::size_t BATCH_BOOKS = 1 << 18;
+// Smaller shares of a batch are not worth a thread of their own
+constexpr std::size_t MIN_BOOKS_PER_THREAD = 1 << 12;
+
+constexpr std::uint64_t Mix(std::uint64_t value) noexcept {
+    // splitmix64 finalizer
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// Hash function i of the signature is (a[i] * shingle hash + b[i]) / 2^32 with odd a[i]
+struct HashFamily {
+    std::array<std::uint64_t, DuplicateFinder::SIGNATURE_SIZE> a;
+    std::array<std::uint64_t, DuplicateFinder::SIGNATURE_SIZE> b;
+};
+
+constexpr HashFamily MakeHashFamily() noexcept {
+    HashFamily family{};
+    std::uint64_t seed = 0x5D1B00C5;
+    for (std::size_t i = 0; i < DuplicateFinder::SIGNATURE_SIZE; ++i) {
+        family.a[i] = Mix(seed += 0x9E3779B97F4A7C15ULL) | 1;
+        family.b[i] = Mix(seed += 0x9E3779B97F4A7C15ULL);
+    }
+    return family;
+}
+
+constexpr HashFamily HASH_FAMILY = MakeHashFamily();
+
+bool IsWordByte(unsigned char c) noexcept {
+    // Bytes of multibyte UTF-8 characters are kept as they are
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+unsigned char ToLower(unsigned char c) noexcept {
+    return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+// Calls `on_shingle` with the hash of every character trigram of every word of the title;
+// words are padded with a space on both sides, so one-letter words have a shingle too
+template <typename Handler>
+void ForEachShingle(std::string_view title, Handler&& on_shingle) {
+    std::uint64_t window = ' ';
+    std::size_t filled = 1;
+    bool in_word = false;
+    const auto push = [&](unsigned char c) {
+        window = (window << 8 | c) & 0xFFFFFF;
+        if (++filled >= 3) {
+            on_shingle(Mix(window));
+        }
+    };
+    for (const auto c : title) {
+        const auto byte = static_cast<unsigned char>(c);
+        if (IsWordByte(byte)) {
+            if (!in_word) {
+                window = ' ';
+                filled = 1;
+                in_word = true;
+            }
+            push(ToLower(byte));
+        } else if (in_word) {
+            push(' ');
+            in_word = false;
+        }
+    }
+    if (in_word) {
+        push(' ');
+    }
+}
+
+double GetAgreement(const DuplicateFinder::Signature& lhs, const DuplicateFinder::Signature& rhs) noexcept {
+    std::size_t equal = 0;
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        equal += lhs[i] == rhs[i];
+    }
+    return static_cast<double>(equal) / static_cast<double>(lhs.size());
+}
+
+std::uint32_t FindRoot(std::vector<std::uint32_t>& parents, std::uint32_t book) noexcept {
+    while (parents[book] != book) {
+        book = parents[book] = parents[parents[book]];
+    }
+    return book;
+}
+
+}  // namespace
+
+DuplicateFinder::DuplicateFinder(GroupHandler handler, DuplicateOptions options)
+    : handler_{std::move(handler)}
+    , options_{options}
+    , threads_{options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency())} {
+}
+
+DuplicateFinder::Signature DuplicateFinder::ComputeSignature(std::string_view title) {
+    Signature signature;
+    signature.fill(std::numeric_limits<std::uint32_t>::max());
+    ForEachShingle(title, [&signature](std::uint64_t shingle) {
+        for (std::size_t i = 0; i < SIGNATURE_SIZE; ++i) {
+            const auto value = static_cast<std::uint32_t>((HASH_FAMILY.a[i] * shingle + HASH_FAMILY.b[i]) >> 32);
+            signature[i] = std::min(signature[i], value);
+        }
+    });
+    return signature;
+}
+
+void DuplicateFinder::Add(std::string_view author_id, std::string_view author, DuplicateBook book) {
+    if (authors_.empty() || authors_.back().id != author_id) {
+        if (books_.size() >= BATCH_BOOKS) {
+            ProcessBatch();
+        }
+        authors_.push_back({std::string{author_id}, std::string{author}, books_.size(), books_.size()});
+    }
+    books_.push_back(std::move(book));
+    ++authors_.back().end_book;
+}
+
+void DuplicateFinder::Finish() {
+    ProcessBatch();
+}
+
+void DuplicateFinder::ProcessBatch() {
+    // Contiguous runs of authors with about the same number of books each
+    const auto parts = std::clamp<std::size_t>(books_.size() / MIN_BOOKS_PER_THREAD, 1, threads_);
+    const auto part_books = (books_.size() + parts - 1) / parts;
+    std::vector<std::size_t> part_ends;
+    for (std::size_t author = 0; author < authors_.size(); ++author) {
+        if (authors_[author].end_book >= (part_ends.size() + 1) * part_books || author + 1 == authors_.size()) {
+            part_ends.push_back(author + 1);
+        }
+    }
+
+    std::vector<std::vector<DuplicateGroup>> groups(part_ends.size());
+    std::vector<std::future<void>> parts_done;
+    for (std::size_t part = 1; part < part_ends.size(); ++part) {
+        parts_done.push_back(std::async(std::launch::async, [this, &groups, &part_ends, part] {
+            GroupAuthors(part_ends[part - 1], part_ends[part], groups[part]);
+        }));
+    }
+    if (!part_ends.empty()) {
+        GroupAuthors(0, part_ends[0], groups[0]);
+    }
+    for (auto& part_done : parts_done) {
+        part_done.get();
+    }
+
+    authors_.clear();
+    books_.clear();
+    for (auto& part_groups : groups) {
+        for (auto& group : part_groups) {
+            handler_(std::move(group));
+        }
+    }
+}
+
+void DuplicateFinder::GroupAuthors(std::size_t begin, std::size_t end, std::vector<DuplicateGroup>& groups) const {
+    std::vector<Signature> signatures;
+    std::vector<std::uint32_t> parents;
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> band_keys;
+    for (auto author = begin; author < end; ++author) {
+        const auto& [author_id, author_name, first_book, end_book] = authors_[author];
+        const auto count = static_cast<std::uint32_t>(end_book - first_book);
+        if (count < 2) {
+            continue;
+        }
+
+        signatures.clear();
+        for (auto book = first_book; book < end_book; ++book) {
+            signatures.push_back(ComputeSignature(books_[book].title));
+        }
+        parents.resize(count);
+        std::iota(parents.begin(), parents.end(), 0);
+
+        // Books with equal band keys are candidates; neighbours in a bucket are joined if
+        // their whole signatures agree enough, which keeps a bucket linear in its size
+        for (std::size_t band = 0; band < BANDS; ++band) {
+            band_keys.clear();
+            for (std::uint32_t book = 0; book < count; ++book) {
+                std::uint64_t key = band;
+                for (std::size_t row = 0; row < ROWS_PER_BAND; ++row) {
+                    key = Mix(key ^ signatures[book][band * ROWS_PER_BAND + row]);
+                }
+                band_keys.emplace_back(key, book);
+            }
+            std::sort(band_keys.begin(), band_keys.end());
+            for (std::size_t i = 1; i < band_keys.size(); ++i) {
+                const auto [key, book] = band_keys[i];
+                const auto [previous_key, previous_book] = band_keys[i - 1];
+                if (key == previous_key
+                    && GetAgreement(signatures[book], signatures[previous_book]) >= options_.threshold) {
+                    parents[FindRoot(parents, book)] = FindRoot(parents, previous_book);
+                }
+            }
+        }
+
+        std::unordered_map<std::uint32_t, std::vector<DuplicateBook>> components;
+        for (std::uint32_t book = 0; book < count; ++book) {
+            components[FindRoot(parents, book)].push_back(books_[first_book + book]);
+        }
+        const auto first_group = groups.size();
+        for (auto& [root, books] : components) {
+            if (books.size() < 2) {
+                continue;
+            }
+            std::sort(books.begin(), books.end(), [](const DuplicateBook& lhs, const DuplicateBook& rhs) {
+                return std::tie(lhs.title, lhs.publication_year, lhs.id) < std::tie(rhs.title, rhs.publication_year, rhs.id);
+            });
+            groups.push_back({author_id, author_name, std::move(books)});
+        }
+        std::sort(groups.begin() + first_group, groups.end(), [](const DuplicateGroup& lhs, const DuplicateGroup& rhs) {
+            return lhs.books.front().title < rhs.books.front().title;
+        });
+    }
+}
+
+std::vector<DuplicateGroup> FindDuplicates(domain::AuthorRepository& authors, domain::BookRepository& books,
+                                           DuplicateOptions options) {
+    // Only the names are kept for the whole catalog; the books are streamed by author,
+    // so the finder holds no more than its batch of them
+    std::unordered_map<std::string, std::string> author_names;
+    for (const auto& author : authors.StreamAuthors()) {
+        author_names.emplace(author.GetId().ToString(), author.GetName());
+    }
+
+    std::vector<DuplicateGroup> groups;
+    DuplicateFinder finder{[&groups](DuplicateGroup group) {
+        groups.push_back(std::move(group));
+    }, options};
+    for (const auto& book : books.StreamBooksByAuthor()) {
+        if (const auto it = author_names.find(book.GetAuthorId().ToString()); it != author_names.end()) {
+            finder.Add(it->first, it->second, {book.GetTitle(), book.GetPublicationYear(), book.GetBookId().ToString()});
+        }
+    }
+    finder.Finish();
+    // Backends list the authors in orders of their own; the groups are shown by author name
+    std::stable_sort(groups.begin(), groups.end(), [](const DuplicateGroup& lhs, const DuplicateGroup& rhs) {
+        return lhs.author < rhs.author;
+    });
+    return groups;
+}
+
+}  // namespace search
@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../domain/author_fwd.h"
+#include "../domain/book_fwd.h"
+
+namespace search {
+
+struct DuplicateBook {
+    std::string title;
+    int publication_year = 0;
+    std::string id;
+};
+
+// Books of one author whose titles are likely the same work
+struct DuplicateGroup {
+    std::string author_id;
+    std::string author;
+    // Sorted by title
+    std::vector<DuplicateBook> books;
+};
+
+struct DuplicateOptions {
+    // Books are grouped when the Jaccard similarity of their title shingles,
+    // as estimated from the MinHash signatures, is at least this
+    double threshold = 0.5;
+    // 0 uses every core
+    std::size_t threads = 0;
+};
+
+/**
+ * Finds candidate duplicate books of the same author by their titles.
+ *
+ * A title is normalized to lowercase words, so "Hobbit, The" and "The Hobbit" are
+ * the same set of shingles (character trigrams of every word). Each book gets a
+ * MinHash signature of the shingles; the signature is cut into bands, and books of
+ * one author sharing a band are candidates. A candidate joins a group when the
+ * signatures agree on at least the threshold share of their values.
+ *
+ * Books are fed grouped by author and are processed in batches of whole authors,
+ * so memory is bounded by the batch, not by the catalog. Groups are reported to the
+ * handler in the order their authors were added, from the thread calling Add or Finish.
+ */
+class DuplicateFinder {
+public:
+    static constexpr std::size_t BANDS = 16;
+    static constexpr std::size_t ROWS_PER_BAND = 4;
+    static constexpr std::size_t SIGNATURE_SIZE = BANDS * ROWS_PER_BAND;
+    using Signature = std::array<std::uint32_t, SIGNATURE_SIZE>;
+    using GroupHandler = std::function<void(DuplicateGroup group)>;
+
+    explicit DuplicateFinder(GroupHandler handler, DuplicateOptions options = {});
+
+    DuplicateFinder(const DuplicateFinder&) = delete;
+    DuplicateFinder& operator=(const DuplicateFinder&) = delete;
+
+    // All books of an author must be added one after another
+    void Add(std::string_view author_id, std::string_view author, DuplicateBook book);
+    // Reports the groups of the books added since the last batch
+    void Finish();
+
+    static Signature ComputeSignature(std::string_view title);
+
+private:
+    struct Author {
+        std::string id;
+        std::string name;
+        // Books of the author are books_[first_book, end_book)
+        std::size_t first_book;
+        std::size_t end_book;
+    };
+
+    void ProcessBatch();
+    void GroupAuthors(std::size_t begin, std::size_t end, std::vector<DuplicateGroup>& groups) const;
+
+    GroupHandler handler_;
+    DuplicateOptions options_;
+    std::size_t threads_;
+    std::vector<Author> authors_;
+    std::vector<DuplicateBook> books_;
+};
+
+// Candidate duplicate groups of the whole catalog, by author name. The books are read
+// with StreamBooksByAuthor and matched to their authors by id.
+std::vector<DuplicateGroup> FindDuplicates(domain::AuthorRepository& authors, domain::BookRepository& books,
+                                           DuplicateOptions options = {});
+
+}  // namespace search
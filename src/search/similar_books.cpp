@@ -0,0 +1,231 @@
+#include "similar_books.h"
+
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#include "../domain/book.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BOOKYPEDIA_X86_POPCOUNT 1
+#include <immintrin.h>
+#endif
+
+namespace search {
+
+namespace {
+
+// Bitsets are padded to whole AVX2 registers, so the kernel needs no tail handling
+constexpr std::size_t WORDS_PER_BLOCK = 4;
+// Smaller ranges are not worth a thread of their own
+constexpr std::size_t MIN_BOOKS_PER_THREAD = 1 << 15;
+// Books whose tags are queried at once while loading
+constexpr std::size_t LOAD_BATCH = 10000;
+
+struct Overlap {
+    std::uint64_t intersection = 0;
+    std::uint64_t union_size = 0;
+};
+
+Overlap CountOverlapScalar(const std::uint64_t* lhs, const std::uint64_t* rhs, std::size_t words) noexcept {
+    Overlap overlap;
+    for (std::size_t i = 0; i < words; ++i) {
+        overlap.intersection += __builtin_popcountll(lhs[i] & rhs[i]);
+        overlap.union_size += __builtin_popcountll(lhs[i] | rhs[i]);
+    }
+    return overlap;
+}
+
+#ifdef BOOKYPEDIA_X86_POPCOUNT
+
+// AVX2 has no vector popcount: every nibble is looked up in a 16-entry table with a byte
+// shuffle, and the byte counts are summed into 64-bit lanes with SAD against zero
+__attribute__((target("avx2"))) __m256i PopcountBytes(__m256i value) noexcept {
+    const auto lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const auto low_nibbles = _mm256_set1_epi8(0x0F);
+    const auto low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(value, low_nibbles));
+    const auto high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(value, 4), low_nibbles));
+    return _mm256_add_epi8(low, high);
+}
+
+__attribute__((target("avx2"))) std::uint64_t SumLanes(__m256i lanes) noexcept {
+    return static_cast<std::uint64_t>(_mm256_extract_epi64(lanes, 0)) + _mm256_extract_epi64(lanes, 1)
+         + _mm256_extract_epi64(lanes, 2) + _mm256_extract_epi64(lanes, 3);
+}
+
+__attribute__((target("avx2"))) Overlap CountOverlapAvx2(const std::uint64_t* lhs, const std::uint64_t* rhs,
+                                                         std::size_t words) noexcept {
+    const auto zero = _mm256_setzero_si256();
+    auto intersection = zero;
+    auto union_size = zero;
+    for (std::size_t i = 0; i < words; i += WORDS_PER_BLOCK) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+        const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+        intersection = _mm256_add_epi64(intersection, _mm256_sad_epu8(PopcountBytes(_mm256_and_si256(a, b)), zero));
+        union_size = _mm256_add_epi64(union_size, _mm256_sad_epu8(PopcountBytes(_mm256_or_si256(a, b)), zero));
+    }
+    return {SumLanes(intersection), SumLanes(union_size)};
+}
+
+#endif
+
+Overlap CountOverlap(const std::uint64_t* lhs, const std::uint64_t* rhs, std::size_t words, ScanLevel level) noexcept {
+#ifdef BOOKYPEDIA_X86_POPCOUNT
+    if (level == ScanLevel::Avx2) {
+        return CountOverlapAvx2(lhs, rhs, words);
+    }
+#endif
+    return CountOverlapScalar(lhs, rhs, words);
+}
+
+}  // namespace
+
+SimilarityIndex::SimilarityIndex(std::vector<Book> books, std::size_t threads)
+    : books_{std::move(books)}
+    , threads_{threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())} {
+    std::unordered_map<std::string, std::uint32_t> tag_numbers;
+    for (const auto& book : books_) {
+        for (const auto& tag : book.tags) {
+            tag_numbers.try_emplace(tag, static_cast<std::uint32_t>(tag_numbers.size()));
+        }
+    }
+    const auto blocks = (tag_numbers.size() + 64 * WORDS_PER_BLOCK - 1) / (64 * WORDS_PER_BLOCK);
+    words_ = blocks * WORDS_PER_BLOCK;
+    bits_.assign(books_.size() * words_, 0);
+    postings_.resize(tag_numbers.size());
+    tag_counts_.reserve(books_.size());
+    book_indexes_.reserve(books_.size());
+
+    for (std::uint32_t i = 0; i < books_.size(); ++i) {
+        auto& book = books_[i];
+        auto* bits = bits_.data() + std::size_t{i} * words_;
+        for (const auto& tag : book.tags) {
+            const auto number = tag_numbers.at(tag);
+            bits[number / 64] |= std::uint64_t{1} << (number % 64);
+            postings_[number].push_back(i);
+        }
+        tag_counts_.push_back(static_cast<std::uint32_t>(book.tags.size()));
+        book_indexes_.emplace(book.id, i);
+        // The bitset has all it takes from here on
+        book.tags.clear();
+    }
+}
+
+SimilarityIndex SimilarityIndex::Load(domain::BookRepository& repository) {
+    const auto rows = repository.ShowBooks();
+    std::vector<Book> books;
+    books.reserve(rows.size());
+    std::unordered_map<std::string, std::size_t> positions;
+    positions.reserve(rows.size());
+    for (const auto& [title, author, year, id] : rows) {
+        positions.emplace(id, books.size());
+        books.push_back({title, author, year, id, {}});
+    }
+
+    for (std::size_t begin = 0; begin < rows.size(); begin += LOAD_BATCH) {
+        std::vector<std::string> ids;
+        for (std::size_t i = begin; i < std::min(begin + LOAD_BATCH, rows.size()); ++i) {
+            ids.push_back(std::get<3>(rows[i]));
+        }
+        for (auto& [title, author, year, id, tags] : repository.ShowBooksDetails(ids)) {
+            if (const auto it = positions.find(id); it != positions.end()) {
+                books[it->second].tags = std::move(tags);
+            }
+        }
+    }
+    return SimilarityIndex{std::move(books)};
+}
+
+void SimilarityIndex::ScoreRange(std::uint32_t query, std::uint32_t begin, std::uint32_t end, std::size_t k,
+                                 ScanLevel level, std::vector<Match>& top) const {
+    // Books sharing at least one tag with the query, as a bitmap over [begin, end)
+    std::vector<std::uint64_t> candidates((end - begin + 63) / 64, 0);
+    const auto* query_bits = GetBits(query);
+    for (std::size_t word = 0; word < words_; ++word) {
+        for (auto tags = query_bits[word]; tags != 0; tags &= tags - 1) {
+            const auto& posting = postings_[word * 64 + __builtin_ctzll(tags)];
+            for (auto it = std::lower_bound(posting.begin(), posting.end(), begin); it != posting.end() && *it < end; ++it) {
+                const auto offset = *it - begin;
+                candidates[offset / 64] |= std::uint64_t{1} << (offset % 64);
+            }
+        }
+    }
+
+    // Higher similarity first, then catalog order; the heap keeps the worst match on top
+    const auto better = [](const Match& lhs, const Match& rhs) {
+        return lhs.similarity > rhs.similarity || (lhs.similarity == rhs.similarity && lhs.book < rhs.book);
+    };
+    const auto query_tags = static_cast<double>(tag_counts_[query]);
+    for (std::size_t word = 0; word < candidates.size(); ++word) {
+        for (auto bits = candidates[word]; bits != 0; bits &= bits - 1) {
+            const auto book = static_cast<std::uint32_t>(begin + word * 64 + __builtin_ctzll(bits));
+            if (book == query) {
+                continue;
+            }
+            // Books come in ascending order, so one that can at most tie the worst match loses
+            if (top.size() == k) {
+                const auto book_tags = static_cast<double>(tag_counts_[book]);
+                const auto bound = std::min(query_tags, book_tags) / std::max(query_tags, book_tags);
+                if (bound <= top.front().similarity) {
+                    continue;
+                }
+            }
+            const auto overlap = CountOverlap(query_bits, GetBits(book), words_, level);
+            const Match match{static_cast<double>(overlap.intersection) / static_cast<double>(overlap.union_size), book};
+            if (top.size() < k) {
+                top.push_back(match);
+                std::push_heap(top.begin(), top.end(), better);
+            } else if (better(match, top.front())) {
+                std::pop_heap(top.begin(), top.end(), better);
+                top.back() = match;
+                std::push_heap(top.begin(), top.end(), better);
+            }
+        }
+    }
+}
+
+std::vector<SimilarBook> SimilarityIndex::FindSimilar(const std::string& book_id, std::size_t k, ScanLevel level) const {
+    const auto query = book_indexes_.at(book_id);
+    if (k == 0 || tag_counts_[query] == 0) {
+        return {};
+    }
+    level = std::min(level, GetSupportedScanLevel());
+
+    const auto size = books_.size();
+    const auto parts = std::clamp<std::size_t>(size / MIN_BOOKS_PER_THREAD, 1, threads_);
+    const auto part_size = (size + parts - 1) / parts;
+    std::vector<std::vector<Match>> tops(parts);
+    std::vector<std::future<void>> scores;
+    for (std::size_t part = 1; part < parts; ++part) {
+        const auto begin = static_cast<std::uint32_t>(std::min(part * part_size, size));
+        const auto end = static_cast<std::uint32_t>(std::min(begin + part_size, size));
+        scores.push_back(std::async(std::launch::async, [&, part, begin, end] {
+            ScoreRange(query, begin, end, k, level, tops[part]);
+        }));
+    }
+    ScoreRange(query, 0, static_cast<std::uint32_t>(std::min(part_size, size)), k, level, tops[0]);
+    for (auto& score : scores) {
+        score.get();
+    }
+
+    std::vector<Match> matches;
+    for (const auto& top : tops) {
+        matches.insert(matches.end(), top.begin(), top.end());
+    }
+    std::sort(matches.begin(), matches.end(), [](const Match& lhs, const Match& rhs) {
+        return lhs.similarity > rhs.similarity || (lhs.similarity == rhs.similarity && lhs.book < rhs.book);
+    });
+    matches.resize(std::min(matches.size(), k));
+
+    std::vector<SimilarBook> result;
+    result.reserve(matches.size());
+    for (const auto& match : matches) {
+        const auto& book = books_[match.book];
+        result.push_back({book.title, book.author, book.publication_year, book.id, match.similarity});
+    }
+    return result;
+}
+
+}  // namespace search
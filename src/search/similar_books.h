@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "../domain/book_fwd.h"
+#include "substring_scan.h"
+
+namespace search {
+
+struct SimilarBook {
+    std::string title;
+    std::string author;
+    int publication_year = 0;
+    std::string id;
+    // Jaccard similarity of the tag sets, in (0, 1]
+    double similarity = 0;
+};
+
+/**
+ * Finds the books whose tags overlap most with the tags of a given book.
+ *
+ * Every book's tags are a fixed-width bitset over the dictionary of all tags, so the
+ * Jaccard similarity |A & B| / |A | B| of two books is two popcounts per word.
+ * Only books sharing at least one tag can score above zero, so a query scores just
+ * the union of the posting lists of its tags. The book range is split between threads;
+ * each keeps a bounded top-k heap and skips books whose tag count alone rules them out.
+ *
+ * Bitsets take (dictionary size rounded up to 256) / 8 bytes per book.
+ * Like ColumnarCatalog, the index does not follow later changes of the catalog.
+ */
+class SimilarityIndex {
+public:
+    struct Book {
+        std::string title;
+        std::string author;
+        int publication_year = 0;
+        std::string id;
+        std::set<std::string> tags;
+    };
+
+    explicit SimilarityIndex(std::vector<Book> books, std::size_t threads = 0);
+
+    // Reads every book with its tags through the repository
+    static SimilarityIndex Load(domain::BookRepository& books);
+
+    std::size_t GetSize() const noexcept {
+        return books_.size();
+    }
+
+    std::size_t GetTagCount() const noexcept {
+        return postings_.size();
+    }
+
+    // Up to k books most similar to the book, best first; ties keep the catalog order.
+    // Throws std::out_of_range if there is no such book.
+    std::vector<SimilarBook> FindSimilar(const std::string& book_id, std::size_t k,
+                                         ScanLevel level = GetSupportedScanLevel()) const;
+
+private:
+    struct Match {
+        double similarity;
+        std::uint32_t book;
+    };
+
+    void ScoreRange(std::uint32_t query, std::uint32_t begin, std::uint32_t end, std::size_t k, ScanLevel level,
+                    std::vector<Match>& top) const;
+
+    const std::uint64_t* GetBits(std::uint32_t book) const noexcept {
+        return bits_.data() + std::size_t{book} * words_;
+    }
+
+    std::vector<Book> books_;
+    std::unordered_map<std::string, std::uint32_t> book_indexes_;
+    // Books having the tag, in ascending order, by tag number
+    std::vector<std::vector<std::uint32_t>> postings_;
+    std::vector<std::uint32_t> tag_counts_;
+    std::size_t words_ = 0;
+    std::vector<std::uint64_t> bits_;
+    std::size_t threads_;
+};
+
+}  // namespace search
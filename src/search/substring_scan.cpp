@@ -0,0 +1,171 @@
+#include "substring_scan.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BOOKYPEDIA_X86_SCAN 1
+#include <immintrin.h>
+#endif
+
+namespace search {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr char ToLower(char c) noexcept {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+bool EqualsIgnoreCase(const char* text, std::string_view lower_needle) noexcept {
+    for (std::size_t i = 0; i < lower_needle.size(); ++i) {
+        if (ToLower(text[i]) != lower_needle[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t FindScalar(std::string_view haystack, std::string_view lower_needle) noexcept {
+    if (haystack.size() < lower_needle.size()) {
+        return std::string_view::npos;
+    }
+    const auto first = lower_needle.front();
+    const auto rest = lower_needle.substr(1);
+    const auto last_start = haystack.size() - lower_needle.size();
+    for (std::size_t i = 0; i <= last_start; ++i) {
+        if (ToLower(haystack[i]) == first && EqualsIgnoreCase(haystack.data() + i + 1, rest)) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+#ifdef BOOKYPEDIA_X86_SCAN
+
+// Both vector versions follow the same plan: compare the first and the last needle byte
+// against a whole block of candidate positions at once, and only check the bytes in between
+// for the positions where both match. Blocks are lowercased in registers, so the column
+// does not need a lowercase copy.
+
+__m128i ToLower(__m128i block) noexcept {
+    // Unsigned block - 'A' <= 25 selects 'A'..'Z'
+    const auto offset = _mm_sub_epi8(block, _mm_set1_epi8('A'));
+    const auto is_upper = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(25)), offset);
+    return _mm_or_si128(block, _mm_and_si128(is_upper, _mm_set1_epi8(0x20)));
+}
+
+std::size_t FindSse2(std::string_view haystack, std::string_view lower_needle) noexcept {
+    constexpr std::size_t BLOCK = 16;
+    const auto size = lower_needle.size();
+    const auto first = _mm_set1_epi8(lower_needle.front());
+    const auto last = _mm_set1_epi8(lower_needle.back());
+    const auto middle = lower_needle.substr(1, size > 1 ? size - 2 : 0);
+
+    std::size_t i = 0;
+    for (; i + size - 1 + BLOCK <= haystack.size(); i += BLOCK) {
+        const auto block_first = ToLower(_mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack.data() + i)));
+        const auto block_last =
+            ToLower(_mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack.data() + i + size - 1)));
+        auto mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+        while (mask != 0) {
+            const auto position = i + __builtin_ctz(mask);
+            if (EqualsIgnoreCase(haystack.data() + position + 1, middle)) {
+                return position;
+            }
+            mask &= mask - 1;
+        }
+    }
+    const auto tail = FindScalar(haystack.substr(i), lower_needle);
+    return tail == std::string_view::npos ? tail : i + tail;
+}
+
+__attribute__((target("avx2"))) __m256i ToLower(__m256i block) noexcept {
+    const auto offset = _mm256_sub_epi8(block, _mm256_set1_epi8('A'));
+    const auto is_upper = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(25)), offset);
+    return _mm256_or_si256(block, _mm256_and_si256(is_upper, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2"))) std::size_t FindAvx2(std::string_view haystack,
+                                                      std::string_view lower_needle) noexcept {
+    constexpr std::size_t BLOCK = 32;
+    const auto size = lower_needle.size();
+    const auto first = _mm256_set1_epi8(lower_needle.front());
+    const auto last = _mm256_set1_epi8(lower_needle.back());
+    const auto middle = lower_needle.substr(1, size > 1 ? size - 2 : 0);
+
+    std::size_t i = 0;
+    for (; i + size - 1 + BLOCK <= haystack.size(); i += BLOCK) {
+        const auto block_first =
+            ToLower(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack.data() + i)));
+        const auto block_last =
+            ToLower(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack.data() + i + size - 1)));
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))));
+        while (mask != 0) {
+            const auto position = i + __builtin_ctz(mask);
+            if (EqualsIgnoreCase(haystack.data() + position + 1, middle)) {
+                return position;
+            }
+            mask &= mask - 1;
+        }
+    }
+    const auto tail = FindSse2(haystack.substr(i), lower_needle);
+    return tail == std::string_view::npos ? tail : i + tail;
+}
+
+#endif
+
+ScanLevel DetectScanLevel() noexcept {
+#ifdef BOOKYPEDIA_X86_SCAN
+    // SSE2 is part of x86-64 itself
+    return __builtin_cpu_supports("avx2") ? ScanLevel::Avx2 : ScanLevel::Sse2;
+#else
+    return ScanLevel::Scalar;
+#endif
+}
+
+}  // namespace
+
+ScanLevel GetSupportedScanLevel() noexcept {
+    static const ScanLevel level = DetectScanLevel();
+    return level;
+}
+
+std::string_view GetScanLevelName(ScanLevel level) noexcept {
+    switch (level) {
+        case ScanLevel::Avx2:
+            return "AVX2"sv;
+        case ScanLevel::Sse2:
+            return "SSE2"sv;
+        default:
+            return "scalar"sv;
+    }
+}
+
+std::string ToLowerAscii(std::string_view text) {
+    std::string result{text};
+    std::transform(result.begin(), result.end(), result.begin(), [](char c) {
+        return ToLower(c);
+    });
+    return result;
+}
+
+std::size_t FindIgnoreCase(std::string_view haystack, std::string_view lower_needle, ScanLevel level) noexcept {
+    if (lower_needle.empty()) {
+        return 0;
+    }
+    level = std::min(level, GetSupportedScanLevel());
+#ifdef BOOKYPEDIA_X86_SCAN
+    if (level == ScanLevel::Avx2) {
+        return FindAvx2(haystack, lower_needle);
+    }
+    if (level == ScanLevel::Sse2) {
+        return FindSse2(haystack, lower_needle);
+    }
+#endif
+    return FindScalar(haystack, lower_needle);
+}
+
+}  // namespace search
@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace search {
+
+// Instruction sets the substring scan can use, from the slowest
+enum class ScanLevel { Scalar, Sse2, Avx2 };
+
+// Best level the CPU running the process supports
+ScanLevel GetSupportedScanLevel() noexcept;
+std::string_view GetScanLevelName(ScanLevel level) noexcept;
+
+// ASCII lowercase copy; other bytes, such as UTF-8 sequences, are kept as they are
+std::string ToLowerAscii(std::string_view text);
+
+// Position of the first occurrence of `lower_needle` in `haystack` ignoring ASCII case, or npos.
+// The needle must already be lowercase, see ToLowerAscii. An empty needle is found at 0.
+// Levels above the supported one are lowered to it.
+std::size_t FindIgnoreCase(std::string_view haystack, std::string_view lower_needle,
+                           ScanLevel level = GetSupportedScanLevel()) noexcept;
+
+}  // namespace search
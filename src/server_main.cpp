@@ -0,0 +1,122 @@
+#include <boost/asio/signal_set.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "app/use_cases_executor.h"
+#include "app/use_cases_impl.h"
+#include "http/api_handler.h"
+#include "http/server.h"
+#include "postgres/postgres.h"
+#include "postgres/write_batcher.h"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr const char DB_URL_ENV_NAME[]{"BOOKYPEDIA_DB_URL"};
+
+struct ServerConfig {
+    std::string db_url;
+    unsigned short port = 8080;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    // Use case workers, each with its own database connection
+    unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+    // Saves of all workers are committed in batches when set
+    std::optional<postgres::WriteBatcher::Config> group_commit;
+};
+
+// Repositories of one executor worker over its own connection
+struct WorkerUseCases {
+    WorkerUseCases(const std::string& db_url, postgres::WriteBatcher* batcher,
+                   std::shared_ptr<app::CatalogIndexes> indexes)
+        : db{pqxx::connection{db_url}, nullptr, batcher}
+        , use_cases{db.GetAuthors(), db.GetBooks(), std::move(indexes)} {
+    }
+
+    postgres::Database db;
+    app::UseCasesImpl use_cases;
+};
+
+ServerConfig GetConfig(int argc, const char* argv[]) {
+    ServerConfig config;
+    if (const auto* url = std::getenv(DB_URL_ENV_NAME)) {
+        config.db_url = url;
+    } else {
+        throw std::runtime_error(DB_URL_ENV_NAME + " environment variable not found"s);
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i] == "--port"sv && i + 1 < argc) {
+            config.port = static_cast<unsigned short>(std::stoi(argv[++i]));
+        } else if (argv[i] == "--threads"sv && i + 1 < argc) {
+            config.threads = std::max(1, std::stoi(argv[++i]));
+        } else if (argv[i] == "--workers"sv && i + 1 < argc) {
+            config.workers = std::max(1, std::stoi(argv[++i]));
+        } else if (argv[i] == "--group-commit"sv && i + 1 < argc) {
+            config.group_commit.emplace().window = std::chrono::microseconds{std::stoi(argv[++i])};
+        } else {
+            throw std::invalid_argument("Usage: "s + argv[0]
+                                        + " [--port <port>] [--threads <I/O threads>] [--workers <use case workers>]"s
+                                        + " [--group-commit <batch window, us>]"s);
+        }
+    }
+    return config;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    namespace net = http_server::net;
+
+    try {
+        const auto config = GetConfig(argc, argv);
+
+        // Outlives the workers that use it
+        std::optional<postgres::WriteBatcher> batcher;
+        if (config.group_commit) {
+            batcher.emplace(config.db_url, *config.group_commit);
+        }
+        // Held once for all workers
+        const auto indexes = std::make_shared<app::CatalogIndexes>();
+        app::UseCasesExecutor executor{config.workers, [&config, &batcher, &indexes]() -> std::shared_ptr<app::UseCases> {
+            auto worker = std::make_shared<WorkerUseCases>(config.db_url, batcher ? &*batcher : nullptr, indexes);
+            return {worker, &worker->use_cases};
+        }};
+        app::BlockingUseCases use_cases{executor};
+        http_server::ApiHandler api{use_cases};
+
+        net::io_context ioc(static_cast<int>(config.threads));
+        net::signal_set signals{ioc, SIGINT, SIGTERM};
+        signals.async_wait([&ioc](const boost::system::error_code& ec, int) {
+            if (!ec) {
+                ioc.stop();
+            }
+        });
+
+        const http_server::tcp::endpoint endpoint{net::ip::make_address("0.0.0.0"), config.port};
+        std::make_shared<http_server::Listener>(ioc, endpoint, [&api](http_server::StringRequest&& request) {
+            return api(std::move(request));
+        })->Run();
+        std::cout << "Server listens on port "sv << config.port << " with "sv << config.threads << " I/O threads and "sv
+                  << config.workers << " use case workers"sv << std::endl;
+
+        std::vector<std::thread> workers;
+        workers.reserve(config.threads - 1);
+        for (unsigned i = 1; i < config.threads; ++i) {
+            workers.emplace_back([&ioc] {
+                ioc.run();
+            });
+        }
+        ioc.run();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
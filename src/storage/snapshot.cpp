@@ -0,0 +1,571 @@
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace storage {
+
+using namespace std::literals;
+using namespace snapshot_format;
+
+namespace {
+
+static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<AuthorRecord>
+              && std::is_trivially_copyable_v<BookRecord> && std::is_trivially_copyable_v<StringRef>);
+static_assert(sizeof(AuthorRecord) % 8 == 0 && sizeof(BookRecord) % 8 == 0 && sizeof(Header) % 8 == 0);
+
+constexpr std::size_t SECTION_ALIGNMENT = 8;
+
+std::string_view GetId(const AuthorRecord& author) {
+    return {author.id, UUID_SIZE};
+}
+
+std::string_view GetId(const BookRecord& book) {
+    return {book.id, UUID_SIZE};
+}
+
+void CopyId(char (&target)[UUID_SIZE], const std::string& id) {
+    if (id.size() != UUID_SIZE) {
+        throw std::invalid_argument("Unexpected id "s + id);
+    }
+    std::memcpy(target, id.data(), UUID_SIZE);
+}
+
+// Flushes the file, or with O_DIRECTORY the entries of the directory, to disk
+void SyncPath(const std::string& path, int flags) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | flags);
+    if (fd < 0 || ::fsync(fd) != 0) {
+        const auto error = std::strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error("Failed to sync "s + path + ": "s + error);
+    }
+    ::close(fd);
+}
+
+[[noreturn]] void ThrowCorrupt() {
+    throw std::runtime_error("Corrupt snapshot");
+}
+
+template <typename T>
+const T& At(std::span<const T> items, std::size_t index) {
+    if (index >= items.size()) {
+        ThrowCorrupt();
+    }
+    return items[index];
+}
+
+// String heap with repeated strings, mostly tags, stored once
+class HeapBuilder {
+public:
+    StringRef Add(const std::string& value) {
+        auto [it, inserted] = refs_.try_emplace(value);
+        if (inserted) {
+            it->second = {heap_.size(), static_cast<std::uint32_t>(value.size()), 0};
+            heap_ += value;
+        }
+        return it->second;
+    }
+
+    const std::string& GetData() const noexcept {
+        return heap_;
+    }
+
+private:
+    std::string heap_;
+    std::unordered_map<std::string, StringRef> refs_;
+};
+
+// Lays the sections out one after another behind the header
+class SectionWriter {
+public:
+    template <typename T>
+    Section Add(const std::vector<T>& items) {
+        const Section section{offset_, items.size()};
+        parts_.push_back({offset_, reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T)});
+        offset_ += (items.size() * sizeof(T) + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        return section;
+    }
+
+    void Write(std::ostream& out) const {
+        for (const auto& part : parts_) {
+            const auto position = static_cast<std::uint64_t>(out.tellp());
+            out.write(std::string(part.offset - position, '\0').data(), part.offset - position);
+            out.write(part.data, part.size);
+        }
+    }
+
+private:
+    struct Part {
+        std::uint64_t offset;
+        const char* data;
+        std::size_t size;
+    };
+
+    std::uint64_t offset_ = sizeof(Header);
+    std::vector<Part> parts_;
+};
+
+// Rows streamed from the snapshot are made from the mapped records this many at a time
+constexpr std::size_t STREAM_BATCH_SIZE = 1000;
+
+// Stream over `size` rows read by read(first, count), which returns a vector of them
+template <typename Row, typename Read>
+domain::Stream<Row> MakeStream(std::size_t size, Read read) {
+    class Source : public domain::Stream<Row>::Source {
+    public:
+        Source(std::size_t size, Read read)
+            : size_{size}
+            , read_{std::move(read)} {
+        }
+
+        void FetchBatch(std::vector<Row>& batch) override {
+            const auto count = std::min(STREAM_BATCH_SIZE, size_ - next_);
+            batch = read_(next_, count);
+            next_ += count;
+        }
+
+    private:
+        std::size_t size_;
+        std::size_t next_ = 0;
+        Read read_;
+    };
+    return domain::Stream<Row>{std::make_unique<Source>(size, std::move(read))};
+}
+
+}  // namespace
+
+void WriteSnapshot(const std::string& path, std::vector<domain::Author> authors, std::vector<domain::Book> books) {
+    std::sort(authors.begin(), authors.end(), [](const domain::Author& lhs, const domain::Author& rhs) {
+        return lhs.GetName() < rhs.GetName();
+    });
+    std::unordered_map<std::string, std::uint32_t> author_indexes;
+    for (std::uint32_t i = 0; i < authors.size(); ++i) {
+        author_indexes.emplace(authors[i].GetId().ToString(), i);
+    }
+
+    // Books in the order of ShowBooks, with the index of their author
+    std::vector<std::pair<const domain::Book*, std::uint32_t>> sorted_books;
+    sorted_books.reserve(books.size());
+    for (const auto& book : books) {
+        if (const auto it = author_indexes.find(book.GetAuthorId().ToString()); it != author_indexes.end()) {
+            sorted_books.emplace_back(&book, it->second);
+        }
+    }
+    std::sort(sorted_books.begin(), sorted_books.end(), [&authors](const auto& lhs, const auto& rhs) {
+        const auto& [lhs_book, lhs_author] = lhs;
+        const auto& [rhs_book, rhs_author] = rhs;
+        if (lhs_book->GetTitle() != rhs_book->GetTitle()) {
+            return lhs_book->GetTitle() < rhs_book->GetTitle();
+        }
+        if (lhs_author != rhs_author) {
+            return authors[lhs_author].GetName() < authors[rhs_author].GetName();
+        }
+        return lhs_book->GetPublicationYear() < rhs_book->GetPublicationYear();
+    });
+
+    HeapBuilder heap;
+    std::vector<AuthorRecord> author_records(authors.size());
+    for (std::size_t i = 0; i < authors.size(); ++i) {
+        CopyId(author_records[i].id, authors[i].GetId().ToString());
+        author_records[i].name = heap.Add(authors[i].GetName());
+    }
+
+    std::vector<BookRecord> book_records(sorted_books.size());
+    std::vector<StringRef> tags;
+    for (std::size_t i = 0; i < sorted_books.size(); ++i) {
+        const auto& [book, author] = sorted_books[i];
+        auto& record = book_records[i];
+        CopyId(record.id, book->GetBookId().ToString());
+        record.author = author;
+        record.title = heap.Add(book->GetTitle());
+        record.publication_year = book->GetPublicationYear();
+        record.first_tag = tags.size();
+        if (book->GetTags()) {
+            for (const auto& tag : *book->GetTags()) {
+                tags.push_back(heap.Add(tag));
+            }
+        }
+        record.tag_count = static_cast<std::uint32_t>(tags.size() - record.first_tag);
+    }
+
+    std::vector<std::uint32_t> authors_by_id(author_records.size());
+    std::iota(authors_by_id.begin(), authors_by_id.end(), 0);
+    std::sort(authors_by_id.begin(), authors_by_id.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+        return GetId(author_records[lhs]) < GetId(author_records[rhs]);
+    });
+
+    std::vector<std::uint32_t> books_by_id(book_records.size());
+    std::iota(books_by_id.begin(), books_by_id.end(), 0);
+    std::sort(books_by_id.begin(), books_by_id.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+        return GetId(book_records[lhs]) < GetId(book_records[rhs]);
+    });
+
+    std::vector<std::uint32_t> books_by_author(book_records.size());
+    std::iota(books_by_author.begin(), books_by_author.end(), 0);
+    std::sort(books_by_author.begin(), books_by_author.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+        const auto& lhs_book = *sorted_books[lhs].first;
+        const auto& rhs_book = *sorted_books[rhs].first;
+        if (book_records[lhs].author != book_records[rhs].author) {
+            return book_records[lhs].author < book_records[rhs].author;
+        }
+        if (lhs_book.GetPublicationYear() != rhs_book.GetPublicationYear()) {
+            return lhs_book.GetPublicationYear() < rhs_book.GetPublicationYear();
+        }
+        if (lhs_book.GetTitle() != rhs_book.GetTitle()) {
+            return lhs_book.GetTitle() < rhs_book.GetTitle();
+        }
+        return GetId(book_records[lhs]) < GetId(book_records[rhs]);
+    });
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+
+    SectionWriter sections;
+    header.authors = sections.Add(author_records);
+    header.books = sections.Add(book_records);
+    header.tags = sections.Add(tags);
+    header.authors_by_id = sections.Add(authors_by_id);
+    header.books_by_id = sections.Add(books_by_id);
+    header.books_by_author = sections.Add(books_by_author);
+    const std::vector<char> heap_data{heap.GetData().begin(), heap.GetData().end()};
+    header.heap = sections.Add(heap_data);
+
+    const auto temp_path = path + ".tmp"s;
+    {
+        std::ofstream out{temp_path, std::ios::binary | std::ios::trunc};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        sections.Write(out);
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Failed to write snapshot "s + temp_path);
+        }
+    }
+    // The data has to be on disk before the rename is, or a crash could leave the new name
+    // on a file with missing pages
+    SyncPath(temp_path, 0);
+    std::filesystem::rename(temp_path, path);
+    const auto dir = std::filesystem::path{path}.parent_path();
+    SyncPath(dir.empty() ? "."s : dir.string(), O_DIRECTORY);
+}
+
+Snapshot::Snapshot(const std::string& path)
+    : file_{path, util::MappedFile::Access::Random}
+    , data_{file_.GetData()} {
+    Header header;
+    if (data_.size() < sizeof(header)) {
+        throw std::runtime_error(path + " is not a bookypedia snapshot"s);
+    }
+    std::memcpy(&header, data_.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error(path + " is not a bookypedia snapshot"s);
+    }
+    if (header.byte_order != BYTE_ORDER_MARK) {
+        throw std::runtime_error(path + " was written on a machine with another byte order"s);
+    }
+    if (header.version != VERSION) {
+        throw std::runtime_error(path + " has unsupported snapshot version "s + std::to_string(header.version));
+    }
+
+    authors_ = GetSection<AuthorRecord>(header.authors);
+    books_ = GetSection<BookRecord>(header.books);
+    tags_ = GetSection<StringRef>(header.tags);
+    authors_by_id_ = GetSection<std::uint32_t>(header.authors_by_id);
+    books_by_id_ = GetSection<std::uint32_t>(header.books_by_id);
+    books_by_author_ = GetSection<std::uint32_t>(header.books_by_author);
+    const auto heap = GetSection<char>(header.heap);
+    heap_ = {heap.data(), heap.size()};
+
+    if (authors_by_id_.size() != authors_.size() || books_by_id_.size() != books_.size()
+        || books_by_author_.size() != books_.size()) {
+        ThrowCorrupt();
+    }
+}
+
+template <typename T>
+std::span<const T> Snapshot::GetSection(const Section& section) const {
+    // The mapping starts on a page boundary, so aligned offsets give aligned records
+    if (section.offset % alignof(T) != 0 || section.offset > data_.size()
+        || section.count > (data_.size() - section.offset) / sizeof(T)) {
+        ThrowCorrupt();
+    }
+    return {reinterpret_cast<const T*>(data_.data() + section.offset), section.count};
+}
+
+std::string_view Snapshot::GetString(const StringRef& ref) const {
+    if (ref.offset > heap_.size() || ref.size > heap_.size() - ref.offset) {
+        ThrowCorrupt();
+    }
+    return heap_.substr(ref.offset, ref.size);
+}
+
+std::set<std::string> Snapshot::GetTags(const BookRecord& book) const {
+    if (book.first_tag > tags_.size() || book.tag_count > tags_.size() - book.first_tag) {
+        ThrowCorrupt();
+    }
+    std::set<std::string> tags;
+    for (const auto& tag : tags_.subspan(book.first_tag, book.tag_count)) {
+        tags.emplace_hint(tags.end(), GetString(tag));
+    }
+    return tags;
+}
+
+Snapshot::BookDetails Snapshot::MakeDetails(const BookRecord& book) const {
+    return {std::string{GetString(book.title)}, std::string{GetString(At(authors_, book.author).name)},
+            book.publication_year, std::string{GetId(book)}, GetTags(book)};
+}
+
+const BookRecord* Snapshot::FindBook(std::string_view id) const {
+    const auto it = std::lower_bound(books_by_id_.begin(), books_by_id_.end(), id, [this](std::uint32_t index, std::string_view id) {
+        return GetId(At(books_, index)) < id;
+    });
+    if (it == books_by_id_.end() || GetId(At(books_, *it)) != id) {
+        return nullptr;
+    }
+    return &books_[*it];
+}
+
+std::vector<domain::Author> Snapshot::GetAuthors() const {
+    return GetAuthors(0, authors_.size());
+}
+
+std::vector<Snapshot::BookRow> Snapshot::ShowBooks() const {
+    return ShowBooks(0, books_.size());
+}
+
+std::vector<domain::Author> Snapshot::GetAuthors(std::size_t first, std::size_t count) const {
+    std::vector<domain::Author> authors;
+    authors.reserve(count);
+    for (const auto& author : authors_.subspan(first, count)) {
+        authors.emplace_back(domain::AuthorId::FromString(std::string{GetId(author)}), std::string{GetString(author.name)});
+    }
+    return authors;
+}
+
+std::vector<Snapshot::BookRow> Snapshot::ShowBooks(std::size_t first, std::size_t count) const {
+    std::vector<BookRow> rows;
+    rows.reserve(count);
+    for (const auto& book : books_.subspan(first, count)) {
+        rows.emplace_back(GetString(book.title), GetString(At(authors_, book.author).name), book.publication_year,
+                          GetId(book));
+    }
+    return rows;
+}
+
+std::vector<domain::Book> Snapshot::GetBooksByAuthor(std::size_t first, std::size_t count) const {
+    std::vector<domain::Book> books;
+    books.reserve(count);
+    for (const auto index : books_by_author_.subspan(first, count)) {
+        const auto& book = At(books_, index);
+        books.emplace_back(domain::BookId::FromString(std::string{GetId(book)}),
+                           domain::AuthorId::FromString(std::string{GetId(At(authors_, book.author))}),
+                           std::string{GetString(book.title)}, book.publication_year, std::nullopt);
+    }
+    return books;
+}
+
+std::vector<domain::Book> Snapshot::GetAuthorBooks(const std::string& author_id) const {
+    return GetAuthorBooksPage(author_id, std::nullopt, std::numeric_limits<std::size_t>::max());
+}
+
+std::vector<domain::Book> Snapshot::GetAuthorBooksPage(const std::string& author_id,
+                                                       const std::optional<domain::AuthorBooksCursor>& after,
+                                                       std::size_t limit) const {
+    std::vector<domain::Book> books;
+    const auto author = std::lower_bound(authors_by_id_.begin(), authors_by_id_.end(), author_id,
+                                         [this](std::uint32_t index, std::string_view id) {
+        return GetId(At(authors_, index)) < id;
+    });
+    if (author == authors_by_id_.end() || GetId(At(authors_, *author)) != author_id) {
+        return books;
+    }
+
+    // books_by_author_ is sorted by author, then year, title and id, which is the order to return
+    const auto author_of = [this](std::uint32_t index) {
+        return At(books_, index).author;
+    };
+    auto begin = std::partition_point(books_by_author_.begin(), books_by_author_.end(), [&](std::uint32_t index) {
+        return author_of(index) < *author;
+    });
+    if (after) {
+        const auto& [year, title, id] = *after;
+        begin = std::partition_point(begin, books_by_author_.end(), [&](std::uint32_t index) {
+            const auto& book = At(books_, index);
+            return book.author == *author
+                && std::tuple{book.publication_year, GetString(book.title), GetId(book)}
+                       <= std::tuple{year, std::string_view{title}, std::string_view{id}};
+        });
+    }
+    for (auto it = begin; it != books_by_author_.end() && author_of(*it) == *author && books.size() < limit; ++it) {
+        const auto& book = books_[*it];
+        books.emplace_back(domain::BookId::FromString(std::string{GetId(book)}), domain::AuthorId::FromString(author_id),
+                           std::string{GetString(book.title)}, book.publication_year, GetTags(book));
+    }
+    return books;
+}
+
+std::vector<Snapshot::BookDetails> Snapshot::ShowBook(const std::string& title) const {
+    std::vector<BookDetails> result;
+    const auto begin = std::partition_point(books_.begin(), books_.end(), [&](const BookRecord& book) {
+        return GetString(book.title) < title;
+    });
+    for (auto it = begin; it != books_.end() && GetString(it->title) == title; ++it) {
+        result.push_back(MakeDetails(*it));
+    }
+    return result;
+}
+
+std::vector<Snapshot::BookDetails> Snapshot::ShowBooksDetails(const std::vector<std::string>& book_ids) const {
+    std::vector<BookDetails> result;
+    result.reserve(book_ids.size());
+    for (const auto& id : book_ids) {
+        if (const auto* book = FindBook(id)) {
+            result.push_back(MakeDetails(*book));
+        }
+    }
+    return result;
+}
+
+domain::CatalogStats Snapshot::CountStats() const {
+    domain::CatalogStats stats;
+    std::vector<std::uint64_t> books_per_author(authors_.size());
+    std::map<std::string_view, std::uint64_t> books_per_tag;
+    std::map<int, std::uint64_t> books_per_year;
+    for (const auto& book : books_) {
+        if (book.author >= books_per_author.size()) {
+            ThrowCorrupt();
+        }
+        ++books_per_author[book.author];
+        ++books_per_year[book.publication_year];
+        if (book.first_tag > tags_.size() || book.tag_count > tags_.size() - book.first_tag) {
+            ThrowCorrupt();
+        }
+        for (const auto& tag : tags_.subspan(book.first_tag, book.tag_count)) {
+            ++books_per_tag[GetString(tag)];
+        }
+    }
+
+    // Authors are stored in name order already
+    for (std::size_t i = 0; i < authors_.size(); ++i) {
+        if (books_per_author[i] != 0) {
+            stats.books_per_author.emplace_back(GetString(authors_[i].name), books_per_author[i]);
+        }
+    }
+    for (const auto& [tag, books] : books_per_tag) {
+        stats.books_per_tag.emplace_back(tag, books);
+    }
+    stats.books_per_year.assign(books_per_year.begin(), books_per_year.end());
+    stats.books = books_.size();
+    return stats;
+}
+
+domain::CatalogStats Snapshot::GetStats(domain::StatsSource source) const {
+    if (source == domain::StatsSource::FullRecompute) {
+        return CountStats();
+    }
+    std::call_once(summary_once_, [this] {
+        summary_ = CountStats();
+    });
+    return summary_;
+}
+
+void SnapshotAuthorRepository::Save(const domain::Author&) {
+    throw std::runtime_error("The catalog snapshot is read-only");
+}
+
+std::vector<domain::Author> SnapshotAuthorRepository::GetAuthors() {
+    return snapshot_.GetAuthors();
+}
+
+domain::Stream<domain::Author> SnapshotAuthorRepository::StreamAuthors() {
+    return MakeStream<domain::Author>(snapshot_.GetAuthorCount(), [this](std::size_t first, std::size_t count) {
+        return snapshot_.GetAuthors(first, count);
+    });
+}
+
+void SnapshotAuthorRepository::Delete(std::string&) {
+    throw std::runtime_error("The catalog snapshot is read-only");
+}
+
+void SnapshotAuthorRepository::Edit(std::string&, std::string&) {
+    throw std::runtime_error("The catalog snapshot is read-only");
+}
+
+void SnapshotBookRepository::Save(const domain::Book&) {
+    throw std::runtime_error("The catalog snapshot is read-only");
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string>> SnapshotBookRepository::ShowBooks() {
+    return snapshot_.ShowBooks();
+}
+
+domain::Stream<std::tuple<std::string, std::string, int, std::string>> SnapshotBookRepository::StreamBooks() {
+    return MakeStream<Snapshot::BookRow>(snapshot_.GetBookCount(), [this](std::size_t first, std::size_t count) {
+        return snapshot_.ShowBooks(first, count);
+    });
+}
+
+domain::Stream<domain::Book> SnapshotBookRepository::StreamBooksByAuthor() {
+    return MakeStream<domain::Book>(snapshot_.GetBookCount(), [this](std::size_t first, std::size_t count) {
+        return snapshot_.GetBooksByAuthor(first, count);
+    });
+}
+
+std::vector<domain::Book> SnapshotBookRepository::GetAuthorBooks(const std::string& author_id) {
+    return snapshot_.GetAuthorBooks(author_id);
+}
+
+std::vector<domain::Book> SnapshotBookRepository::GetAuthorBooksPage(const std::string& author_id,
+                                                                     const std::optional<domain::AuthorBooksCursor>& after,
+                                                                     std::size_t limit) {
+    return snapshot_.GetAuthorBooksPage(author_id, after, limit);
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> SnapshotBookRepository::ShowBook(std::string& book_name) {
+    return snapshot_.ShowBook(book_name);
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> SnapshotBookRepository::ShowBooksDetails(const std::vector<std::string>& book_ids) {
+    return snapshot_.ShowBooksDetails(book_ids);
+}
+
+void SnapshotBookRepository::DeleteBook(std::string&) {
+    throw std::runtime_error("The catalog snapshot is read-only");
+}
+
+void SnapshotBookRepository::EditBook(std::string&, int, std::set<std::string>, std::string&) {
+    throw std::runtime_error("The catalog snapshot is read-only");
+}
+
+domain::CatalogStats SnapshotBookRepository::GetCatalogStats(domain::StatsSource source) {
+    return snapshot_.GetStats(source);
+}
+
+std::uint64_t SnapshotBookRepository::DeleteBooksByTag(const std::string&) {
+    throw std::runtime_error("The catalog snapshot is read-only");
+}
+
+std::uint64_t SnapshotBookRepository::RetagBooks(const std::string&, const std::string&) {
+    throw std::runtime_error("The catalog snapshot is read-only");
+}
+
+std::uint64_t SnapshotBookRepository::DeleteBooksByAuthorAndYearRange(const std::string&, int, int) {
+    throw std::runtime_error("The catalog snapshot is read-only");
+}
+
+}  // namespace storage
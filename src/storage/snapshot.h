@@ -0,0 +1,205 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "../domain/author.h"
+#include "../domain/book.h"
+#include "../util/mapped_file.h"
+
+namespace storage {
+
+namespace snapshot_format {
+
+// All integers are in the byte order of the machine that wrote the snapshot;
+// a reader on a machine with another byte order rejects the file.
+constexpr char MAGIC[8]{'B', 'K', 'Y', 'S', 'N', 'A', 'P', '\0'};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr std::size_t UUID_SIZE = 36;
+
+// Bytes of the string heap
+struct StringRef {
+    std::uint64_t offset;
+    std::uint32_t size;
+    std::uint32_t reserved;
+};
+
+// Authors are stored sorted by name
+struct AuthorRecord {
+    char id[UUID_SIZE];
+    std::uint32_t reserved;
+    StringRef name;
+};
+
+// Books are stored sorted by title, author name and publication year, the order of ShowBooks
+struct BookRecord {
+    char id[UUID_SIZE];
+    // Index in the author section
+    std::uint32_t author;
+    StringRef title;
+    std::int32_t publication_year;
+    std::uint32_t tag_count;
+    // Index of the first of the book's tags in the tag section, the tags are sorted
+    std::uint64_t first_tag;
+};
+
+// Array of `count` elements starting `offset` bytes from the start of the file
+struct Section {
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    Section authors;         // AuthorRecord
+    Section books;           // BookRecord
+    Section tags;            // StringRef
+    Section authors_by_id;   // std::uint32_t author indexes sorted by id
+    Section books_by_id;     // std::uint32_t book indexes sorted by id
+    Section books_by_author; // std::uint32_t book indexes sorted by author, year and title
+    Section heap;            // char
+};
+
+}  // namespace snapshot_format
+
+// Writes a snapshot of the catalog to `path`, replacing the file atomically so that
+// processes still serving the old snapshot keep their mapping intact.
+// Books of unknown authors are left out, as ShowBooks would not list them either.
+void WriteSnapshot(const std::string& path, std::vector<domain::Author> authors, std::vector<domain::Book> books);
+
+/**
+ * Read-only catalog served straight from a memory-mapped snapshot file.
+ *
+ * Opening only checks the header and the section bounds, so it takes the same time
+ * for any catalog size; pages are faulted in as the queries touch them.
+ * Lookups binary search the sorted sections, nothing is parsed into memory up front.
+ */
+class Snapshot {
+public:
+    using BookRow = std::tuple<std::string, std::string, int, std::string>;
+    using BookDetails = std::tuple<std::string, std::string, int, std::string, std::set<std::string>>;
+
+    explicit Snapshot(const std::string& path);
+
+    std::size_t GetAuthorCount() const noexcept {
+        return authors_.size();
+    }
+
+    std::size_t GetBookCount() const noexcept {
+        return books_.size();
+    }
+
+    std::vector<domain::Author> GetAuthors() const;
+    std::vector<BookRow> ShowBooks() const;
+    // Rows first to first + count of the lists above
+    std::vector<domain::Author> GetAuthors(std::size_t first, std::size_t count) const;
+    std::vector<BookRow> ShowBooks(std::size_t first, std::size_t count) const;
+    // Books first to first + count, without their tags, in the order of the by-author index
+    std::vector<domain::Book> GetBooksByAuthor(std::size_t first, std::size_t count) const;
+    std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) const;
+    std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                 const std::optional<domain::AuthorBooksCursor>& after,
+                                                 std::size_t limit) const;
+    std::vector<BookDetails> ShowBook(const std::string& title) const;
+    std::vector<BookDetails> ShowBooksDetails(const std::vector<std::string>& book_ids) const;
+    // The snapshot never changes, so the summary is counted once, on first use
+    domain::CatalogStats GetStats(domain::StatsSource source) const;
+
+private:
+    template <typename T>
+    std::span<const T> GetSection(const snapshot_format::Section& section) const;
+
+    std::string_view GetString(const snapshot_format::StringRef& ref) const;
+    std::set<std::string> GetTags(const snapshot_format::BookRecord& book) const;
+    BookDetails MakeDetails(const snapshot_format::BookRecord& book) const;
+    const snapshot_format::BookRecord* FindBook(std::string_view id) const;
+    domain::CatalogStats CountStats() const;
+
+    util::MappedFile file_;
+    std::string_view data_;
+    std::span<const snapshot_format::AuthorRecord> authors_;
+    std::span<const snapshot_format::BookRecord> books_;
+    std::span<const snapshot_format::StringRef> tags_;
+    std::span<const std::uint32_t> authors_by_id_;
+    std::span<const std::uint32_t> books_by_id_;
+    std::span<const std::uint32_t> books_by_author_;
+    std::string_view heap_;
+
+    mutable std::once_flag summary_once_;
+    mutable domain::CatalogStats summary_;
+};
+
+// Repositories over a snapshot; every change throws, since the snapshot is read-only
+class SnapshotAuthorRepository : public domain::AuthorRepository {
+public:
+    explicit SnapshotAuthorRepository(const Snapshot& snapshot)
+        : snapshot_{snapshot}
+    {}
+
+    void Save(const domain::Author& author) override;
+    std::vector<domain::Author> GetAuthors() override;
+    domain::Stream<domain::Author> StreamAuthors() override;
+    void Delete(std::string& name) override;
+    void Edit(std::string& new_name, std::string& old_name) override;
+
+private:
+    const Snapshot& snapshot_;
+};
+
+class SnapshotBookRepository : public domain::BookRepository {
+public:
+    explicit SnapshotBookRepository(const Snapshot& snapshot)
+        : snapshot_{snapshot}
+    {}
+
+    void Save(const domain::Book& book) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string>> ShowBooks() override;
+    domain::Stream<std::tuple<std::string, std::string, int, std::string>> StreamBooks() override;
+    domain::Stream<domain::Book> StreamBooksByAuthor() override;
+    std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) override;
+    std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                 const std::optional<domain::AuthorBooksCursor>& after,
+                                                 std::size_t limit) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBook(std::string& book_name) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBooksDetails(const std::vector<std::string>& book_ids) override;
+    void DeleteBook(std::string& book_id) override;
+    void EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) override;
+    domain::CatalogStats GetCatalogStats(domain::StatsSource source) override;
+    std::uint64_t DeleteBooksByTag(const std::string& tag) override;
+    std::uint64_t RetagBooks(const std::string& from, const std::string& to) override;
+    std::uint64_t DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) override;
+
+private:
+    const Snapshot& snapshot_;
+};
+
+// Counterpart of postgres::Database over a snapshot file
+class SnapshotDatabase {
+public:
+    explicit SnapshotDatabase(const std::string& path)
+        : snapshot_{path}
+    {}
+
+    SnapshotAuthorRepository& GetAuthors() & {
+        return authors_;
+    }
+
+    SnapshotBookRepository& GetBooks() & {
+        return books_;
+    }
+
+private:
+    Snapshot snapshot_;
+    SnapshotAuthorRepository authors_{snapshot_};
+    SnapshotBookRepository books_{snapshot_};
+};
+
+}  // namespace storage
@@ -0,0 +1,749 @@
+#include "storage.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+namespace storage {
+
+using namespace std::literals;
+
+namespace {
+
+enum class RecordType : char {
+    PutAuthor = 'A',
+    DeleteAuthor = 'a',
+    PutBook = 'B',
+    DeleteBook = 'b',
+    DeleteBooksByTag = 't',
+    RetagBooks = 'r',
+    DeleteBooksByAuthorAndYearRange = 'y',
+};
+
+class RecordWriter {
+public:
+    explicit RecordWriter(RecordType type) {
+        data_ += static_cast<char>(type);
+    }
+
+    RecordWriter& Put(std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            data_ += static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+        return *this;
+    }
+
+    RecordWriter& Put(std::string_view value) {
+        Put(static_cast<std::uint32_t>(value.size()));
+        data_ += value;
+        return *this;
+    }
+
+    std::string Release() {
+        return std::move(data_);
+    }
+
+private:
+    std::string data_;
+};
+
+class RecordReader {
+public:
+    explicit RecordReader(std::string_view data)
+        : data_{data} {
+    }
+
+    RecordType GetType() {
+        return static_cast<RecordType>(Take(1)[0]);
+    }
+
+    std::uint32_t GetUint32() {
+        const auto bytes = Take(4);
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<std::uint32_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    std::string GetString() {
+        const auto size = GetUint32();
+        return std::string{Take(size)};
+    }
+
+private:
+    std::string_view Take(std::size_t size) {
+        if (data_.size() < size) {
+            throw std::runtime_error("Malformed log record");
+        }
+        const auto result = data_.substr(0, size);
+        data_.remove_prefix(size);
+        return result;
+    }
+
+    std::string_view data_;
+};
+
+std::string MakeAuthorRecord(const std::string& id, const std::string& name) {
+    return RecordWriter{RecordType::PutAuthor}.Put(id).Put(name).Release();
+}
+
+std::string MakeBookRecord(const std::string& id, const std::string& author_id, const std::string& title, int year,
+                           const std::set<std::string>& tags) {
+    RecordWriter writer{RecordType::PutBook};
+    writer.Put(id).Put(author_id).Put(title).Put(static_cast<std::uint32_t>(year));
+    writer.Put(static_cast<std::uint32_t>(tags.size()));
+    for (const auto& tag : tags) {
+        writer.Put(tag);
+    }
+    return writer.Release();
+}
+
+template <typename Key>
+void Decrement(std::map<Key, std::uint64_t>& counts, const Key& key) {
+    if (const auto it = counts.find(key); it != counts.end() && --it->second == 0) {
+        counts.erase(it);
+    }
+}
+
+template <typename Map>
+void EraseFromIndex(Map& index, const std::string& key, const std::string& id) {
+    auto [begin, end] = index.equal_range(key);
+    for (auto it = begin; it != end; ++it) {
+        if (it->second == id) {
+            index.erase(it);
+            return;
+        }
+    }
+}
+
+// Rows of a stream are read from the catalog this many at a time; all the strings a stream
+// allocates are those of its first page, the later ones are assigned over them
+constexpr std::size_t STREAM_BATCH_SIZE = 256;
+
+void AssignBookRow(std::vector<Catalog::BookRow>& rows, std::size_t index, const std::string& title,
+                   const std::string& author, int publication_year, const std::string& id) {
+    if (index == rows.size()) {
+        rows.emplace_back(title, author, publication_year, id);
+        return;
+    }
+    auto& [row_title, row_author, row_year, row_id] = rows[index];
+    row_title.assign(title);
+    row_author.assign(author);
+    row_year = publication_year;
+    row_id.assign(id);
+}
+
+// ShowBooks a page at a time. Each page is read under the lock on its own, so the stream
+// may miss changes made while it runs, but lists every row at most once and in order.
+class BookRowSource : public domain::Stream<Catalog::BookRow>::Source {
+public:
+    explicit BookRowSource(const Catalog& catalog)
+        : catalog_{catalog} {
+    }
+
+    void FetchBatch(std::vector<Catalog::BookRow>& batch) override {
+        catalog_.ShowBooksPage(started_ ? &last_ : nullptr, STREAM_BATCH_SIZE, batch);
+        started_ = true;
+        if (!batch.empty()) {
+            last_ = batch.back();
+        }
+    }
+
+private:
+    const Catalog& catalog_;
+    Catalog::BookRow last_;
+    bool started_ = false;
+};
+
+}  // namespace
+
+Catalog::Catalog(Config config)
+    : config_{std::move(config)}
+    , log_{{config_.path, config_.sync}, [this](std::string_view record) {
+        ApplyRecord(record);
+        ++log_records_;
+    }} {
+    compaction_thread_ = std::thread{&Catalog::CompactionLoop, this};
+}
+
+Catalog::~Catalog() {
+    {
+        std::lock_guard lock{compaction_mutex_};
+        stopping_ = true;
+    }
+    compaction_stop_.notify_one();
+    compaction_thread_.join();
+}
+
+void Catalog::ApplyRecord(std::string_view record) {
+    RecordReader reader{record};
+    switch (reader.GetType()) {
+        case RecordType::PutAuthor: {
+            auto id = reader.GetString();
+            auto name = reader.GetString();
+            PutAuthor(id, name);
+            break;
+        }
+        case RecordType::DeleteAuthor:
+            EraseAuthor(reader.GetString());
+            break;
+        case RecordType::PutBook: {
+            auto id = reader.GetString();
+            BookRecord book;
+            book.author_id = reader.GetString();
+            book.title = reader.GetString();
+            book.publication_year = static_cast<int>(reader.GetUint32());
+            for (auto count = reader.GetUint32(); count > 0; --count) {
+                book.tags.insert(reader.GetString());
+            }
+            PutBook(id, std::move(book));
+            break;
+        }
+        case RecordType::DeleteBook:
+            EraseBook(reader.GetString());
+            break;
+        case RecordType::DeleteBooksByTag:
+            EraseBooksWithTag(reader.GetString());
+            break;
+        case RecordType::RetagBooks: {
+            auto from = reader.GetString();
+            auto to = reader.GetString();
+            RenameTag(from, to);
+            break;
+        }
+        case RecordType::DeleteBooksByAuthorAndYearRange: {
+            auto author_id = reader.GetString();
+            const auto min_year = static_cast<int>(reader.GetUint32());
+            const auto max_year = static_cast<int>(reader.GetUint32());
+            EraseAuthorBooks(author_id, min_year, max_year);
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown log record type");
+    }
+}
+
+void Catalog::PutAuthor(const std::string& id, const std::string& name) {
+    auto [it, inserted] = authors_.try_emplace(id, name);
+    if (!inserted) {
+        author_ids_by_name_.erase(it->second);
+        it->second = name;
+    }
+    author_ids_by_name_[name] = id;
+}
+
+void Catalog::EraseAuthor(const std::string& id) {
+    const auto it = authors_.find(id);
+    if (it == authors_.end()) {
+        return;
+    }
+    // Like the Postgres backend, an author takes all of their books along
+    if (const auto books = books_by_author_.find(id); books != books_by_author_.end()) {
+        for (const auto& [year, title, book_id] : std::set<AuthorBookKey>{books->second}) {
+            EraseBook(book_id);
+        }
+    }
+    author_ids_by_name_.erase(it->second);
+    authors_.erase(it);
+}
+
+void Catalog::PutBook(const std::string& id, BookRecord book) {
+    EraseBook(id);
+    book_ids_by_title_.emplace(book.title, id);
+    books_by_author_[book.author_id].emplace(book.publication_year, book.title, id);
+    ++books_per_year_[book.publication_year];
+    for (const auto& tag : book.tags) {
+        ++books_per_tag_[tag];
+    }
+    books_.emplace(id, std::move(book));
+}
+
+void Catalog::EraseBook(const std::string& id) {
+    const auto it = books_.find(id);
+    if (it == books_.end()) {
+        return;
+    }
+    EraseFromIndex(book_ids_by_title_, it->second.title, id);
+    if (auto books = books_by_author_.find(it->second.author_id); books != books_by_author_.end()) {
+        books->second.erase({it->second.publication_year, it->second.title, id});
+        if (books->second.empty()) {
+            books_by_author_.erase(books);
+        }
+    }
+    Decrement(books_per_year_, it->second.publication_year);
+    for (const auto& tag : it->second.tags) {
+        Decrement(books_per_tag_, tag);
+    }
+    books_.erase(it);
+}
+
+std::uint64_t Catalog::EraseBooksWithTag(const std::string& tag) {
+    std::vector<std::string> ids;
+    for (const auto& [id, book] : books_) {
+        if (book.tags.count(tag) != 0) {
+            ids.push_back(id);
+        }
+    }
+    for (const auto& id : ids) {
+        EraseBook(id);
+    }
+    return ids.size();
+}
+
+std::uint64_t Catalog::RenameTag(const std::string& from, const std::string& to) {
+    if (from == to) {
+        return 0;
+    }
+    std::uint64_t retagged = 0;
+    for (auto& [id, book] : books_) {
+        if (book.tags.erase(from) == 0) {
+            continue;
+        }
+        Decrement(books_per_tag_, from);
+        if (book.tags.insert(to).second) {
+            ++books_per_tag_[to];
+        }
+        ++retagged;
+    }
+    return retagged;
+}
+
+std::uint64_t Catalog::EraseAuthorBooks(const std::string& author_id, int min_year, int max_year) {
+    const auto books = books_by_author_.find(author_id);
+    if (books == books_by_author_.end() || min_year > max_year) {
+        return 0;
+    }
+    // The author's books are ordered by year first, so the range is contiguous
+    std::vector<std::string> ids;
+    for (auto it = books->second.lower_bound({min_year, std::string{}, std::string{}});
+         it != books->second.end() && std::get<0>(*it) <= max_year; ++it) {
+        ids.push_back(std::get<2>(*it));
+    }
+    for (const auto& id : ids) {
+        EraseBook(id);
+    }
+    return ids.size();
+}
+
+template <typename Change>
+std::uint64_t Catalog::ApplyBulkChange(Change&& change, std::string record) {
+    std::uint64_t changed;
+    std::uint64_t sequence;
+    {
+        std::unique_lock lock{mutex_};
+        changed = change();
+        if (changed == 0) {
+            return 0;
+        }
+        sequence = Log(std::move(record));
+    }
+    log_.WaitDurable(sequence);
+    return changed;
+}
+
+std::uint64_t Catalog::Log(std::string record) {
+    ++log_records_;
+    return log_.Append(std::move(record));
+}
+
+void Catalog::SaveAuthor(const domain::Author& author) {
+    const auto id = author.GetId().ToString();
+    std::uint64_t sequence;
+    {
+        std::unique_lock lock{mutex_};
+        if (const auto it = author_ids_by_name_.find(author.GetName()); it != author_ids_by_name_.end() && it->second != id) {
+            throw std::runtime_error("Author "s + author.GetName() + " already exists"s);
+        }
+        PutAuthor(id, author.GetName());
+        sequence = Log(MakeAuthorRecord(id, author.GetName()));
+    }
+    log_.WaitDurable(sequence);
+}
+
+std::vector<domain::Author> Catalog::GetAuthors() const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::Author> authors;
+    authors.reserve(author_ids_by_name_.size());
+    for (const auto& [name, id] : author_ids_by_name_) {
+        authors.emplace_back(domain::AuthorId::FromString(id), name);
+    }
+    return authors;
+}
+
+void Catalog::DeleteAuthor(const std::string& name) {
+    std::uint64_t sequence;
+    {
+        std::unique_lock lock{mutex_};
+        const auto it = author_ids_by_name_.find(name);
+        if (it == author_ids_by_name_.end()) {
+            throw std::runtime_error("");
+        }
+        const auto id = it->second;
+        EraseAuthor(id);
+        sequence = Log(RecordWriter{RecordType::DeleteAuthor}.Put(id).Release());
+    }
+    log_.WaitDurable(sequence);
+}
+
+void Catalog::EditAuthor(const std::string& new_name, const std::string& old_name) {
+    std::uint64_t sequence;
+    {
+        std::unique_lock lock{mutex_};
+        const auto it = author_ids_by_name_.find(old_name);
+        if (it == author_ids_by_name_.end() || (new_name != old_name && author_ids_by_name_.count(new_name) != 0)) {
+            throw std::runtime_error("");
+        }
+        const auto id = it->second;
+        PutAuthor(id, new_name);
+        sequence = Log(MakeAuthorRecord(id, new_name));
+    }
+    log_.WaitDurable(sequence);
+}
+
+void Catalog::SaveBook(const domain::Book& book) {
+    const auto id = book.GetBookId().ToString();
+    BookRecord record{book.GetAuthorId().ToString(), book.GetTitle(), book.GetPublicationYear(),
+                      book.GetTags().value_or(std::set<std::string>{})};
+    std::uint64_t sequence;
+    {
+        std::unique_lock lock{mutex_};
+        if (authors_.count(record.author_id) == 0) {
+            throw std::runtime_error("");
+        }
+        auto log_record = MakeBookRecord(id, record.author_id, record.title, record.publication_year, record.tags);
+        PutBook(id, std::move(record));
+        sequence = Log(std::move(log_record));
+    }
+    log_.WaitDurable(sequence);
+}
+
+std::vector<Catalog::BookRow> Catalog::ShowBooks() const {
+    std::shared_lock lock{mutex_};
+    std::vector<BookRow> rows;
+    rows.reserve(books_.size());
+    for (auto it = book_ids_by_title_.begin(); it != book_ids_by_title_.end();) {
+        // Books with the same title are ordered by author and year
+        const auto group_begin = rows.size();
+        const auto end = book_ids_by_title_.upper_bound(it->first);
+        for (; it != end; ++it) {
+            const auto& book = books_.at(it->second);
+            rows.emplace_back(book.title, authors_.at(book.author_id), book.publication_year, it->second);
+        }
+        std::sort(rows.begin() + group_begin, rows.end());
+    }
+    return rows;
+}
+
+void Catalog::ShowBooksPage(const BookRow* after, std::size_t limit, std::vector<BookRow>& rows) const {
+    std::shared_lock lock{mutex_};
+    std::size_t size = 0;
+    auto it = after ? book_ids_by_title_.lower_bound(std::get<0>(*after)) : book_ids_by_title_.begin();
+    while (it != book_ids_by_title_.end() && size < limit) {
+        // Books with the same title are ordered by author and year, as in ShowBooks
+        const auto group_begin = size;
+        const auto end = book_ids_by_title_.upper_bound(it->first);
+        for (; it != end; ++it) {
+            const auto& book = books_.at(it->second);
+            AssignBookRow(rows, size++, book.title, authors_.at(book.author_id), book.publication_year, it->second);
+        }
+        const auto first = rows.begin() + static_cast<std::ptrdiff_t>(group_begin);
+        const auto last = rows.begin() + static_cast<std::ptrdiff_t>(size);
+        std::sort(first, last);
+        if (after) {
+            // Rows of the first group up to `after` were on the previous page; rotating keeps their strings for reuse
+            const auto listed = std::upper_bound(first, last, *after);
+            std::rotate(first, listed, last);
+            size -= static_cast<std::size_t>(listed - first);
+        }
+    }
+    rows.resize(std::min(size, limit));
+}
+
+std::vector<domain::Book> Catalog::GetAuthorBooks(const std::string& author_id) const {
+    return GetAuthorBooksPage(author_id, std::nullopt, std::numeric_limits<std::size_t>::max());
+}
+
+std::vector<domain::Book> Catalog::GetAuthorBooksPage(const std::string& author_id,
+                                                      const std::optional<domain::AuthorBooksCursor>& after,
+                                                      std::size_t limit) const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::Book> books;
+    const auto it = books_by_author_.find(author_id);
+    if (it == books_by_author_.end()) {
+        return books;
+    }
+    auto key = it->second.begin();
+    if (after) {
+        key = it->second.upper_bound({after->publication_year, after->title, after->book_id});
+    }
+    books.reserve(std::min<std::size_t>(limit, std::distance(key, it->second.end())));
+    for (; key != it->second.end() && books.size() < limit; ++key) {
+        const auto& id = std::get<2>(*key);
+        books.push_back(MakeBook(id, books_.at(id)));
+    }
+    return books;
+}
+
+std::vector<domain::Book> Catalog::GetBooksByAuthor() const {
+    std::shared_lock lock{mutex_};
+    std::vector<const std::pair<const std::string, std::set<AuthorBookKey>>*> authors;
+    authors.reserve(books_by_author_.size());
+    for (const auto& author : books_by_author_) {
+        authors.push_back(&author);
+    }
+    std::sort(authors.begin(), authors.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->first < rhs->first;
+    });
+
+    std::vector<domain::Book> books;
+    books.reserve(books_.size());
+    for (const auto* author : authors) {
+        const auto author_id = domain::AuthorId::FromString(author->first);
+        for (const auto& [year, title, id] : author->second) {
+            books.emplace_back(domain::BookId::FromString(id), author_id, title, year, std::nullopt);
+        }
+    }
+    return books;
+}
+
+domain::Book Catalog::MakeBook(const std::string& id, const BookRecord& book) const {
+    return {domain::BookId::FromString(id), domain::AuthorId::FromString(book.author_id), book.title,
+            book.publication_year, book.tags};
+}
+
+Catalog::BookDetails Catalog::MakeDetails(const std::string& id, const BookRecord& book) const {
+    return {book.title, authors_.at(book.author_id), book.publication_year, id, book.tags};
+}
+
+std::vector<Catalog::BookDetails> Catalog::ShowBook(const std::string& title) const {
+    std::shared_lock lock{mutex_};
+    std::vector<BookDetails> result;
+    const auto [begin, end] = book_ids_by_title_.equal_range(title);
+    for (auto it = begin; it != end; ++it) {
+        result.push_back(MakeDetails(it->second, books_.at(it->second)));
+    }
+    return result;
+}
+
+std::vector<Catalog::BookDetails> Catalog::ShowBooksDetails(const std::vector<std::string>& book_ids) const {
+    std::shared_lock lock{mutex_};
+    std::vector<BookDetails> result;
+    result.reserve(book_ids.size());
+    for (const auto& id : book_ids) {
+        if (const auto it = books_.find(id); it != books_.end()) {
+            result.push_back(MakeDetails(id, it->second));
+        }
+    }
+    return result;
+}
+
+void Catalog::DeleteBook(const std::string& book_id) {
+    std::uint64_t sequence;
+    {
+        std::unique_lock lock{mutex_};
+        if (books_.count(book_id) == 0) {
+            throw std::runtime_error("");
+        }
+        EraseBook(book_id);
+        sequence = Log(RecordWriter{RecordType::DeleteBook}.Put(book_id).Release());
+    }
+    log_.WaitDurable(sequence);
+}
+
+void Catalog::EditBook(const std::string& title, int publication_year, std::set<std::string> tags, const std::string& id) {
+    std::uint64_t sequence;
+    {
+        std::unique_lock lock{mutex_};
+        const auto it = books_.find(id);
+        if (it == books_.end()) {
+            throw std::runtime_error("");
+        }
+        BookRecord book{it->second.author_id, title, publication_year, std::move(tags)};
+        auto log_record = MakeBookRecord(id, book.author_id, book.title, book.publication_year, book.tags);
+        PutBook(id, std::move(book));
+        sequence = Log(std::move(log_record));
+    }
+    log_.WaitDurable(sequence);
+}
+
+domain::CatalogStats Catalog::GetStats(domain::StatsSource source) const {
+    std::shared_lock lock{mutex_};
+    domain::CatalogStats stats;
+    if (source == domain::StatsSource::Summary) {
+        for (const auto& [name, id] : author_ids_by_name_) {
+            if (const auto books = books_by_author_.find(id); books != books_by_author_.end()) {
+                stats.books_per_author.emplace_back(name, books->second.size());
+            }
+        }
+        stats.books_per_tag.assign(books_per_tag_.begin(), books_per_tag_.end());
+        stats.books_per_year.assign(books_per_year_.begin(), books_per_year_.end());
+        stats.books = books_.size();
+        return stats;
+    }
+
+    std::map<std::string, std::uint64_t> books_per_author;
+    std::map<std::string, std::uint64_t> books_per_tag;
+    std::map<int, std::uint64_t> books_per_year;
+    for (const auto& [id, book] : books_) {
+        if (const auto author = authors_.find(book.author_id); author != authors_.end()) {
+            ++books_per_author[author->second];
+        }
+        for (const auto& tag : book.tags) {
+            ++books_per_tag[tag];
+        }
+        ++books_per_year[book.publication_year];
+    }
+    stats.books_per_author.assign(books_per_author.begin(), books_per_author.end());
+    stats.books_per_tag.assign(books_per_tag.begin(), books_per_tag.end());
+    stats.books_per_year.assign(books_per_year.begin(), books_per_year.end());
+    stats.books = books_.size();
+    return stats;
+}
+
+std::uint64_t Catalog::DeleteBooksByTag(const std::string& tag) {
+    return ApplyBulkChange([&] {
+        return EraseBooksWithTag(tag);
+    }, RecordWriter{RecordType::DeleteBooksByTag}.Put(tag).Release());
+}
+
+std::uint64_t Catalog::RetagBooks(const std::string& from, const std::string& to) {
+    return ApplyBulkChange([&] {
+        return RenameTag(from, to);
+    }, RecordWriter{RecordType::RetagBooks}.Put(from).Put(to).Release());
+}
+
+std::uint64_t Catalog::DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) {
+    return ApplyBulkChange([&] {
+        return EraseAuthorBooks(author_id, min_year, max_year);
+    }, RecordWriter{RecordType::DeleteBooksByAuthorAndYearRange}
+           .Put(author_id)
+           .Put(static_cast<std::uint32_t>(min_year))
+           .Put(static_cast<std::uint32_t>(max_year))
+           .Release());
+}
+
+bool Catalog::NeedsCompaction() const {
+    const auto live_records = authors_.size() + books_.size();
+    return log_records_ >= config_.compaction_min_records && log_records_ > 2 * live_records;
+}
+
+void Catalog::Compact() {
+    // Writers are held off while the log is rewritten, readers are not
+    std::shared_lock lock{mutex_};
+    log_.Rewrite([this](const WriteAheadLog::RecordSink& sink) {
+        for (const auto& [id, name] : authors_) {
+            sink(MakeAuthorRecord(id, name));
+        }
+        for (const auto& [id, book] : books_) {
+            sink(MakeBookRecord(id, book.author_id, book.title, book.publication_year, book.tags));
+        }
+    });
+    log_records_ = authors_.size() + books_.size();
+}
+
+void Catalog::CompactionLoop() {
+    std::unique_lock lock{compaction_mutex_};
+    while (!compaction_stop_.wait_for(lock, config_.compaction_interval, [this] {
+        return stopping_;
+    })) {
+        bool needed;
+        {
+            std::shared_lock catalog_lock{mutex_};
+            needed = NeedsCompaction();
+        }
+        if (needed) {
+            try {
+                Compact();
+            } catch (const std::exception&) {
+                // The old log is intact, try again next time
+            }
+        }
+    }
+}
+
+void AuthorRepositoryImpl::Save(const domain::Author& author) {
+    catalog_.SaveAuthor(author);
+}
+
+std::vector<domain::Author> AuthorRepositoryImpl::GetAuthors() {
+    return catalog_.GetAuthors();
+}
+
+// The catalog is in memory already; streaming it would hold the shared lock while the caller reads
+domain::Stream<domain::Author> AuthorRepositoryImpl::StreamAuthors() {
+    return domain::Stream<domain::Author>::FromVector(catalog_.GetAuthors());
+}
+
+void AuthorRepositoryImpl::Delete(std::string& name) {
+    catalog_.DeleteAuthor(name);
+}
+
+void AuthorRepositoryImpl::Edit(std::string& new_name, std::string& old_name) {
+    catalog_.EditAuthor(new_name, old_name);
+}
+
+void BookRepositoryImpl::Save(const domain::Book& book) {
+    catalog_.SaveBook(book);
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string>> BookRepositoryImpl::ShowBooks() {
+    return catalog_.ShowBooks();
+}
+
+domain::Stream<std::tuple<std::string, std::string, int, std::string>> BookRepositoryImpl::StreamBooks() {
+    return domain::Stream<std::tuple<std::string, std::string, int, std::string>>{std::make_unique<BookRowSource>(catalog_)};
+}
+
+domain::Stream<domain::Book> BookRepositoryImpl::StreamBooksByAuthor() {
+    return domain::Stream<domain::Book>::FromVector(catalog_.GetBooksByAuthor());
+}
+
+std::vector<domain::Book> BookRepositoryImpl::GetAuthorBooks(const std::string& author_id) {
+    return catalog_.GetAuthorBooks(author_id);
+}
+
+std::vector<domain::Book> BookRepositoryImpl::GetAuthorBooksPage(const std::string& author_id,
+                                                                 const std::optional<domain::AuthorBooksCursor>& after,
+                                                                 std::size_t limit) {
+    return catalog_.GetAuthorBooksPage(author_id, after, limit);
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> BookRepositoryImpl::ShowBook(std::string& book_name) {
+    return catalog_.ShowBook(book_name);
+}
+
+std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> BookRepositoryImpl::ShowBooksDetails(const std::vector<std::string>& book_ids) {
+    return catalog_.ShowBooksDetails(book_ids);
+}
+
+void BookRepositoryImpl::DeleteBook(std::string& book_id) {
+    catalog_.DeleteBook(book_id);
+}
+
+void BookRepositoryImpl::EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) {
+    catalog_.EditBook(title, publication_year, std::move(tags), id);
+}
+
+domain::CatalogStats BookRepositoryImpl::GetCatalogStats(domain::StatsSource source) {
+    return catalog_.GetStats(source);
+}
+
+std::uint64_t BookRepositoryImpl::DeleteBooksByTag(const std::string& tag) {
+    return catalog_.DeleteBooksByTag(tag);
+}
+
+std::uint64_t BookRepositoryImpl::RetagBooks(const std::string& from, const std::string& to) {
+    return catalog_.RetagBooks(from, to);
+}
+
+std::uint64_t BookRepositoryImpl::DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) {
+    return catalog_.DeleteBooksByAuthorAndYearRange(author_id, min_year, max_year);
+}
+
+Database::Database(Catalog::Config config)
+    : catalog_{std::move(config)} {
+}
+
+}  // namespace storage
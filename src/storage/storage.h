@@ -0,0 +1,195 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "../domain/author.h"
+#include "../domain/book.h"
+#include "wal.h"
+
+namespace storage {
+
+/**
+ * Catalog kept in memory and persisted in a write-ahead log, for deployments without Postgres.
+ *
+ * Every change is applied in memory and appended to the log as one record;
+ * the call returns once its record is durable. Readers may briefly see changes
+ * whose records are still being synced. On start, the log is replayed.
+ *
+ * Once most records in the log are overwritten or deleted rows, a background
+ * thread rewrites the log from the in-memory state (compaction).
+ */
+class Catalog {
+public:
+    using BookRow = std::tuple<std::string, std::string, int, std::string>;
+    using BookDetails = std::tuple<std::string, std::string, int, std::string, std::set<std::string>>;
+
+    struct Config {
+        std::string path;
+        bool sync = true;
+        // The log is compacted when it has at least this many records
+        // and more than twice as many as there are live authors and books
+        std::size_t compaction_min_records = 100000;
+        std::chrono::milliseconds compaction_interval{10000};
+    };
+
+    explicit Catalog(Config config);
+    ~Catalog();
+
+    Catalog(const Catalog&) = delete;
+    Catalog& operator=(const Catalog&) = delete;
+
+    void SaveAuthor(const domain::Author& author);
+    std::vector<domain::Author> GetAuthors() const;
+    void DeleteAuthor(const std::string& name);
+    void EditAuthor(const std::string& new_name, const std::string& old_name);
+
+    void SaveBook(const domain::Book& book);
+    std::vector<BookRow> ShowBooks() const;
+    // Up to limit rows of ShowBooks that come after the row `after`, or from the first one without it.
+    // They are assigned over the rows already in `rows`, reusing the memory of their strings.
+    void ShowBooksPage(const BookRow* after, std::size_t limit, std::vector<BookRow>& rows) const;
+    std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) const;
+    std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                 const std::optional<domain::AuthorBooksCursor>& after,
+                                                 std::size_t limit) const;
+    // Every book without its tags, by author id, then as GetAuthorBooks lists them
+    std::vector<domain::Book> GetBooksByAuthor() const;
+    std::vector<BookDetails> ShowBook(const std::string& title) const;
+    std::vector<BookDetails> ShowBooksDetails(const std::vector<std::string>& book_ids) const;
+    void DeleteBook(const std::string& book_id);
+    void EditBook(const std::string& title, int publication_year, std::set<std::string> tags, const std::string& id);
+    domain::CatalogStats GetStats(domain::StatsSource source) const;
+    // Bulk changes are logged as one record each, so they are replayed all or nothing
+    std::uint64_t DeleteBooksByTag(const std::string& tag);
+    std::uint64_t RetagBooks(const std::string& from, const std::string& to);
+    std::uint64_t DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year);
+
+    // Rewrites the log from the in-memory state
+    void Compact();
+
+private:
+    struct BookRecord {
+        std::string author_id;
+        std::string title;
+        int publication_year = 0;
+        std::set<std::string> tags;
+    };
+    using AuthorBookKey = std::tuple<int, std::string, std::string>;
+
+    void ApplyRecord(std::string_view record);
+    void PutAuthor(const std::string& id, const std::string& name);
+    void EraseAuthor(const std::string& id);
+    void PutBook(const std::string& id, BookRecord book);
+    void EraseBook(const std::string& id);
+    std::uint64_t EraseBooksWithTag(const std::string& tag);
+    std::uint64_t RenameTag(const std::string& from, const std::string& to);
+    std::uint64_t EraseAuthorBooks(const std::string& author_id, int min_year, int max_year);
+    // Applies a bulk change and logs its record if it changed anything
+    template <typename Change>
+    std::uint64_t ApplyBulkChange(Change&& change, std::string record);
+
+    // Appends the record of a change already applied under the exclusive lock
+    std::uint64_t Log(std::string record);
+    void CompactionLoop();
+    bool NeedsCompaction() const;
+    BookDetails MakeDetails(const std::string& id, const BookRecord& book) const;
+    domain::Book MakeBook(const std::string& id, const BookRecord& book) const;
+
+    Config config_;
+
+    mutable std::shared_mutex mutex_;
+    // Primary indexes
+    std::unordered_map<std::string, std::string> authors_;
+    std::unordered_map<std::string, BookRecord> books_;
+    // Secondary indexes
+    std::map<std::string, std::string> author_ids_by_name_;
+    std::multimap<std::string, std::string> book_ids_by_title_;
+    // Books of every author keyed by publication year, title and id, the order they are listed in
+    std::unordered_map<std::string, std::set<AuthorBookKey>> books_by_author_;
+    // Book counts, maintained along with the indexes; books per author are the sizes of books_by_author_
+    std::map<std::string, std::uint64_t> books_per_tag_;
+    std::map<int, std::uint64_t> books_per_year_;
+    // Records in the log, live or not. Compaction resets it under the shared lock.
+    std::atomic<std::size_t> log_records_{0};
+
+    WriteAheadLog log_;
+
+    std::mutex compaction_mutex_;
+    std::condition_variable compaction_stop_;
+    bool stopping_ = false;
+    std::thread compaction_thread_;
+};
+
+class AuthorRepositoryImpl : public domain::AuthorRepository {
+public:
+    explicit AuthorRepositoryImpl(Catalog& catalog)
+        : catalog_{catalog}
+    {}
+
+    void Save(const domain::Author& author) override;
+    std::vector<domain::Author> GetAuthors() override;
+    domain::Stream<domain::Author> StreamAuthors() override;
+    void Delete(std::string& name) override;
+    void Edit(std::string& new_name, std::string& old_name) override;
+
+private:
+    Catalog& catalog_;
+};
+
+class BookRepositoryImpl : public domain::BookRepository {
+public:
+    explicit BookRepositoryImpl(Catalog& catalog)
+        : catalog_{catalog}
+    {}
+
+    void Save(const domain::Book& book) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string>> ShowBooks() override;
+    domain::Stream<std::tuple<std::string, std::string, int, std::string>> StreamBooks() override;
+    domain::Stream<domain::Book> StreamBooksByAuthor() override;
+    std::vector<domain::Book> GetAuthorBooks(const std::string& author_id) override;
+    std::vector<domain::Book> GetAuthorBooksPage(const std::string& author_id,
+                                                 const std::optional<domain::AuthorBooksCursor>& after,
+                                                 std::size_t limit) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBook(std::string& book_name) override;
+    std::vector<std::tuple<std::string, std::string, int, std::string, std::set<std::string>>> ShowBooksDetails(const std::vector<std::string>& book_ids) override;
+    void DeleteBook(std::string& book_id) override;
+    void EditBook(std::string& title, int publication_year, std::set<std::string> tags, std::string& id) override;
+    domain::CatalogStats GetCatalogStats(domain::StatsSource source) override;
+    std::uint64_t DeleteBooksByTag(const std::string& tag) override;
+    std::uint64_t RetagBooks(const std::string& from, const std::string& to) override;
+    std::uint64_t DeleteBooksByAuthorAndYearRange(const std::string& author_id, int min_year, int max_year) override;
+
+private:
+    Catalog& catalog_;
+};
+
+// Counterpart of postgres::Database over a log file
+class Database {
+public:
+    explicit Database(Catalog::Config config);
+
+    AuthorRepositoryImpl& GetAuthors() & {
+        return authors_;
+    }
+
+    BookRepositoryImpl& GetBooks() & {
+        return books_;
+    }
+
+private:
+    Catalog catalog_;
+    AuthorRepositoryImpl authors_{catalog_};
+    BookRepositoryImpl books_{catalog_};
+};
+
+}  // namespace storage
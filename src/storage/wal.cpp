@@ -0,0 +1,261 @@
+#include "wal.h"
+
+#include <boost/crc.hpp>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "../util/mapped_file.h"
+
+namespace storage {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::size_t HEADER_SIZE = 8;
+
+std::uint32_t Crc32(std::string_view data) {
+    boost::crc_32_type crc;
+    crc.process_bytes(data.data(), data.size());
+    return crc.checksum();
+}
+
+void PutUint32(std::string& out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+std::uint32_t GetUint32(const char* data) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+void AppendFramed(std::string& out, std::string_view record) {
+    PutUint32(out, static_cast<std::uint32_t>(record.size()));
+    PutUint32(out, Crc32(record));
+    out += record;
+}
+
+[[noreturn]] void ThrowSystemError(const std::string& what) {
+    throw std::runtime_error(what + ": "s + std::strerror(errno));
+}
+
+}  // namespace
+
+WriteAheadLog::WriteAheadLog(Config config, const RecordSink& on_record)
+    : config_{std::move(config)} {
+    Replay(on_record);
+    OpenForAppend();
+    writer_ = std::thread{&WriteAheadLog::WriteLoop, this};
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard lock{mutex_};
+        stopping_ = true;
+    }
+    records_queued_.notify_one();
+    writer_.join();
+    ::close(fd_);
+}
+
+void WriteAheadLog::Replay(const RecordSink& on_record) {
+    std::error_code ec;
+    if (!std::filesystem::exists(config_.path, ec)) {
+        return;
+    }
+
+    std::size_t valid_size = 0;
+    std::size_t file_size = 0;
+    {
+        util::MappedFile file{config_.path};
+        const auto data = file.GetData();
+        file_size = data.size();
+        while (data.size() - valid_size >= HEADER_SIZE) {
+            const auto size = GetUint32(data.data() + valid_size);
+            const auto crc = GetUint32(data.data() + valid_size + 4);
+            if (data.size() - valid_size - HEADER_SIZE < size) {
+                break;
+            }
+            const auto record = data.substr(valid_size + HEADER_SIZE, size);
+            if (Crc32(record) != crc) {
+                break;
+            }
+            on_record(record);
+            valid_size += HEADER_SIZE + size;
+        }
+    }
+
+    if (valid_size != file_size) {
+        // Torn write of the last batch before a crash
+        std::filesystem::resize_file(config_.path, valid_size);
+    }
+    size_ = valid_size;
+}
+
+void WriteAheadLog::OpenForAppend() {
+    fd_ = ::open(config_.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        ThrowSystemError("Failed to open log "s + config_.path);
+    }
+}
+
+std::uint64_t WriteAheadLog::Append(std::string record) {
+    std::uint64_t sequence;
+    {
+        std::lock_guard lock{mutex_};
+        if (!error_.empty()) {
+            throw std::runtime_error(error_);
+        }
+        queue_.push_back(std::move(record));
+        sequence = ++last_queued_;
+    }
+    records_queued_.notify_one();
+    return sequence;
+}
+
+void WriteAheadLog::WaitDurable(std::uint64_t sequence) {
+    std::unique_lock lock{mutex_};
+    records_durable_.wait(lock, [this, sequence] {
+        return last_durable_ >= sequence || !error_.empty();
+    });
+    if (last_durable_ < sequence) {
+        throw std::runtime_error(error_);
+    }
+}
+
+void WriteAheadLog::WriteLoop() {
+    std::vector<std::string> batch;
+    std::string buffer;
+    std::unique_lock lock{mutex_};
+    while (true) {
+        records_queued_.wait(lock, [this] {
+            return stopping_ || !queue_.empty();
+        });
+        if (queue_.empty()) {
+            return;
+        }
+
+        batch.clear();
+        batch.swap(queue_);
+        const auto last = last_queued_;
+        writing_ = true;
+        lock.unlock();
+
+        buffer.clear();
+        for (const auto& record : batch) {
+            AppendFramed(buffer, record);
+        }
+        std::string error;
+        try {
+            WriteAll(fd_, buffer);
+            Sync(fd_);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+
+        lock.lock();
+        writing_ = false;
+        if (error.empty()) {
+            last_durable_ = last;
+            size_ += buffer.size();
+        } else {
+            // The log may now end with a partial batch, and replay stops there. Anything written
+            // after it would be lost on restart, so the log stops: nothing more is written
+            // and last_durable_ never moves again.
+            error_ = std::move(error);
+            queue_.clear();
+        }
+        records_durable_.notify_all();
+    }
+}
+
+void WriteAheadLog::Rewrite(const std::function<void(const RecordSink&)>& write_records) {
+    std::unique_lock lock{mutex_};
+    // Let the writer finish the current batch; the lock keeps it from starting another
+    records_durable_.wait(lock, [this] {
+        return !writing_;
+    });
+    if (!error_.empty()) {
+        // The caller's state has changes whose records failed; writing them now would make them durable
+        throw std::runtime_error(error_);
+    }
+
+    const auto temp_path = config_.path + ".compact"s;
+    const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ThrowSystemError("Failed to create "s + temp_path);
+    }
+
+    std::uint64_t size = 0;
+    try {
+        std::string buffer;
+        write_records([&](std::string_view record) {
+            AppendFramed(buffer, record);
+            if (buffer.size() >= (1u << 20)) {
+                WriteAll(fd, buffer);
+                size += buffer.size();
+                buffer.clear();
+            }
+        });
+        WriteAll(fd, buffer);
+        size += buffer.size();
+        Sync(fd);
+    } catch (...) {
+        ::close(fd);
+        std::filesystem::remove(temp_path);
+        throw;
+    }
+    ::close(fd);
+
+    std::filesystem::rename(temp_path, config_.path);
+    // Make the rename itself durable
+    const auto dir = std::filesystem::path{config_.path}.parent_path();
+    const int dir_fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        Sync(dir_fd);
+        ::close(dir_fd);
+    }
+
+    ::close(fd_);
+    OpenForAppend();
+    queue_.clear();
+    last_durable_ = last_queued_;
+    size_ = size;
+    records_durable_.notify_all();
+}
+
+std::uint64_t WriteAheadLog::GetSize() const {
+    std::lock_guard lock{mutex_};
+    return size_;
+}
+
+void WriteAheadLog::WriteAll(int fd, const std::string& data) const {
+    std::size_t written = 0;
+    while (written < data.size()) {
+        const auto result = ::write(fd, data.data() + written, data.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ThrowSystemError("Failed to write log "s + config_.path);
+        }
+        written += static_cast<std::size_t>(result);
+    }
+}
+
+void WriteAheadLog::Sync(int fd) const {
+    if (config_.sync && ::fdatasync(fd) != 0) {
+        ThrowSystemError("Failed to sync log "s + config_.path);
+    }
+}
+
+}  // namespace storage
@@ -0,0 +1,86 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace storage {
+
+/**
+ * Append-only log of opaque records. Every record is framed as
+ * [payload size: u32][CRC-32 of payload: u32][payload], little endian.
+ *
+ * Appends are queued and written by a background thread. While it waits for
+ * fdatasync of one batch, new records pile up and go to disk with the next
+ * one, so concurrent writers share the cost of a sync (group commit).
+ *
+ * On open, the log is replayed up to the first torn or corrupted record;
+ * everything after it was never acknowledged and is cut off.
+ *
+ * A failed write or sync stops the log for good: the batch may be torn on disk,
+ * so nothing after it could be replayed. Its waiters and all later calls fail.
+ */
+class WriteAheadLog {
+public:
+    using RecordSink = std::function<void(std::string_view)>;
+
+    struct Config {
+        std::string path;
+        // Without it records survive a process crash but not a power loss
+        bool sync = true;
+    };
+
+    // Calls on_record for every intact record of an existing log
+    WriteAheadLog(Config config, const RecordSink& on_record);
+    // Writes the queued records and closes the log
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Queues the record and returns its sequence number.
+    // Records reach the disk in the order they were queued.
+    // Throws if writing the log failed.
+    std::uint64_t Append(std::string record);
+
+    // Blocks until the record with the sequence number and all before it are durable.
+    // Throws if writing the log failed.
+    void WaitDurable(std::uint64_t sequence);
+
+    // Atomically replaces the log with the records write_records passes to its sink.
+    // The caller must not append concurrently, and the new records must cover
+    // everything appended so far: all queued records count as durable afterwards.
+    // Throws if writing the log failed.
+    void Rewrite(const std::function<void(const RecordSink&)>& write_records);
+
+    std::uint64_t GetSize() const;
+
+private:
+    void Replay(const RecordSink& on_record);
+    void OpenForAppend();
+    void WriteLoop();
+    void WriteAll(int fd, const std::string& data) const;
+    void Sync(int fd) const;
+
+    Config config_;
+    int fd_ = -1;
+
+    mutable std::mutex mutex_;
+    std::condition_variable records_queued_;
+    std::condition_variable records_durable_;
+    std::vector<std::string> queue_;
+    std::uint64_t last_queued_ = 0;
+    std::uint64_t last_durable_ = 0;
+    std::uint64_t size_ = 0;
+    bool writing_ = false;
+    bool stopping_ = false;
+    std::string error_;
+
+    std::thread writer_;
+};
+
+}  // namespace storage
@@ -3,11 +3,16 @@
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <ranges>
 
 #include "../app/use_cases.h"
 #include "../menu/menu.h"
+#include "../util/command_context.h"
 
 using namespace std::literals;
 namespace ph = std::placeholders;
@@ -22,6 +27,13 @@ std::ostream& operator<<(std::ostream& out, const AuthorInfo& author) {
 
 std::ostream& operator<<(std::ostream& out, const BookInfo& book) {
     out << book.title << ", " << book.publication_year;
+    if (book.tags && !book.tags->empty()) {
+        out << " (";
+        for (auto it = book.tags->begin(); it != book.tags->end(); ++it) {
+            out << (it == book.tags->begin() ? "" : ", ") << *it;
+        }
+        out << ")";
+    }
     return out;
 }
 
@@ -30,38 +42,180 @@ std::ostream& operator<<(std::ostream& out, const NewBooksInfo& book) {
     return out;
 }
 
+// Book of a streamed list, printed from the stream's row rather than a copy of it
+struct BookLine {
+    std::string_view title;
+    std::string_view author;
+    int publication_year;
+};
+
+std::ostream& operator<<(std::ostream& out, const BookLine& book) {
+    out << book.title << " by " << book.author << ", " << book.publication_year;
+    return out;
+}
+
+std::ostream& operator<<(std::ostream& out, const SimilarBookInfo& book) {
+    out << book.title << " by " << book.author << ", " << book.publication_year
+        << " (similarity " << book.similarity << ")";
+    return out;
+}
+
 }  // namespace detail
 
-template <typename T>
-void PrintVector(std::ostream& out, const std::vector<T>& vector) {
+// Books listed by the SimilarBooks command
+constexpr std::size_t SIMILAR_BOOKS_COUNT = 10;
+// Books of an author fetched and printed at once by the ShowAuthorBooks command
+constexpr std::size_t AUTHOR_BOOKS_PAGE_SIZE = 1000;
+// SelectBook prefetches the details of this many books from the top of its list, a query at a time
+constexpr std::size_t PREFETCHED_BOOKS = 256;
+constexpr std::size_t PREFETCH_QUERY_BOOKS = 64;
+
+// Trims the tag and collapses runs of spaces, as tags entered in AddBook and EditBook are
+std::string NormalizeTag(std::string tag) {
+    boost::algorithm::trim(tag);
+    tag.erase(std::unique(tag.begin(), tag.end(), [](char lhs, char rhs) {
+        return lhs == ' ' && rhs == ' ';
+    }), tag.end());
+    return tag;
+}
+
+// Splits comma separated tags, normalizing each one like NormalizeTag; empty ones are dropped.
+// Only the tags kept are copied out of the command arena.
+std::set<std::string> ParseTags(std::string_view tags_str) {
+    constexpr std::string_view WHITESPACE = " \t\n\v\f\r"sv;
+    std::set<std::string> tags;
+    std::pmr::string tag{util::GetCommandResource()};
+    tag.reserve(tags_str.size());
+    for (std::size_t start = 0; start <= tags_str.size();) {
+        const auto comma = std::min(tags_str.find(',', start), tags_str.size());
+        auto piece = tags_str.substr(start, comma - start);
+        start = comma + 1;
+
+        const auto first = piece.find_first_not_of(WHITESPACE);
+        if (first == std::string_view::npos)
+            continue;
+        piece = piece.substr(first, piece.find_last_not_of(WHITESPACE) - first + 1);
+
+        tag.clear();
+        for (const char c : piece) {
+            if (c != ' ' || tag.back() != ' ')
+                tag.push_back(c);
+        }
+        tags.emplace(tag);
+    }
+    return tags;
+}
+
+// Parses "<from>-<to>", "<from>-", "-<to>" or "<year>"; throws if the years are not numbers
+void ParseYears(const std::string& years, std::optional<int>& min_year, std::optional<int>& max_year) {
+    if (const auto dash = years.find('-'); dash != std::string::npos) {
+        if (dash > 0)
+            min_year = std::stoi(years.substr(0, dash));
+        if (dash + 1 < years.size())
+            max_year = std::stoi(years.substr(dash + 1));
+    } else if (!years.empty()) {
+        min_year = max_year = std::stoi(years);
+    }
+}
+
+void PrefetchStats::Print(std::ostream& out) const {
+    const auto selections = hits + misses;
+    out << "Book details prefetch: "sv << hits << " hits, "sv << misses << " misses"sv;
+    if (selections > 0)
+        out << " ("sv << 100.0 * hits / selections << "% hit ratio)"sv;
+    out << ", "sv << std::chrono::duration<double, std::milli>(latency_saved).count() << " ms saved"sv << std::endl;
+}
+
+template <typename Key>
+void PrintCounts(std::ostream& out, std::string_view title,
+                 const std::vector<std::pair<Key, std::uint64_t>>& counts) {
+    out << title << std::endl;
+    for (const auto& [key, books] : counts) {
+        out << "  " << key << ": " << books << std::endl;
+    }
+}
+
+// Prints the entries the two lists disagree on; returns how many there are
+template <typename Key>
+std::size_t PrintCountDifferences(std::ostream& out, std::string_view title,
+                                  const std::vector<std::pair<Key, std::uint64_t>>& summary,
+                                  const std::vector<std::pair<Key, std::uint64_t>>& recomputed) {
+    std::map<Key, std::pair<std::uint64_t, std::uint64_t>> counts;
+    for (const auto& [key, books] : summary)
+        counts[key].first = books;
+    for (const auto& [key, books] : recomputed)
+        counts[key].second = books;
+
+    std::size_t differences = 0;
+    for (const auto& [key, books] : counts) {
+        if (books.first != books.second) {
+            out << title << " " << key << ": " << books.first << " in summary, " << books.second
+                << " recomputed" << std::endl;
+            ++differences;
+        }
+    }
+    return differences;
+}
+
+// Prints every row as it is produced, so rows of a stream show up before the rest are read
+template <typename Range>
+void PrintRange(std::ostream& out, Range&& range) {
     int i = 1;
-    for (auto& value : vector) {
+    for (auto&& value : range) {
         out << i++ << " " << value << std::endl;
     }
 }
 
-View::View(menu::Menu& menu, app::UseCases& use_cases, std::istream& input, std::ostream& output)
+View::View(menu::Menu& menu, app::UseCases& use_cases, std::istream& input, std::ostream& output,
+           PrefetchStats* prefetch_stats)
     : menu_{menu}
     , use_cases_{use_cases}
     , input_{input}
     , output_{output} 
+    , prefetch_stats_{prefetch_stats}
 {
-    menu_.AddAction(  //
+    AddCommand(  //
         "AddAuthor"s, "name"s, "Adds author"s, std::bind(&View::AddAuthor, this, ph::_1)
         // 
         // [this](auto& cmd_input) { return AddAuthor(cmd_input); }
     );
-    menu_.AddAction("AddBook"s, "<pub year> <title>"s, "Adds book"s,
+    AddCommand("AddBook"s, "<pub year> <title>"s, "Adds book"s,
                     std::bind(&View::AddBook, this, ph::_1));
-    menu_.AddAction("ShowAuthors"s, {}, "Show authors"s, std::bind(&View::ShowAuthors, this));
-    menu_.AddAction("ShowBooks"s, {}, "Show books"s, std::bind(&View::ShowBooks, this));
-    menu_.AddAction("ShowAuthorBooks"s, {}, "Show author books"s,
+    AddCommand("ShowAuthors"s, {}, "Show authors"s, std::bind(&View::ShowAuthors, this));
+    AddCommand("ShowBooks"s, {}, "Show books"s, std::bind(&View::ShowBooks, this));
+    AddCommand("ShowAuthorBooks"s, {}, "Show author books"s,
                     std::bind(&View::ShowAuthorBooks, this));
-    menu_.AddAction("DeleteAuthor"s, "<author_name>"s, "Delete author"s, std::bind(&View::DeleteAuthor, this, ph::_1));
-    menu_.AddAction("EditAuthor"s, "<author_name>"s, "Edit Author name"s, std::bind(&View::EditAuthor, this, ph::_1));
-    menu_.AddAction("ShowBook"s, "<book_name>"s, "Shows book info"s, std::bind(&View::ShowBook, this, ph::_1));
-    menu_.AddAction("DeleteBook"s, "<book_name>"s, "Delete book"s, std::bind(&View::DeleteBook, this, ph::_1));
-    menu_.AddAction("EditBook"s, "<book_name>"s, "Edit book"s, std::bind(&View::EditBook, this, ph::_1));
+    AddCommand("DeleteAuthor"s, "<author_name>"s, "Delete author"s, std::bind(&View::DeleteAuthor, this, ph::_1));
+    AddCommand("EditAuthor"s, "<author_name>"s, "Edit Author name"s, std::bind(&View::EditAuthor, this, ph::_1));
+    AddCommand("ShowBook"s, "<book_name>"s, "Shows book info"s, std::bind(&View::ShowBook, this, ph::_1));
+    AddCommand("DeleteBook"s, "<book_name>"s, "Delete book"s, std::bind(&View::DeleteBook, this, ph::_1));
+    AddCommand("EditBook"s, "<book_name>"s, "Edit book"s, std::bind(&View::EditBook, this, ph::_1));
+    AddCommand("CatalogStats"s, "[verify]"s, "Shows book counts per author, tag and year"s,
+                    std::bind(&View::CatalogStats, this, ph::_1));
+    AddCommand("SearchBooks"s, "<title part>"s, "Finds books by parts of title and author name and by years"s,
+                    std::bind(&View::SearchBooks, this, ph::_1));
+    AddCommand("SimilarBooks"s, "<book_name>"s, "Shows books with the most tags in common"s,
+                    std::bind(&View::SimilarBooks, this, ph::_1));
+    AddCommand("FindDuplicates"s, {}, "Shows books of the same author with near-identical titles"s,
+                    std::bind(&View::FindDuplicates, this));
+    AddCommand("DeleteBooksByTag"s, "<tag>"s, "Deletes all books with the tag"s,
+                    std::bind(&View::DeleteBooksByTag, this, ph::_1));
+    AddCommand("RetagBooks"s, "<from tag>, <to tag>"s, "Replaces a tag with another one in all books"s,
+                    std::bind(&View::RetagBooks, this, ph::_1));
+    AddCommand("DeleteBooksByAuthorAndYearRange"s, "<author_name>"s, "Deletes the author's books published in the years"s,
+                    std::bind(&View::DeleteBooksByAuthorAndYearRange, this, ph::_1));
+}
+
+View::~View() {
+    CancelPrefetch();
+    SettlePrefetch();
+}
+
+void View::AddCommand(std::string name, std::string args, std::string description, std::function<bool(std::istream&)> handler) {
+    menu_.AddAction(std::move(name), std::move(args), std::move(description), [this, handler = std::move(handler)](std::istream& cmd_input) {
+        SettlePrefetch();
+        return handler(cmd_input);
+    });
 }
 
 bool View::AddAuthor(std::istream& cmd_input) const {
@@ -93,15 +247,16 @@ bool View::DeleteAuthor(std::istream& cmd_input) const {
 
             auto authors = GetAuthors();
 
-            auto author = std::find_if(authors.begin(), authors.end(), [&id](ui::detail::AuthorInfo inf)
+            auto author = std::find_if(authors.begin(), authors.end(), [&id](const ui::detail::AuthorInfo& inf)
                 {
-                    return id == inf.id;
+                    return *id == std::string_view{inf.id};
                 });
 
             if (author == authors.end())
                 throw std::runtime_error("");
 
-            use_cases_.DeleteAuthor(author->name);
+            std::string name{author->name};
+            use_cases_.DeleteAuthor(name);
         }
         else
         {
@@ -139,15 +294,16 @@ bool View::EditAuthor(std::istream& cmd_input) const
             boost::algorithm::trim(new_name);
 
             auto authors = GetAuthors();
-            auto author = std::find_if(authors.begin(), authors.end(), [&id](ui::detail::AuthorInfo inf)
+            auto author = std::find_if(authors.begin(), authors.end(), [&id](const ui::detail::AuthorInfo& inf)
                 {
-                    return id == inf.id;
+                    return *id == std::string_view{inf.id};
                 });
 
             if (author == authors.end())
                 throw std::runtime_error("");
 
-            use_cases_.EditAuthor(new_name, author->name);
+            std::string name{author->name};
+            use_cases_.EditAuthor(new_name, name);
         }
         else
         {
@@ -157,9 +313,9 @@ bool View::EditAuthor(std::istream& cmd_input) const
             boost::algorithm::trim(author_name);
 
             auto authors = GetAuthors();
-            auto author = std::find_if(authors.begin(), authors.end(), [&author_name](ui::detail::AuthorInfo inf)
+            auto author = std::find_if(authors.begin(), authors.end(), [&author_name](const ui::detail::AuthorInfo& inf)
                 {
-                    return author_name == inf.name;
+                    return author_name == std::string_view{inf.name};
                 });
 
             if (author == authors.end())
@@ -183,7 +339,7 @@ bool View::AddBook(std::istream& cmd_input) const {
                 return true;
 
             auto author_id_t = util::TaggedUUID<domain::detail::AuthorTag>::FromString(params->author_id);
-            use_cases_.AddBook(params->publication_year, params->title, author_id_t, params->tags);
+            use_cases_.AddBook(params->publication_year, params->title, author_id_t, std::move(params->tags));
         }
     } catch (const std::exception&) {
         output_ << "Failed to add book"sv << std::endl;
@@ -192,12 +348,17 @@ bool View::AddBook(std::istream& cmd_input) const {
 }
 
 bool View::ShowAuthors() const {
-    PrintVector(output_, GetAuthors());
+    auto authors = use_cases_.StreamAuthors();
+    PrintRange(output_, authors | std::views::transform(&domain::Author::GetName));
     return true;
 }
 
 bool View::ShowBooks() const {
-    PrintVector(output_, GetBooks());
+    auto books = use_cases_.StreamBooks();
+    PrintRange(output_, books | std::views::transform([](const auto& book) {
+        const auto& [title, author, year, id] = book;
+        return detail::BookLine{title, author, year};
+    }));
     return true;
 }
 
@@ -209,12 +370,12 @@ bool View::ShowBook(std::istream& cmd_input) const
     if (book_name_str == "")
     {
         auto id = SelectBook();
-        auto books = GetBooks();
-        auto book_name = std::find_if(books.begin(), books.end(), [&id](ui::detail::NewBooksInfo inf)
-            {
-                return id == inf.id;
-            });
-        auto same_name_books = GetBook(book_name.operator*().title);
+        if (id == std::nullopt)
+            return true;
+
+        auto same_name_books = GetSameTitleBooks(*id);
+        if (same_name_books.empty())
+            return true;
 
         if (same_name_books.size() == 1)
         {
@@ -239,9 +400,9 @@ bool View::ShowBook(std::istream& cmd_input) const
         }
         else
         {
-            auto res_book = std::find_if(same_name_books.begin(), same_name_books.end(), [&book_name](ui::detail::NewBooksInfo inf)
+            auto res_book = std::find_if(same_name_books.begin(), same_name_books.end(), [&id](ui::detail::NewBooksInfo inf)
                 {
-                    return book_name.operator*().id == inf.id;
+                    return *id == inf.id;
                 });
             output_ << "Title: " << res_book.operator*().title << std::endl;
             output_ << "Author: " << res_book.operator*().author << std::endl;
@@ -330,16 +491,7 @@ bool View::DeleteBook(std::istream& cmd_input) const
                 return true;
             }
 
-            auto books = GetBooks();
-            auto book_name = std::find_if(books.begin(), books.end(), [&id](ui::detail::NewBooksInfo inf)
-                {
-                    return id == inf.id;
-                });
-
-            if (book_name == books.end())
-                throw std::runtime_error("");
-
-            auto same_name_books = GetBook(book_name.operator*().title);
+            auto same_name_books = GetSameTitleBooks(*id);
 
             if (same_name_books.empty())
                 throw std::runtime_error("");
@@ -350,9 +502,9 @@ bool View::DeleteBook(std::istream& cmd_input) const
             }
             else
             {
-                auto res_book = std::find_if(same_name_books.begin(), same_name_books.end(), [&book_name](ui::detail::NewBooksInfo inf)
+                auto res_book = std::find_if(same_name_books.begin(), same_name_books.end(), [&id](ui::detail::NewBooksInfo inf)
                     {
-                        return book_name.operator*().id == inf.id;
+                        return *id == inf.id;
                     });
 
                 if (res_book == same_name_books.end())
@@ -415,16 +567,7 @@ bool View::EditBook(std::istream& cmd_input) const
             if (id == std::nullopt)
                 return true;
 
-            auto books = GetBooks();
-            auto book_name = std::find_if(books.begin(), books.end(), [&id](ui::detail::NewBooksInfo inf)
-                {
-                    return id == inf.id;
-                });
-
-            if (book_name == books.end())
-                throw std::runtime_error("");
-
-            auto same_name_books = GetBook(book_name.operator*().title);
+            auto same_name_books = GetSameTitleBooks(*id);
 
             if (same_name_books.empty())
                 throw std::runtime_error("");
@@ -459,40 +602,19 @@ bool View::EditBook(std::istream& cmd_input) const
                 std::getline(input_, tags_action);
                 if (tags_action == "")
                 {
-                    use_cases_.EditBook(title, std::stoi(publication_year), unique_sorted_tags, book.id);
+                    use_cases_.EditBook(title, std::stoi(publication_year), std::move(unique_sorted_tags), book.id);
                     return true;
                 }
 
-                std::vector<std::string> tags;
-                boost::split(tags, tags_action, boost::is_any_of(","));
-                for (auto& tag : tags)
-                {
-                    if (tag.empty())
-                        continue;
+                unique_sorted_tags = ParseTags(tags_action);
 
-                    boost::algorithm::trim(tag);
-                    auto space_pos = tag.find(' ');
-                    if (space_pos != std::string::npos)
-                    {
-                        for (size_t i = space_pos; i < tag.size(); ++i)
-                        {
-                            if (tag[i] == ' ' && tag[i + 1] == ' ')
-                            {
-                                tag.erase(i, 1);
-                                --i;
-                            }
-                        }
-                    }
-                    unique_sorted_tags.insert(tag);
-                }
-
-                use_cases_.EditBook(title, std::stoi(publication_year), unique_sorted_tags, book.id);
+                use_cases_.EditBook(title, std::stoi(publication_year), std::move(unique_sorted_tags), book.id);
             }
             else
             {
-                auto res_book = std::find_if(same_name_books.begin(), same_name_books.end(), [&book_name](ui::detail::NewBooksInfo inf)
+                auto res_book = std::find_if(same_name_books.begin(), same_name_books.end(), [&id](ui::detail::NewBooksInfo inf)
                     {
-                        return book_name.operator*().id == inf.id;
+                        return *id == inf.id;
                     });
 
                 if (res_book == same_name_books.end())
@@ -526,34 +648,13 @@ bool View::EditBook(std::istream& cmd_input) const
                 std::getline(input_, tags_action);
                 if (tags_action == "")
                 {
-                    use_cases_.EditBook(title, std::stoi(publication_year), unique_sorted_tags, book.operator*().id);
+                    use_cases_.EditBook(title, std::stoi(publication_year), std::move(unique_sorted_tags), book.operator*().id);
                     return true;
                 }
 
-                std::vector<std::string> tags;
-                boost::split(tags, tags_action, boost::is_any_of(","));
-                for (auto& tag : tags)
-                {
-                    if (tag.empty())
-                        continue;
-
-                    boost::algorithm::trim(tag);
-                    auto space_pos = tag.find(' ');
-                    if (space_pos != std::string::npos)
-                    {
-                        for (size_t i = space_pos; i < tag.size(); ++i)
-                        {
-                            if (tag[i] == ' ' && tag[i + 1] == ' ')
-                            {
-                                tag.erase(i, 1);
-                                --i;
-                            }
-                        }
-                    }
-                    unique_sorted_tags.insert(tag);
-                }
+                unique_sorted_tags = ParseTags(tags_action);
 
-                use_cases_.EditBook(title, std::stoi(publication_year), unique_sorted_tags, book.operator*().id);
+                use_cases_.EditBook(title, std::stoi(publication_year), std::move(unique_sorted_tags), book.operator*().id);
             }
         }
         else
@@ -614,34 +715,13 @@ bool View::EditBook(std::istream& cmd_input) const
             std::getline(input_, tags_action);
             if (tags_action == "")
             {
-                use_cases_.EditBook(title, std::stoi(publication_year), unique_sorted_tags, book.id);
+                use_cases_.EditBook(title, std::stoi(publication_year), std::move(unique_sorted_tags), book.id);
                 return true;
             }
 
-            std::vector<std::string> tags;
-            boost::split(tags, tags_action, boost::is_any_of(","));
-            for (auto& tag : tags)
-            {
-                if (tag.empty())
-                    continue;
-
-                boost::algorithm::trim(tag);
-                auto space_pos = tag.find(' ');
-                if (space_pos != std::string::npos)
-                {
-                    for (size_t i = space_pos; i < tag.size(); ++i)
-                    {
-                        if (tag[i] == ' ' && tag[i + 1] == ' ')
-                        {
-                            tag.erase(i, 1);
-                            --i;
-                        }
-                    }
-                }
-                unique_sorted_tags.insert(tag);
-            }
+            unique_sorted_tags = ParseTags(tags_action);
 
-            use_cases_.EditBook(title, std::stoi(publication_year), unique_sorted_tags, book.id);
+            use_cases_.EditBook(title, std::stoi(publication_year), std::move(unique_sorted_tags), book.id);
         }
 
     }
@@ -653,11 +733,226 @@ bool View::EditBook(std::istream& cmd_input) const
     return true;
 }
 
+bool View::SearchBooks(std::istream& cmd_input) const
+{
+    search::Query query;
+    std::getline(cmd_input, query.title_contains);
+    boost::algorithm::trim(query.title_contains);
+
+    output_ << "Enter part of author name or empty line for any:" << std::endl;
+    std::getline(input_, query.author_contains);
+    boost::algorithm::trim(query.author_contains);
+
+    output_ << "Enter years as <from>-<to>, <year> or empty line for any:" << std::endl;
+    std::string years;
+    std::getline(input_, years);
+    boost::algorithm::trim(years);
+    try
+    {
+        ParseYears(years, query.min_year, query.max_year);
+    }
+    catch (const std::exception&)
+    {
+        output_ << "Invalid years" << std::endl;
+        return true;
+    }
+
+    std::vector<detail::NewBooksInfo> books;
+    for (const auto& book : use_cases_.SearchBooks(query))
+    {
+        books.emplace_back(std::get<0>(book), std::get<1>(book), std::get<2>(book), std::get<3>(book));
+    }
+    PrintRange(output_, books);
+    return true;
+}
+
+bool View::CatalogStats(std::istream& cmd_input) const
+{
+    std::string mode;
+    cmd_input >> mode;
+    try
+    {
+        if (mode != "verify")
+        {
+            const auto stats = use_cases_.GetCatalogStats(domain::StatsSource::Summary);
+            output_ << "Books: " << stats.books << std::endl;
+            PrintCounts(output_, "Books per author:"sv, stats.books_per_author);
+            PrintCounts(output_, "Books per tag:"sv, stats.books_per_tag);
+            PrintCounts(output_, "Books per year:"sv, stats.books_per_year);
+            return true;
+        }
+
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        const auto summary = use_cases_.GetCatalogStats(domain::StatsSource::Summary);
+        const auto summary_end = Clock::now();
+        const auto recomputed = use_cases_.GetCatalogStats(domain::StatsSource::FullRecompute);
+        const auto recompute_end = Clock::now();
+
+        auto differences = PrintCountDifferences(output_, "Author"sv, summary.books_per_author, recomputed.books_per_author)
+            + PrintCountDifferences(output_, "Tag"sv, summary.books_per_tag, recomputed.books_per_tag)
+            + PrintCountDifferences(output_, "Year"sv, summary.books_per_year, recomputed.books_per_year);
+        if (summary.books != recomputed.books)
+        {
+            output_ << "Books: " << summary.books << " in summary, " << recomputed.books << " recomputed" << std::endl;
+            ++differences;
+        }
+        output_ << (differences == 0 ? "Summary matches a full recompute"sv : "Summary differs from a full recompute"sv)
+                << " (summary "sv << std::chrono::duration<double, std::milli>(summary_end - start).count()
+                << " ms, recompute "sv << std::chrono::duration<double, std::milli>(recompute_end - summary_end).count()
+                << " ms)"sv << std::endl;
+    }
+    catch (const std::exception&)
+    {
+        output_ << "Failed to get catalog statistics" << std::endl;
+    }
+    return true;
+}
+
+bool View::SimilarBooks(std::istream& cmd_input) const
+{
+    std::string book_name_str;
+    std::getline(cmd_input, book_name_str);
+    boost::algorithm::trim(book_name_str);
+
+    std::optional<std::string> id;
+    if (book_name_str == "")
+    {
+        // Only the id is needed, and a prefetch would share the use cases with the query below
+        id = SelectBook(false);
+    }
+    else
+    {
+        auto same_name_books = GetBook(book_name_str);
+        if (same_name_books.size() > 1)
+        {
+            PrintRange(output_, same_name_books);
+            output_ << "Enter the book # or empty line to cancel :" << std::endl;
+            std::string index;
+            std::getline(input_, index);
+            if (index == "")
+                return true;
+
+            const auto indx = static_cast<std::size_t>(std::stoi(index));
+            if (indx < 1 || indx > same_name_books.size())
+                return true;
+            id = same_name_books[indx - 1].id;
+        }
+        else if (!same_name_books.empty())
+        {
+            id = same_name_books.back().id;
+        }
+    }
+    if (id == std::nullopt)
+        return true;
+
+    std::vector<detail::SimilarBookInfo> books;
+    for (const auto& book : use_cases_.SimilarBooks(*id, SIMILAR_BOOKS_COUNT))
+    {
+        books.push_back({book.title, book.author, book.publication_year, book.similarity});
+    }
+    PrintRange(output_, books);
+    return true;
+}
+
+bool View::FindDuplicates() const
+{
+    int i = 1;
+    for (const auto& group : use_cases_.FindDuplicates())
+    {
+        output_ << i++ << " " << group.author << std::endl;
+        for (const auto& book : group.books)
+        {
+            output_ << "   " << book.title << ", " << book.publication_year << std::endl;
+        }
+    }
+    return true;
+}
+
+bool View::DeleteBooksByTag(std::istream& cmd_input) const
+{
+    std::string tag;
+    std::getline(cmd_input, tag);
+    tag = NormalizeTag(std::move(tag));
+    if (tag.empty())
+    {
+        output_ << "Failed to delete books" << std::endl;
+        return true;
+    }
+
+    try
+    {
+        output_ << use_cases_.DeleteBooksByTag(tag) << " books deleted" << std::endl;
+    }
+    catch (const std::exception&)
+    {
+        output_ << "Failed to delete books" << std::endl;
+    }
+    return true;
+}
+
+bool View::RetagBooks(std::istream& cmd_input) const
+{
+    std::string tags;
+    std::getline(cmd_input, tags);
+    const auto comma = tags.find(',');
+    const auto from = NormalizeTag(tags.substr(0, comma));
+    const auto to = comma == std::string::npos ? ""s : NormalizeTag(tags.substr(comma + 1));
+    if (from.empty() || to.empty())
+    {
+        output_ << "Failed to retag books" << std::endl;
+        return true;
+    }
+
+    try
+    {
+        output_ << use_cases_.RetagBooks(from, to) << " books retagged" << std::endl;
+    }
+    catch (const std::exception&)
+    {
+        output_ << "Failed to retag books" << std::endl;
+    }
+    return true;
+}
+
+bool View::DeleteBooksByAuthorAndYearRange(std::istream& cmd_input) const
+{
+    try
+    {
+        std::string author_name;
+        std::getline(cmd_input, author_name);
+        boost::algorithm::trim(author_name);
+        const auto author_id = author_name.empty() ? SelectAuthor() : FindAuthor(author_name);
+        if (author_id == std::nullopt)
+            return true;
+
+        // Every year of the author would be a single empty line away, so a range is required
+        output_ << "Enter years as <from>-<to> or <year>, empty line to cancel:" << std::endl;
+        std::string years;
+        std::getline(input_, years);
+        boost::algorithm::trim(years);
+        if (years.empty())
+            return true;
+
+        std::optional<int> min_year;
+        std::optional<int> max_year;
+        ParseYears(years, min_year, max_year);
+        output_ << use_cases_.DeleteBooksByAuthorAndYearRange(*author_id, min_year.value_or(std::numeric_limits<int>::min()),
+                                                              max_year.value_or(std::numeric_limits<int>::max()))
+                << " books deleted" << std::endl;
+    }
+    catch (const std::exception&)
+    {
+        output_ << "Failed to delete books" << std::endl;
+    }
+    return true;
+}
+
 bool View::ShowAuthorBooks() const {
     // TODO: handle error
     try {
         if (auto author_id = SelectAuthor()) {
-            PrintVector(output_, GetAuthorBooks(*author_id));
+            PrintAuthorBooks(*author_id);
         }
     } catch (const std::exception&) {
         throw std::runtime_error("Failed to Show Books");
@@ -688,9 +983,9 @@ std::optional<detail::AddBookParams> View::GetBookParams(std::istream& cmd_input
     {
         boost::algorithm::trim(author_name);
         auto authors = GetAuthors();
-        auto it = std::find_if(authors.begin(), authors.end(), [&author_name](ui::detail::AuthorInfo inf)
+        auto it = std::find_if(authors.begin(), authors.end(), [&author_name](const ui::detail::AuthorInfo& inf)
             {
-                return inf.name == author_name;
+                return std::string_view{inf.name} == author_name;
             });
         bool is_author_found = it != authors.end();
 
@@ -703,9 +998,9 @@ std::optional<detail::AddBookParams> View::GetBookParams(std::istream& cmd_input
             {
                 use_cases_.AddAuthor(author_name);
                 auto authors = GetAuthors();
-                auto author = std::find_if(authors.begin(), authors.end(), [&author_name](ui::detail::AuthorInfo inf)
+                auto author = std::find_if(authors.begin(), authors.end(), [&author_name](const ui::detail::AuthorInfo& inf)
                     {
-                        return inf.name == author_name;
+                        return std::string_view{inf.name} == author_name;
                     });
                 params.author_id = author->id;
             }
@@ -716,50 +1011,27 @@ std::optional<detail::AddBookParams> View::GetBookParams(std::istream& cmd_input
             params.author_id = it->id;
     }
 
-    std::vector<std::string> tags;
-    std::set<std::string> unique_sorted_tags;
     std::string tags_str;
     output_ << "Enter tags (comma separated):" << std::endl;
     std::getline(input_, tags_str);
 
-    if (tags_str.empty())
-        return params;
-
-    boost::split(tags, tags_str, boost::is_any_of(","));
-    for (auto& tag : tags)
-    {
-        if (tag.empty())
-            continue;
-
-        boost::algorithm::trim(tag);
-        auto space_pos = tag.find(' ');
-        if (space_pos != std::string::npos)
-        {
-            for (size_t i = space_pos; i < tag.size(); ++i)
-            {
-                if (tag[i] == ' ' && tag[i + 1] == ' ')
-                {
-                    tag.erase(i, 1);
-                    --i;
-                }
-            }
-        }
-        unique_sorted_tags.insert(tag);
-    }
-
-    if (!unique_sorted_tags.empty())
-        params.tags = std::move(unique_sorted_tags);
+    if (auto tags = ParseTags(tags_str); !tags.empty())
+        params.tags = std::move(tags);
     return params;
 }
 
-std::optional<std::string> View::SelectBook() const
+std::optional<std::string> View::SelectBook(bool prefetch_details) const
 {
     auto books = GetBooks();
-    PrintVector(output_, books);
+    // Whatever the user picks, the caller needs its details next
+    if (prefetch_details)
+        StartPrefetch(books);
+    PrintRange(output_, books);
     output_ << "Enter the book # or empty line to cancel:" << std::endl;
 
     std::string str;
     if (!std::getline(input_, str) || str.empty()) {
+        CancelPrefetch();
         return std::nullopt;
     }
 
@@ -768,21 +1040,127 @@ std::optional<std::string> View::SelectBook() const
         book_idx = std::stoi(str);
     }
     catch (std::exception const&) {
+        CancelPrefetch();
         throw std::runtime_error("Invalid book num");
     }
 
     --book_idx;
     if (book_idx < 0 or book_idx >= books.size()) {
+        CancelPrefetch();
         throw std::runtime_error("Invalid author num");
     }
 
     return books[book_idx].id;
 }
 
+void View::StartPrefetch(const std::vector<detail::NewBooksInfo>& books) const
+{
+    SettlePrefetch();
+
+    const auto window = std::min(books.size(), PREFETCHED_BOOKS);
+    std::vector<std::string> ids;
+    ids.reserve(window);
+    std::set<std::string_view> window_titles;
+    for (std::size_t i = 0; i < window; ++i)
+    {
+        ids.push_back(books[i].id);
+        window_titles.insert(books[i].title);
+    }
+    // A title with books on both sides of the window cannot be served from it
+    std::set<std::string> partial_titles;
+    for (std::size_t i = window; i < books.size(); ++i)
+    {
+        if (window_titles.contains(books[i].title))
+            partial_titles.insert(books[i].title);
+    }
+
+    prefetch_cancelled_ = false;
+    std::packaged_task<detail::PrefetchedBooks()> task{[this, ids = std::move(ids), partial_titles = std::move(partial_titles)]() mutable {
+        const auto start = std::chrono::steady_clock::now();
+        detail::PrefetchedBooks prefetched;
+        prefetched.partial_titles = std::move(partial_titles);
+        for (std::size_t i = 0; i < ids.size() && !prefetch_cancelled_; i += PREFETCH_QUERY_BOOKS)
+        {
+            const std::vector<std::string> query_ids(ids.begin() + i, ids.begin() + std::min(ids.size(), i + PREFETCH_QUERY_BOOKS));
+            for (const auto& book : use_cases_.ShowBooksDetails(query_ids))
+            {
+                prefetched.books.emplace_back(std::get<0>(book), std::get<1>(book), std::get<2>(book), std::get<3>(book), std::get<4>(book));
+            }
+        }
+        prefetched.duration = std::chrono::steady_clock::now() - start;
+        return prefetched;
+    }};
+    prefetch_ = task.get_future();
+    prefetch_thread_ = std::thread{std::move(task)};
+}
+
+void View::CancelPrefetch() const
+{
+    prefetch_cancelled_ = true;
+}
+
+void View::SettlePrefetch() const
+{
+    if (prefetch_thread_.joinable())
+        prefetch_thread_.join();
+    prefetch_ = {};
+}
+
+std::vector<detail::NewBooksInfo> View::GetSameTitleBooks(const std::string& book_id) const
+{
+    if (prefetch_.valid() && !prefetch_cancelled_)
+    {
+        const auto wait_start = std::chrono::steady_clock::now();
+        try
+        {
+            auto prefetched = prefetch_.get();
+            const auto waited = std::chrono::steady_clock::now() - wait_start;
+
+            auto selected = std::find_if(prefetched.books.begin(), prefetched.books.end(), [&book_id](const detail::NewBooksInfo& inf)
+                {
+                    return inf.id == book_id;
+                });
+            if (selected != prefetched.books.end() && !prefetched.partial_titles.contains(selected->title))
+            {
+                std::vector<detail::NewBooksInfo> same_name_books;
+                for (auto& book : prefetched.books)
+                {
+                    if (book.title == selected->title)
+                        same_name_books.push_back(book);
+                }
+                if (prefetch_stats_)
+                {
+                    ++prefetch_stats_->hits;
+                    prefetch_stats_->latency_saved += std::max(prefetched.duration - waited, std::chrono::nanoseconds::zero());
+                }
+                return same_name_books;
+            }
+        }
+        catch (const std::exception&)
+        {
+            // Fall back to querying the database
+        }
+    }
+
+    if (prefetch_stats_)
+        ++prefetch_stats_->misses;
+
+    auto books = GetBooks();
+    auto book_name = std::find_if(books.begin(), books.end(), [&book_id](ui::detail::NewBooksInfo inf)
+        {
+            return book_id == inf.id;
+        });
+
+    if (book_name == books.end())
+        throw std::runtime_error("");
+
+    return GetBook(book_name.operator*().title);
+}
+
 std::optional<std::string> View::SelectAuthor() const {
     output_ << "Select author:" << std::endl;
     auto authors = GetAuthors();
-    PrintVector(output_, authors);
+    PrintRange(output_, authors);
     output_ << "Enter author # or empty line to cancel" << std::endl;
 
     std::string str;
@@ -802,15 +1180,31 @@ std::optional<std::string> View::SelectAuthor() const {
         throw std::runtime_error("Invalid author num");
     }
 
-    return authors[author_idx].id;
+    return std::string{authors[author_idx].id};
+}
+
+std::optional<std::string> View::FindAuthor(std::string author_name) const {
+    for (const auto& author : GetAuthors()) {
+        if (std::string_view{author.name} == author_name) {
+            return std::string{author.id};
+        }
+    }
+    output_ << "No author found" << std::endl;
+    return std::nullopt;
 }
 
-std::vector<detail::AuthorInfo> View::GetAuthors() const {
-    std::vector<detail::AuthorInfo> dst_autors;
+std::pmr::vector<detail::AuthorInfo> View::GetAuthors() const {
+    const auto authors = use_cases_.GetAuthors();
+    const auto resource = util::GetCommandResource();
+    std::pmr::vector<detail::AuthorInfo> dst_autors{resource};
+    dst_autors.reserve(authors.size());
 
-    for (const auto& author : use_cases_.GetAuthors())
+    for (const auto& author : authors)
     {
-        dst_autors.emplace_back(author.GetId().ToString(), author.GetName());
+        // The id is written straight into the arena, without a std::string on the way
+        std::pmr::string id(util::detail::UUID_TEXT_SIZE, '\0', resource);
+        author.GetId().ToChars(id.data());
+        dst_autors.push_back({std::move(id), std::pmr::string{author.GetName(), resource}});
     }
     return dst_autors;
 }
@@ -835,14 +1229,22 @@ std::vector<detail::NewBooksInfo> View::GetBook(std::string& book_name) const {
     return books;
 }
 
-std::vector<detail::BookInfo> View::GetAuthorBooks(const std::string& author_id) const {
-    std::vector<detail::BookInfo> books;
-    
-    for (const auto& book : use_cases_.GetAuthorBooks(author_id))
-    {
-        books.emplace_back(book.GetTitle(), book.GetPublicationYear());
+void View::PrintAuthorBooks(const std::string& author_id) const {
+    // Only a page of a prolific author's books is held at a time, and is shown as soon as it comes
+    std::optional<domain::AuthorBooksCursor> after;
+    std::size_t i = 1;
+    while (true) {
+        const auto books = use_cases_.GetAuthorBooksPage(author_id, after, AUTHOR_BOOKS_PAGE_SIZE);
+        for (const auto& book : books) {
+            output_ << i++ << " " << detail::BookInfo{book.GetTitle(), book.GetPublicationYear(), book.GetTags()} << '\n';
+        }
+        output_.flush();
+        if (books.size() < AUTHOR_BOOKS_PAGE_SIZE) {
+            break;
+        }
+        const auto& last = books.back();
+        after = domain::AuthorBooksCursor{last.GetPublicationYear(), last.GetTitle(), last.GetBookId().ToString()};
     }
-    return books;
 }
 
 }  // namespace ui
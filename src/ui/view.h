@@ -1,7 +1,14 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <iosfwd>
+#include <memory_resource>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 #include <set>
 
@@ -23,9 +30,10 @@ struct AddBookParams {
     std::optional<std::set<std::string>> tags;
 };
 
+// Transient, so the strings live in the command arena, see util::GetCommandResource
 struct AuthorInfo {
-    std::string id;
-    std::string name;
+    std::pmr::string id;
+    std::pmr::string name;
 };
 
 struct BookInfo {
@@ -43,6 +51,13 @@ struct NewBooksInfo
     std::optional <std::set<std::string>> tags;
 };
 
+struct SimilarBookInfo {
+    std::string title;
+    std::string author;
+    int publication_year;
+    double similarity;
+};
+
 //struct SingleBookInfo
 //{
 //    std::string title;
@@ -51,13 +66,41 @@ struct NewBooksInfo
 //    std::optional<std::set<std::string>> tags;
 //};
 
+struct PrefetchedBooks {
+    std::vector<NewBooksInfo> books;
+    // Titles that listed books outside of the prefetched window have too
+    std::set<std::string> partial_titles;
+    // Time the batched query took in the background
+    std::chrono::nanoseconds duration{};
+};
+
 }  // namespace detail
 
+// Effect of prefetching book details while SelectBook waits for the user's choice
+struct PrefetchStats {
+    // Selections whose details were served from the prefetched ones
+    std::uint64_t hits = 0;
+    // Selections that had to query the database after the choice
+    std::uint64_t misses = 0;
+    // Query time the hits did not have to wait for
+    std::chrono::nanoseconds latency_saved{};
+
+    void Print(std::ostream& out) const;
+};
+
 class View {
 public:
-    View(menu::Menu& menu, app::UseCases& use_cases, std::istream& input, std::ostream& output);
+    View(menu::Menu& menu, app::UseCases& use_cases, std::istream& input, std::ostream& output,
+         PrefetchStats* prefetch_stats = nullptr);
+    ~View();
+
+    View(const View&) = delete;
+    View& operator=(const View&) = delete;
 
 private:
+    // Registers the command with the menu; it settles a cancelled prefetch before it runs
+    void AddCommand(std::string name, std::string args, std::string description, std::function<bool(std::istream&)> handler);
+
     bool AddAuthor(std::istream& cmd_input) const;
     bool DeleteAuthor(std::istream& cmd_input) const;
     bool EditAuthor(std::istream& cmd_input) const;
@@ -68,19 +111,41 @@ private:
     bool ShowBook(std::istream& cmd_input) const;
     bool DeleteBook(std::istream& cmd_input) const;
     bool EditBook(std::istream& cmd_input) const;
+    bool SearchBooks(std::istream& cmd_input) const;
+    bool CatalogStats(std::istream& cmd_input) const;
+    bool SimilarBooks(std::istream& cmd_input) const;
+    bool FindDuplicates() const;
+    bool DeleteBooksByTag(std::istream& cmd_input) const;
+    bool RetagBooks(std::istream& cmd_input) const;
+    bool DeleteBooksByAuthorAndYearRange(std::istream& cmd_input) const;
 
     std::optional<detail::AddBookParams> GetBookParams(std::istream& cmd_input) const;
     std::optional<std::string> SelectAuthor() const;
-    std::optional<std::string> SelectBook() const;
-    std::vector<detail::AuthorInfo> GetAuthors() const;
+    std::optional<std::string> FindAuthor(std::string author_name) const;
+    // Without prefetch_details the caller does not read the book's details with GetSameTitleBooks
+    std::optional<std::string> SelectBook(bool prefetch_details = true) const;
+    std::vector<detail::NewBooksInfo> GetSameTitleBooks(const std::string& book_id) const;
+    void StartPrefetch(const std::vector<detail::NewBooksInfo>& books) const;
+    // Asks a running prefetch to stop after its current query, without waiting for it
+    void CancelPrefetch() const;
+    // Waits for the prefetch thread and drops what it fetched
+    void SettlePrefetch() const;
+    std::pmr::vector<detail::AuthorInfo> GetAuthors() const;
     std::vector<detail::NewBooksInfo> GetBooks() const;
     std::vector<detail::NewBooksInfo> GetBook(std::string& book_name) const;
-    std::vector<detail::BookInfo> GetAuthorBooks(const std::string& author_id) const;
+    // Prints the author's books a page at a time, numbered across the pages
+    void PrintAuthorBooks(const std::string& author_id) const;
 
     menu::Menu& menu_;
     app::UseCases& use_cases_;
     std::istream& input_;
     std::ostream& output_;
+    PrefetchStats* prefetch_stats_;
+    // Details of the books listed by SelectBook, queried while the user makes the choice.
+    // The use cases are not thread-safe, so it has to be settled before any other call.
+    mutable std::future<detail::PrefetchedBooks> prefetch_;
+    mutable std::thread prefetch_thread_;
+    mutable std::atomic<bool> prefetch_cancelled_{false};
 };
 
 }  // namespace ui
\ No newline at end of file
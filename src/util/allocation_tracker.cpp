@@ -0,0 +1,249 @@
+#include "allocation_tracker.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <new>
+#include <ostream>
+
+namespace util {
+
+using namespace std::literals;
+
+namespace {
+
+// Constant-initialized, so operator new can use it before and after the thread's dynamic TLS
+thread_local AllocationCounters thread_allocations;
+
+struct CommandTotals {
+    std::uint64_t invocations = 0;
+    AllocationCounters allocations;
+};
+
+std::mutex commands_mutex;
+std::map<std::string, CommandTotals, std::less<>> commands;
+
+}  // namespace
+
+AllocationCounters GetThreadAllocations() noexcept {
+    return thread_allocations;
+}
+
+void RecordCommandAllocations(std::string_view command, AllocationCounters allocations) {
+    if constexpr (!ALLOCATION_TRACKING_ENABLED) {
+        return;
+    }
+    std::lock_guard lock{commands_mutex};
+    auto it = commands.find(command);
+    if (it == commands.end()) {
+        it = commands.emplace(std::string{command}, CommandTotals{}).first;
+    }
+    auto& totals = it->second;
+    ++totals.invocations;
+    totals.allocations.count += allocations.count;
+    totals.allocations.bytes += allocations.bytes;
+}
+
+std::vector<CommandAllocations> GetCommandAllocations() {
+    std::lock_guard lock{commands_mutex};
+    std::vector<CommandAllocations> result;
+    result.reserve(commands.size());
+    for (const auto& [command, totals] : commands) {
+        result.push_back({command, totals.invocations, totals.allocations});
+    }
+    return result;
+}
+
+void PrintAllocationStats(std::ostream& out) {
+    if constexpr (!ALLOCATION_TRACKING_ENABLED) {
+        return;
+    }
+    const auto old_flags = out.flags();
+    const auto old_precision = out.precision();
+
+    out << std::left << std::setw(16) << "Command"sv << std::right
+        << std::setw(10) << "Calls"sv << std::setw(14) << "Allocations"sv << std::setw(16) << "Bytes"sv
+        << std::setw(14) << "Allocs/call"sv << std::setw(14) << "Bytes/call"sv << std::endl;
+    out << std::fixed << std::setprecision(1);
+    for (const auto& [command, invocations, allocations] : GetCommandAllocations()) {
+        const auto calls = static_cast<double>(std::max<std::uint64_t>(invocations, 1));
+        out << std::left << std::setw(16) << command << std::right
+            << std::setw(10) << invocations << std::setw(14) << allocations.count << std::setw(16) << allocations.bytes
+            << std::setw(14) << allocations.count / calls << std::setw(14) << allocations.bytes / calls << std::endl;
+    }
+
+    out.flags(old_flags);
+    out.precision(old_precision);
+}
+
+void WriteAllocationPrometheus(std::ostream& out) {
+    if constexpr (!ALLOCATION_TRACKING_ENABLED) {
+        return;
+    }
+    const auto stats = GetCommandAllocations();
+    out << "# HELP bookypedia_command_allocations_total Heap allocations made while executing a command\n"sv
+        << "# TYPE bookypedia_command_allocations_total counter\n"sv;
+    for (const auto& command : stats) {
+        out << "bookypedia_command_allocations_total{command=\""sv << command.command << "\"} "sv
+            << command.allocations.count << '\n';
+    }
+    out << "# HELP bookypedia_command_allocated_bytes_total Heap bytes allocated while executing a command\n"sv
+        << "# TYPE bookypedia_command_allocated_bytes_total counter\n"sv;
+    for (const auto& command : stats) {
+        out << "bookypedia_command_allocated_bytes_total{command=\""sv << command.command << "\"} "sv
+            << command.allocations.bytes << '\n';
+    }
+    out.flush();
+}
+
+}  // namespace util
+
+#ifdef BOOKYPEDIA_TRACK_ALLOCATIONS
+
+// Replacements of the global allocation functions. They only bump the thread's
+// counters, so they must not allocate or take locks themselves.
+
+namespace {
+
+void Count(std::size_t size) noexcept {
+    auto& counters = util::thread_allocations;
+    ++counters.count;
+    counters.bytes += size;
+}
+
+void* Allocate(std::size_t size) {
+    Count(size);
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (void* ptr = std::malloc(size)) {
+            return ptr;
+        }
+        if (const auto handler = std::get_new_handler()) {
+            handler();
+        } else {
+            throw std::bad_alloc{};
+        }
+    }
+}
+
+void* Allocate(std::size_t size, std::align_val_t align) {
+    Count(size);
+    const auto alignment = static_cast<std::size_t>(align);
+    // aligned_alloc wants the size to be a multiple of the alignment
+    const auto rounded = (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment;
+    while (true) {
+        if (void* ptr = std::aligned_alloc(alignment, rounded)) {
+            return ptr;
+        }
+        if (const auto handler = std::get_new_handler()) {
+            handler();
+        } else {
+            throw std::bad_alloc{};
+        }
+    }
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    return Allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return Allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    return Allocate(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return Allocate(size, align);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size, align);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size, align);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+// Both malloc and aligned_alloc memory is released with free
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+#endif  // BOOKYPEDIA_TRACK_ALLOCATIONS
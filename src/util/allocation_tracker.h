@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+#ifdef BOOKYPEDIA_TRACK_ALLOCATIONS
+inline constexpr bool ALLOCATION_TRACKING_ENABLED = true;
+#else
+inline constexpr bool ALLOCATION_TRACKING_ENABLED = false;
+#endif
+
+struct AllocationCounters {
+    std::uint64_t count = 0;
+    std::uint64_t bytes = 0;
+};
+
+// Allocations attributed to a command over all of its invocations
+struct CommandAllocations {
+    std::string command;
+    std::uint64_t invocations = 0;
+    AllocationCounters allocations;
+};
+
+// Heap allocations made by the calling thread since it started.
+// When the build is configured with BOOKYPEDIA_TRACK_ALLOCATIONS, the global
+// operator new counts every allocation in thread-local counters; otherwise
+// the counters stay at zero and the functions below do nothing.
+AllocationCounters GetThreadAllocations() noexcept;
+
+// Adds allocations of one invocation of the command to its totals
+void RecordCommandAllocations(std::string_view command, AllocationCounters allocations);
+
+std::vector<CommandAllocations> GetCommandAllocations();
+
+// Human readable table with allocation count and bytes per command and per invocation
+void PrintAllocationStats(std::ostream& out);
+// Prometheus text exposition format
+void WriteAllocationPrometheus(std::ostream& out);
+
+}  // namespace util
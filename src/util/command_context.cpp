@@ -0,0 +1,120 @@
+#include "command_context.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <optional>
+
+namespace util {
+
+namespace {
+
+// The arena starts this large and grows to fit the largest command seen, up to the maximum;
+// what does not fit comes from the heap and is freed when the command ends
+constexpr std::size_t INITIAL_ARENA_SIZE = 64 * 1024;
+constexpr std::size_t MAX_ARENA_SIZE = 16 * 1024 * 1024;
+
+// Heap memory the arena takes for a command once its buffer is full
+class OverflowResource : public std::pmr::memory_resource {
+public:
+    std::size_t GetAllocated() const noexcept {
+        return allocated_;
+    }
+
+    void Reset() noexcept {
+        allocated_ = 0;
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        allocated_ += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::size_t allocated_ = 0;
+};
+
+class CommandArena {
+public:
+    void Begin() {
+        if (!buffer_) {
+            buffer_ = std::make_unique<std::byte[]>(size_);
+        }
+        overflow_.Reset();
+        resource_.emplace(buffer_.get(), size_, &overflow_);
+    }
+
+    void End() noexcept {
+        // Releases the overflow; the buffer is kept for the next command
+        resource_.reset();
+        if (overflow_.GetAllocated() > 0 && size_ < MAX_ARENA_SIZE) {
+            size_ = std::min(MAX_ARENA_SIZE, std::max(size_ * 2, size_ + overflow_.GetAllocated()));
+            buffer_.reset();
+        }
+    }
+
+    std::pmr::memory_resource* Get() noexcept {
+        return resource_ ? &*resource_ : std::pmr::get_default_resource();
+    }
+
+private:
+    std::size_t size_ = INITIAL_ARENA_SIZE;
+    std::unique_ptr<std::byte[]> buffer_;
+    OverflowResource overflow_;
+    std::optional<std::pmr::monotonic_buffer_resource> resource_;
+};
+
+std::atomic<std::uint64_t> last_invocation{0};
+thread_local CommandInfo current_command;
+thread_local CommandArena command_arena;
+
+}  // namespace
+
+CommandInfo GetCurrentCommand() noexcept {
+    return current_command;
+}
+
+std::pmr::memory_resource* GetCommandResource() noexcept {
+    return command_arena.Get();
+}
+
+CommandScope::CommandScope(std::string_view name) noexcept
+    : previous_{current_command}
+    , allocations_at_start_{GetThreadAllocations()} {
+    current_command = {name, last_invocation.fetch_add(1, std::memory_order_relaxed) + 1};
+    if (previous_.invocation == 0) {
+        try {
+            command_arena.Begin();
+            owns_arena_ = true;
+        } catch (const std::exception&) {
+            // Without a buffer, the command allocates from the default resource
+        }
+    }
+}
+
+CommandScope::~CommandScope() {
+    if (owns_arena_) {
+        command_arena.End();
+    }
+    if constexpr (ALLOCATION_TRACKING_ENABLED) {
+        const auto allocations = GetThreadAllocations();
+        try {
+            RecordCommandAllocations(current_command.name, {allocations.count - allocations_at_start_.count,
+                                                            allocations.bytes - allocations_at_start_.bytes});
+        } catch (const std::exception&) {
+            // Losing the statistics of one command is better than terminating
+        }
+    }
+    current_command = previous_;
+}
+
+}  // namespace util
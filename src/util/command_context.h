@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+
+#include "allocation_tracker.h"
+
+namespace util {
+
+// User command the current thread is executing. Lower layers use it to attribute
+// the work they do (SQL statements, allocations) to the command that caused it.
+struct CommandInfo {
+    // Empty outside of any command
+    std::string_view name;
+    // Unique for every execution of a command, 0 outside of any command
+    std::uint64_t invocation = 0;
+};
+
+CommandInfo GetCurrentCommand() noexcept;
+
+// Memory for the transient allocations of the command the current thread executes:
+// a monotonic arena, so allocating is a pointer bump and everything is freed at once
+// when the outermost scope ends. Outside of any command it is the default resource.
+// Nothing allocated from it may outlive the command or be used by another thread.
+//
+// The View's scratch data comes from it: tag parsing and the author list. What crosses
+// app::UseCases does not: its arguments and results are std types shared with the executor
+// workers, the prefetch thread and the storage backend, which keeps them, so those calls pass
+// their temporaries on by move and the Postgres repository binds parameters instead of
+// building query strings.
+std::pmr::memory_resource* GetCommandResource() noexcept;
+
+// Marks the current thread as executing the command until the scope ends.
+// The name must outlive the scope. Scopes may nest, the innermost one wins.
+// Heap allocations made inside the scope are added to the command's totals,
+// including those of nested scopes. The outermost scope owns the command arena.
+class CommandScope {
+public:
+    explicit CommandScope(std::string_view name) noexcept;
+    ~CommandScope();
+
+    CommandScope(const CommandScope&) = delete;
+    CommandScope& operator=(const CommandScope&) = delete;
+
+private:
+    CommandInfo previous_;
+    AllocationCounters allocations_at_start_;
+    bool owns_arena_ = false;
+};
+
+}  // namespace util
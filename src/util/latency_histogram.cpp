@@ -0,0 +1,94 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace util {
+
+void LatencyHistogram::Record(Duration latency) noexcept {
+    const auto value = static_cast<std::uint64_t>(std::max<Duration::rep>(latency.count(), 0));
+
+    buckets_[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    auto max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+std::uint64_t LatencyHistogram::GetCount() const noexcept {
+    return count_.load(std::memory_order_relaxed);
+}
+
+LatencyHistogram::Duration LatencyHistogram::GetSum() const noexcept {
+    return Duration{static_cast<Duration::rep>(sum_.load(std::memory_order_relaxed))};
+}
+
+LatencyHistogram::Duration LatencyHistogram::GetMax() const noexcept {
+    return Duration{static_cast<Duration::rep>(max_.load(std::memory_order_relaxed))};
+}
+
+LatencyHistogram::Duration LatencyHistogram::GetPercentile(double percentile) const noexcept {
+    const auto count = GetCount();
+    if (count == 0) {
+        return Duration::zero();
+    }
+
+    const auto rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(count))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(Duration{static_cast<Duration::rep>(GetBucketUpperBound(i))}, GetMax());
+        }
+    }
+    return GetMax();
+}
+
+std::uint64_t LatencyHistogram::GetCountAtOrBelow(Duration bound) const noexcept {
+    if (bound < Duration::zero()) {
+        return 0;
+    }
+    const auto last = GetBucketIndex(static_cast<std::uint64_t>(bound.count()));
+    std::uint64_t result = 0;
+    for (std::size_t i = 0; i <= last; ++i) {
+        result += buckets_[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void LatencyHistogram::Reset() noexcept {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+std::size_t LatencyHistogram::GetBucketIndex(std::uint64_t value) noexcept {
+    if (value < SUB_BUCKET_COUNT) {
+        return static_cast<std::size_t>(value);
+    }
+    const auto magnitude = static_cast<int>(std::bit_width(value)) - 1;
+    if (magnitude >= MAX_VALUE_BITS) {
+        return BUCKET_COUNT - 1;
+    }
+    const auto shift = magnitude - SUB_BUCKET_BITS;
+    const auto sub_bucket = (value >> shift) & (SUB_BUCKET_COUNT - 1);
+    return static_cast<std::size_t>((shift + 1) * SUB_BUCKET_COUNT + sub_bucket);
+}
+
+std::uint64_t LatencyHistogram::GetBucketUpperBound(std::size_t index) noexcept {
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    const auto shift = index / SUB_BUCKET_COUNT - 1;
+    const auto sub_bucket = index % SUB_BUCKET_COUNT;
+    return ((SUB_BUCKET_COUNT + sub_bucket + 1) << shift) - 1;
+}
+
+}  // namespace util
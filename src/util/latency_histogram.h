@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace util {
+
+/**
+ * Histogram of latencies with a fixed relative precision over the whole range,
+ * in the spirit of HdrHistogram. Values are kept in nanoseconds: every power of two
+ * is split into 2^SUB_BUCKET_BITS linear sub-buckets, so any recorded value is
+ * reported with an error below 1 / 2^SUB_BUCKET_BITS (about 3%).
+ *
+ * Record() is lock-free and wait-free apart from the max update, so it can be
+ * called concurrently from any number of threads. Readers see a consistent enough
+ * picture for reporting but not an atomic snapshot.
+ */
+class LatencyHistogram {
+public:
+    using Duration = std::chrono::nanoseconds;
+
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr std::uint64_t SUB_BUCKET_COUNT = std::uint64_t{1} << SUB_BUCKET_BITS;
+    // Up to 2^42 ns, more than an hour; longer values fall into the last bucket
+    static constexpr int MAX_VALUE_BITS = 42;
+    static constexpr std::size_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    void Record(Duration latency) noexcept;
+
+    std::uint64_t GetCount() const noexcept;
+    Duration GetSum() const noexcept;
+    Duration GetMax() const noexcept;
+    // percentile is in [0, 100]. Returns the highest value equivalent to the one
+    // at the percentile within the histogram precision
+    Duration GetPercentile(double percentile) const noexcept;
+    // Number of recorded values not greater than the bound, within the histogram precision
+    std::uint64_t GetCountAtOrBelow(Duration bound) const noexcept;
+
+    void Reset() noexcept;
+
+private:
+    static std::size_t GetBucketIndex(std::uint64_t value) noexcept;
+    static std::uint64_t GetBucketUpperBound(std::size_t index) noexcept;
+
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::uint64_t> max_{0};
+};
+
+}  // namespace util
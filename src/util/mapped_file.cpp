@@ -0,0 +1,16 @@
+#include "mapped_file.h"
+
+#include <filesystem>
+
+namespace util {
+
+MappedFile::MappedFile(const std::string& path, Access access)
+    : mapping_{path.c_str(), boost::interprocess::read_only} {
+    if (std::filesystem::file_size(path) != 0) {
+        region_ = boost::interprocess::mapped_region{mapping_, boost::interprocess::read_only};
+        region_.advise(access == Access::Sequential ? boost::interprocess::mapped_region::advice_sequential
+                                                   : boost::interprocess::mapped_region::advice_random);
+    }
+}
+
+}  // namespace util
@@ -0,0 +1,30 @@
+#pragma once
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// Read-only view of a whole file mapped into memory.
+// An empty file is represented by an empty view, since it cannot be mapped.
+class MappedFile {
+public:
+    // Hint for the kernel read-ahead
+    enum class Access { Sequential, Random };
+
+    explicit MappedFile(const std::string& path, Access access = Access::Sequential);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view GetData() const noexcept {
+        return {static_cast<const char*>(region_.get_address()), region_.get_size()};
+    }
+
+private:
+    boost::interprocess::file_mapping mapping_;
+    boost::interprocess::mapped_region region_;
+};
+
+}  // namespace util
@@ -15,6 +15,19 @@ std::string UUIDToString(const UUIDType& uuid) {
     return to_string(uuid);
 }
 
+void UUIDToChars(const UUIDType& uuid, char* out) {
+    // The layout of to_string: lowercase hex, with dashes after the 4th, 6th, 8th and 10th bytes
+    constexpr char digits[] = "0123456789abcdef";
+    std::size_t i = 0;
+    for (const auto byte : uuid) {
+        *out++ = digits[(byte >> 4) & 0x0F];
+        *out++ = digits[byte & 0x0F];
+        if (++i == 4 || i == 6 || i == 8 || i == 10) {
+            *out++ = '-';
+        }
+    }
+}
+
 UUIDType UUIDFromString(std::string_view str) {
     boost::uuids::string_generator gen;
     return gen(str.begin(), str.end());
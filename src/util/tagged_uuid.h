@@ -14,7 +14,12 @@ using UUIDType = boost::uuids::uuid;
 UUIDType NewUUID();
 constexpr UUIDType ZeroUUID{{0}};
 
+// Length of the textual form of a UUID
+constexpr std::size_t UUID_TEXT_SIZE = 36;
+
 std::string UUIDToString(const UUIDType& uuid);
+// Writes the UUID_TEXT_SIZE characters of the textual form, without allocating
+void UUIDToChars(const UUIDType& uuid, char* out);
 UUIDType UUIDFromString(std::string_view str);
 
 }  // namespace detail
@@ -41,6 +46,11 @@ public:
     std::string ToString() const {
         return detail::UUIDToString(**this);
     }
+
+    // Writes the detail::UUID_TEXT_SIZE characters of ToString to out
+    void ToChars(char* out) const {
+        detail::UUIDToChars(**this, out);
+    }
 };
 
 }  // namespace util
\ No newline at end of file
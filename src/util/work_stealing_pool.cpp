@@ -0,0 +1,109 @@
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+
+namespace util {
+
+namespace {
+
+struct WorkerInfo {
+    const WorkStealingPool* pool = nullptr;
+    std::size_t index = 0;
+};
+
+thread_local WorkerInfo current_worker;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(std::size_t threads, std::function<void(std::size_t)> on_start) {
+    threads = std::max<std::size_t>(threads, 1);
+    queues_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this, i, on_start] {
+            Work(i, on_start);
+        });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard lock{sleep_mutex_};
+        stopping_ = true;
+    }
+    task_available_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::Submit(Task task) {
+    const auto index = GetWorkerIndex().value_or(next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size());
+    // Counted before it is queued: a thief could otherwise take the task and decrement pending_ first
+    pending_.fetch_add(1);
+    {
+        auto& queue = *queues_[index];
+        std::lock_guard lock{queue.mutex};
+        queue.tasks.push_back(std::move(task));
+    }
+    // Taking the mutex orders the notification after a worker has checked pending_ and gone to sleep
+    { std::lock_guard lock{sleep_mutex_}; }
+    task_available_.notify_one();
+}
+
+std::optional<std::size_t> WorkStealingPool::GetWorkerIndex() const noexcept {
+    if (current_worker.pool == this) {
+        return current_worker.index;
+    }
+    return std::nullopt;
+}
+
+void WorkStealingPool::Work(std::size_t index, const std::function<void(std::size_t)>& on_start) {
+    current_worker = {this, index};
+    if (on_start) {
+        on_start(index);
+    }
+
+    while (true) {
+        if (auto task = TakeTask(index)) {
+            (*task)();
+            continue;
+        }
+        std::unique_lock lock{sleep_mutex_};
+        task_available_.wait(lock, [this] {
+            return stopping_ || pending_.load() > 0;
+        });
+        if (stopping_ && pending_.load() == 0) {
+            return;
+        }
+    }
+}
+
+std::optional<WorkStealingPool::Task> WorkStealingPool::TakeTask(std::size_t index) {
+    {
+        auto& own = *queues_[index];
+        std::lock_guard lock{own.mutex};
+        if (!own.tasks.empty()) {
+            auto task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            pending_.fetch_sub(1);
+            return task;
+        }
+    }
+    for (std::size_t i = 1; i < queues_.size(); ++i) {
+        auto& victim = *queues_[(index + i) % queues_.size()];
+        std::lock_guard lock{victim.mutex};
+        if (!victim.tasks.empty()) {
+            auto task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending_.fetch_sub(1);
+            return task;
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace util
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+// Fixed set of worker threads, each with its own task queue.
+// A worker takes the newest task of its own queue and, when that is empty,
+// steals the oldest task of another worker, so a burst submitted to one queue
+// spreads over all threads. Tasks submitted from outside the pool are
+// distributed round-robin.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // on_start runs on every worker thread, with its index, before it takes any task
+    explicit WorkStealingPool(std::size_t threads, std::function<void(std::size_t)> on_start = {});
+    // Runs the tasks submitted so far and joins the workers
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void Submit(Task task);
+
+    std::size_t GetSize() const noexcept {
+        return workers_.size();
+    }
+
+    // Index of the calling thread if it is a worker of this pool
+    std::optional<std::size_t> GetWorkerIndex() const noexcept;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Work(std::size_t index, const std::function<void(std::size_t)>& on_start);
+    std::optional<Task> TakeTask(std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::atomic<std::size_t> next_queue_{0};
+    std::atomic<std::size_t> pending_{0};
+
+    std::mutex sleep_mutex_;
+    std::condition_variable task_available_;
+    bool stopping_ = false;
+
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace util
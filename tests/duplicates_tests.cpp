@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+#include "../src/search/duplicates.h"
+#include "../src/storage/storage.h"
+#include "temporary_file.h"
+
+using namespace std::literals;
+using search::DuplicateFinder;
+using search::DuplicateGroup;
+
+namespace {
+
+std::vector<std::string> GetTitles(const DuplicateGroup& group) {
+    std::vector<std::string> titles;
+    for (const auto& book : group.books) {
+        titles.push_back(book.title);
+    }
+    return titles;
+}
+
+}  // namespace
+
+TEST_CASE("Titles with the same words have the same signature") {
+    const auto hobbit = DuplicateFinder::ComputeSignature("The Hobbit"sv);
+    CHECK(DuplicateFinder::ComputeSignature("Hobbit, The"sv) == hobbit);
+    CHECK(DuplicateFinder::ComputeSignature("THE HOBBIT!"sv) == hobbit);
+    CHECK(DuplicateFinder::ComputeSignature("The Silmarillion"sv) != hobbit);
+}
+
+TEST_CASE("Books of an author with near-identical titles are grouped") {
+    std::vector<DuplicateGroup> groups;
+    DuplicateFinder finder{[&groups](DuplicateGroup group) {
+        groups.push_back(std::move(group));
+    }, {0.5, 2}};
+    finder.Add("1"sv, "Tolkien"sv, {"The Hobbit"s, 1937, "a"s});
+    finder.Add("1"sv, "Tolkien"sv, {"The Silmarillion"s, 1977, "b"s});
+    finder.Add("1"sv, "Tolkien"sv, {"Hobbit, The"s, 1951, "c"s});
+    finder.Add("1"sv, "Tolkien"sv, {"The Lord of the Rings"s, 1954, "d"s});
+    finder.Add("1"sv, "Tolkien"sv, {"The Lord of the Rings, Part One"s, 1954, "e"s});
+    // The same title by another author is another work
+    finder.Add("2"sv, "Imitator"sv, {"The Hobbit"s, 2001, "f"s});
+    finder.Finish();
+
+    REQUIRE(groups.size() == 2);
+    CHECK(groups[0].author_id == "1"s);
+    CHECK(GetTitles(groups[0]) == std::vector{"Hobbit, The"s, "The Hobbit"s});
+    CHECK(groups[1].author_id == "1"s);
+    CHECK(GetTitles(groups[1]) == std::vector{"The Lord of the Rings"s, "The Lord of the Rings, Part One"s});
+}
+
+TEST_CASE("Duplicates of the catalog are found through the repositories") {
+    const tests::TemporaryFile log{"duplicates.log"};
+    storage::Database db{{log.GetPath(), false}};
+    const auto tolkien = domain::AuthorId::New();
+    const auto austen = domain::AuthorId::New();
+    db.GetAuthors().Save({tolkien, "Tolkien"s});
+    db.GetAuthors().Save({austen, "Austen"s});
+    const auto save = [&db](const domain::AuthorId& author, std::string title, int year) {
+        db.GetBooks().Save({domain::BookId::New(), author, std::move(title), year, std::nullopt});
+    };
+    save(tolkien, "The Hobbit"s, 1937);
+    save(tolkien, "Hobbit, The"s, 1951);
+    save(austen, "Emma"s, 1815);
+    save(austen, "Pride and Prejudice"s, 1813);
+    save(austen, "Pride & Prejudice"s, 1900);
+
+    const auto groups = search::FindDuplicates(db.GetAuthors(), db.GetBooks(), {0.5, 1});
+    REQUIRE(groups.size() == 2);
+    CHECK(groups[0].author == "Austen"s);
+    CHECK(groups[0].author_id == austen.ToString());
+    CHECK(GetTitles(groups[0]) == std::vector{"Pride & Prejudice"s, "Pride and Prejudice"s});
+    CHECK(groups[1].author == "Tolkien"s);
+    CHECK(GetTitles(groups[1]) == std::vector{"Hobbit, The"s, "The Hobbit"s});
+}
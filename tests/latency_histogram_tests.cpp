@@ -0,0 +1,80 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../src/util/latency_histogram.h"
+
+using namespace std::literals;
+using util::LatencyHistogram;
+
+TEST_CASE("Values below the first power of two split are kept exactly") {
+    LatencyHistogram histogram;
+    for (int i = 0; i < 32; ++i) {
+        histogram.Record(std::chrono::nanoseconds{i});
+    }
+    CHECK(histogram.GetCount() == 32);
+    CHECK(histogram.GetSum() == 496ns);
+    CHECK(histogram.GetMax() == 31ns);
+    CHECK(histogram.GetPercentile(0) == 0ns);
+    CHECK(histogram.GetPercentile(50) == 15ns);
+    CHECK(histogram.GetPercentile(100) == 31ns);
+    CHECK(histogram.GetCountAtOrBelow(9ns) == 10);
+}
+
+TEST_CASE("Larger values are reported within the histogram precision") {
+    constexpr auto precision = 1.0 / LatencyHistogram::SUB_BUCKET_COUNT;
+    for (const auto value : {33ns, 1000ns, 12345ns, 1'000'000ns, 987'654'321ns, std::chrono::nanoseconds{1ll << 41}}) {
+        LatencyHistogram histogram;
+        histogram.Record(value);
+        // Another value above it, so the first one is not capped at the maximum
+        histogram.Record(value * 4);
+        const auto reported = histogram.GetPercentile(50);
+        CHECK(reported >= value);
+        CHECK(static_cast<double>(reported.count()) <= static_cast<double>(value.count()) * (1 + precision));
+        CHECK(histogram.GetCountAtOrBelow(value) == 1);
+        CHECK(histogram.GetCountAtOrBelow(value / 2) == 0);
+    }
+}
+
+TEST_CASE("Percentiles never exceed the maximum") {
+    LatencyHistogram histogram;
+    histogram.Record(1001ns);
+    CHECK(histogram.GetPercentile(100) == 1001ns);
+    // Values beyond the range share the last bucket, which ends past an hour
+    histogram.Record(std::chrono::hours{3});
+    CHECK(histogram.GetMax() == std::chrono::hours{3});
+    CHECK(histogram.GetPercentile(100) > std::chrono::hours{1});
+    CHECK(histogram.GetPercentile(100) <= histogram.GetMax());
+    // Negative latencies count as zero
+    histogram.Record(-5ns);
+    CHECK(histogram.GetPercentile(0) == 0ns);
+    CHECK(histogram.GetCountAtOrBelow(-1ns) == 0);
+}
+
+TEST_CASE("Records of concurrent threads are all counted") {
+    LatencyHistogram histogram;
+    constexpr int threads = 4;
+    constexpr int records = 10000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&histogram, t] {
+            for (int i = 0; i < records; ++i) {
+                histogram.Record(std::chrono::nanoseconds{t * records + i});
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    constexpr std::int64_t total = threads * records;
+    CHECK(histogram.GetCount() == total);
+    CHECK(histogram.GetSum() == std::chrono::nanoseconds{total * (total - 1) / 2});
+    CHECK(histogram.GetMax() == std::chrono::nanoseconds{total - 1});
+    CHECK(histogram.GetCountAtOrBelow(std::chrono::hours{1}) == total);
+
+    histogram.Reset();
+    CHECK(histogram.GetCount() == 0);
+    CHECK(histogram.GetMax() == 0ns);
+    CHECK(histogram.GetPercentile(99) == 0ns);
+}
@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/search/similar_books.h"
+
+using namespace std::literals;
+using search::ScanLevel;
+using search::SimilarityIndex;
+
+namespace {
+
+// More tags than one 256-bit block holds, so the kernels run over several blocks
+constexpr int TAG_COUNT = 300;
+
+std::vector<SimilarityIndex::Book> MakeBooks(std::size_t count, unsigned seed) {
+    std::mt19937 random{seed};
+    // Few tags per book from a small pool of common ones and a large one of rare ones, so that
+    // similarities repeat and the ties are ordered by the catalog
+    std::uniform_int_distribution<int> tags_per_book{0, 6};
+    std::uniform_int_distribution<int> common_tag{0, 7};
+    std::uniform_int_distribution<int> rare_tag{8, TAG_COUNT - 1};
+    std::vector<SimilarityIndex::Book> books;
+    books.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        SimilarityIndex::Book book{"Book "s + std::to_string(i), "Author"s, 2000, std::to_string(i), {}};
+        for (int tag = tags_per_book(random); tag > 0; --tag) {
+            book.tags.insert("tag "s + std::to_string(tag % 2 ? common_tag(random) : rare_tag(random)));
+        }
+        books.push_back(std::move(book));
+    }
+    return books;
+}
+
+// Ids of the k most similar books, scoring every book of the catalog
+std::vector<std::pair<std::string, double>> FindBruteForce(const std::vector<SimilarityIndex::Book>& books,
+                                                           std::size_t query, std::size_t k) {
+    std::vector<std::pair<std::string, double>> matches;
+    for (std::size_t i = 0; i < books.size(); ++i) {
+        if (i == query) {
+            continue;
+        }
+        std::vector<std::string> common;
+        std::set_intersection(books[i].tags.begin(), books[i].tags.end(), books[query].tags.begin(),
+                              books[query].tags.end(), std::back_inserter(common));
+        if (common.empty()) {
+            continue;
+        }
+        const auto all = books[i].tags.size() + books[query].tags.size() - common.size();
+        matches.emplace_back(books[i].id, static_cast<double>(common.size()) / static_cast<double>(all));
+    }
+    // Ties keep the catalog order, which the stable sort preserves
+    std::stable_sort(matches.begin(), matches.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second > rhs.second;
+    });
+    matches.resize(std::min(matches.size(), k));
+    return matches;
+}
+
+void CheckAgainstBruteForce(const std::vector<SimilarityIndex::Book>& books, const SimilarityIndex& index,
+                            std::size_t query, std::size_t k) {
+    const auto expected = FindBruteForce(books, query, k);
+    for (const auto level : {ScanLevel::Scalar, ScanLevel::Sse2, ScanLevel::Avx2}) {
+        std::vector<std::pair<std::string, double>> found;
+        for (const auto& book : index.FindSimilar(books[query].id, k, level)) {
+            found.emplace_back(book.id, book.similarity);
+        }
+        INFO("query " << query << ", k " << k << ", level " << search::GetScanLevelName(level));
+        CHECK(found == expected);
+    }
+}
+
+}  // namespace
+
+TEST_CASE("The most similar books are those of a brute force scan") {
+    const auto books = MakeBooks(2000, 1);
+    const SimilarityIndex index{books, 1};
+    REQUIRE(index.GetSize() == books.size());
+    for (std::size_t query = 0; query < 100; ++query) {
+        for (const std::size_t k : {1, 5, 50}) {
+            CheckAgainstBruteForce(books, index, query, k);
+        }
+    }
+}
+
+TEST_CASE("A catalog split between threads gives the same books") {
+    // Large enough for every thread to get a range of its own
+    const auto books = MakeBooks(150000, 2);
+    const SimilarityIndex index{books, 4};
+    for (const std::size_t query : {0, 77777, 149999}) {
+        CheckAgainstBruteForce(books, index, query, 20);
+    }
+}
+
+TEST_CASE("Books without tags have no similar books") {
+    auto books = MakeBooks(10, 3);
+    books[0].tags.clear();
+    const SimilarityIndex index{books, 1};
+    CHECK(index.FindSimilar(books[0].id, 5).empty());
+    CHECK(index.FindSimilar(books[1].id, 0).empty());
+    CHECK_THROWS_AS(index.FindSimilar("no such book"s, 5), std::out_of_range);
+}
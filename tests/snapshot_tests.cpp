@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/storage/snapshot.h"
+#include "temporary_file.h"
+
+using namespace std::literals;
+using storage::Snapshot;
+
+namespace {
+
+struct Catalog {
+    domain::AuthorId tolkien = domain::AuthorId::New();
+    domain::AuthorId austen = domain::AuthorId::New();
+    domain::BookId hobbit = domain::BookId::New();
+    domain::BookId emma = domain::BookId::New();
+    domain::BookId persuasion = domain::BookId::New();
+
+    void Write(const std::string& path) const {
+        storage::WriteSnapshot(path, {{tolkien, "Tolkien"s}, {austen, "Austen"s}},
+                               {{hobbit, tolkien, "The Hobbit"s, 1937, std::set{"fantasy"s, "adventure"s}},
+                                {persuasion, austen, "Persuasion"s, 1817, std::nullopt},
+                                {emma, austen, "Emma"s, 1815, std::set{"novel"s}},
+                                // Its author is not in the catalog, so the snapshot leaves it out
+                                {domain::BookId::New(), domain::AuthorId::New(), "Orphan"s, 2000, std::nullopt}});
+    }
+};
+
+storage::snapshot_format::Header ReadHeader(const std::string& path) {
+    storage::snapshot_format::Header header;
+    std::ifstream in{path, std::ios::binary};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    return header;
+}
+
+void WriteHeader(const std::string& path, const storage::snapshot_format::Header& header) {
+    std::fstream out{path, std::ios::binary | std::ios::in | std::ios::out};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+}  // namespace
+
+TEST_CASE("A snapshot reads back the catalog it was written from") {
+    const tests::TemporaryFile file{"catalog.snapshot"};
+    const Catalog catalog;
+    catalog.Write(file.GetPath());
+    // The temporary file is renamed over the snapshot
+    CHECK_FALSE(std::filesystem::exists(file.GetPath() + ".tmp"));
+
+    const Snapshot snapshot{file.GetPath()};
+    REQUIRE(snapshot.GetAuthorCount() == 2);
+    REQUIRE(snapshot.GetBookCount() == 3);
+
+    const auto authors = snapshot.GetAuthors();
+    CHECK(authors[0].GetName() == "Austen"s);
+    CHECK(authors[0].GetId() == catalog.austen);
+    CHECK(authors[1].GetName() == "Tolkien"s);
+
+    CHECK(snapshot.ShowBooks()
+          == std::vector<Snapshot::BookRow>{{"Emma"s, "Austen"s, 1815, catalog.emma.ToString()},
+                                            {"Persuasion"s, "Austen"s, 1817, catalog.persuasion.ToString()},
+                                            {"The Hobbit"s, "Tolkien"s, 1937, catalog.hobbit.ToString()}});
+    CHECK(snapshot.ShowBooks(1, 1) == std::vector{snapshot.ShowBooks()[1]});
+
+    CHECK(snapshot.ShowBook("The Hobbit"s)
+          == std::vector<Snapshot::BookDetails>{
+              {"The Hobbit"s, "Tolkien"s, 1937, catalog.hobbit.ToString(), {"adventure"s, "fantasy"s}}});
+    CHECK(snapshot.ShowBook("Orphan"s).empty());
+    CHECK(snapshot.ShowBooksDetails({catalog.persuasion.ToString()})
+          == std::vector<Snapshot::BookDetails>{{"Persuasion"s, "Austen"s, 1817, catalog.persuasion.ToString(), {}}});
+
+    const auto austen_books = snapshot.GetAuthorBooks(catalog.austen.ToString());
+    REQUIRE(austen_books.size() == 2);
+    CHECK(austen_books[0].GetBookId() == catalog.emma);
+    CHECK(austen_books[1].GetBookId() == catalog.persuasion);
+}
+
+TEST_CASE("A snapshot that was not written whole is rejected") {
+    const tests::TemporaryFile file{"corrupt.snapshot"};
+    Catalog{}.Write(file.GetPath());
+    auto header = ReadHeader(file.GetPath());
+
+    SECTION("a file of another kind") {
+        std::memcpy(header.magic, "NOTSNAP", 8);
+        WriteHeader(file.GetPath(), header);
+        CHECK_THROWS_AS(Snapshot{file.GetPath()}, std::runtime_error);
+    }
+
+    SECTION("another version") {
+        ++header.version;
+        WriteHeader(file.GetPath(), header);
+        CHECK_THROWS_AS(Snapshot{file.GetPath()}, std::runtime_error);
+    }
+
+    SECTION("a section past the end of the file") {
+        header.books.count += 1000;
+        WriteHeader(file.GetPath(), header);
+        CHECK_THROWS_WITH(Snapshot{file.GetPath()}, "Corrupt snapshot");
+    }
+
+    SECTION("a truncated file") {
+        std::filesystem::resize_file(file.GetPath(), header.heap.offset);
+        CHECK_THROWS_WITH(Snapshot{file.GetPath()}, "Corrupt snapshot");
+    }
+
+    SECTION("a file shorter than the header") {
+        std::filesystem::resize_file(file.GetPath(), sizeof(header) / 2);
+        CHECK_THROWS_AS(Snapshot{file.GetPath()}, std::runtime_error);
+    }
+}
@@ -0,0 +1,118 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include "../src/domain/stream.h"
+
+using namespace std::literals;
+using domain::Stream;
+
+namespace {
+
+// What the stub source has done, inspected after the stream is gone
+struct SourceLog {
+    int fetches = 0;
+    bool destroyed = false;
+    // Sizes of the batches the stream passed in, before they were replaced
+    std::vector<std::size_t> passed_sizes;
+};
+
+// Hands out the rows in batches of the given sizes
+class StubSource : public Stream<std::string>::Source {
+public:
+    StubSource(std::vector<std::vector<std::string>> batches, SourceLog& log)
+        : batches_{std::move(batches)}
+        , log_{log} {
+    }
+
+    ~StubSource() override {
+        log_.destroyed = true;
+    }
+
+    void FetchBatch(std::vector<std::string>& batch) override {
+        ++log_.fetches;
+        log_.passed_sizes.push_back(batch.size());
+        if (next_ == batches_.size()) {
+            batch.clear();
+            return;
+        }
+        batch = batches_[next_++];
+    }
+
+private:
+    std::vector<std::vector<std::string>> batches_;
+    std::size_t next_ = 0;
+    SourceLog& log_;
+};
+
+Stream<std::string> MakeStream(std::vector<std::vector<std::string>> batches, SourceLog& log) {
+    return Stream<std::string>{std::make_unique<StubSource>(std::move(batches), log)};
+}
+
+}  // namespace
+
+static_assert(std::ranges::input_range<Stream<std::string>>);
+
+TEST_CASE("A stream hands out the rows of all batches in order") {
+    SourceLog log;
+    std::vector<std::string> rows;
+    {
+        auto stream = MakeStream({{"a"s, "b"s}, {"c"s}, {"d"s, "e"s, "f"s}}, log);
+        // Nothing is fetched before the stream is started
+        CHECK(log.fetches == 0);
+        for (const auto& row : stream) {
+            rows.push_back(row);
+        }
+        // The source is released once it runs out of rows, not with the stream
+        CHECK(log.destroyed);
+    }
+    CHECK(rows == std::vector{"a"s, "b"s, "c"s, "d"s, "e"s, "f"s});
+    CHECK(log.fetches == 4);
+    // Every batch but the first is passed the previous one to reuse
+    CHECK(log.passed_sizes == std::vector<std::size_t>{0, 2, 1, 3});
+}
+
+TEST_CASE("A stream works with range algorithms") {
+    SourceLog log;
+    auto stream = MakeStream({{"apple"s, "banana"s}, {"cherry"s}}, log);
+    const auto lengths = stream | std::views::transform([](const std::string& row) {
+        return row.size();
+    });
+    std::vector<std::size_t> sizes;
+    std::ranges::copy(lengths, std::back_inserter(sizes));
+    CHECK(sizes == std::vector<std::size_t>{5, 6, 6});
+}
+
+TEST_CASE("A stream stopped early keeps its source until it is dropped") {
+    SourceLog log;
+    {
+        auto stream = MakeStream({{"a"s, "b"s}, {"c"s}}, log);
+        const auto it = std::ranges::find(stream, "b"s);
+        REQUIRE(it != stream.end());
+        CHECK(*it == "b"s);
+        CHECK(log.fetches == 1);
+        CHECK_FALSE(log.destroyed);
+    }
+    CHECK(log.destroyed);
+}
+
+TEST_CASE("Empty streams end at once") {
+    SourceLog log;
+    auto stream = MakeStream({}, log);
+    CHECK(stream.begin() == stream.end());
+    CHECK(log.destroyed);
+
+    auto rows = Stream<std::string>::FromVector({});
+    CHECK(rows.begin() == rows.end());
+}
+
+TEST_CASE("A stream of a vector hands out its rows") {
+    auto stream = Stream<std::string>::FromVector({"x"s, "y"s});
+    std::vector<std::string> rows;
+    std::ranges::copy(stream, std::back_inserter(rows));
+    CHECK(rows == std::vector{"x"s, "y"s});
+}
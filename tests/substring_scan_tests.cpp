@@ -0,0 +1,83 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "../src/search/substring_scan.h"
+
+using namespace std::literals;
+using search::FindIgnoreCase;
+using search::ScanLevel;
+
+namespace {
+
+// Letters of both cases, the bytes around them and a UTF-8 sequence, so the case folding is tested at its edges
+constexpr std::string_view ALPHABET = "aAbBzZ@[`{ \xC3\xA9"sv;
+
+std::string MakeText(std::mt19937& random, std::size_t size) {
+    std::uniform_int_distribution<std::size_t> byte{0, ALPHABET.size() - 1};
+    std::string text(size, ' ');
+    for (auto& c : text) {
+        c = ALPHABET[byte(random)];
+    }
+    return text;
+}
+
+std::size_t FindReference(std::string_view haystack, std::string_view lower_needle) {
+    const auto it = std::search(haystack.begin(), haystack.end(), lower_needle.begin(), lower_needle.end(),
+                                [](char lhs, char rhs) {
+        return search::ToLowerAscii(std::string_view{&lhs, 1}) == std::string_view{&rhs, 1};
+    });
+    return it == haystack.end() && !lower_needle.empty() ? std::string_view::npos : static_cast<std::size_t>(it - haystack.begin());
+}
+
+}  // namespace
+
+TEST_CASE("ToLowerAscii folds ASCII letters only") {
+    CHECK(search::ToLowerAscii("Hello, WORLD @[`{ \xC3\x89"sv) == "hello, world @[`{ \xC3\x89"s);
+}
+
+TEST_CASE("Every scan level finds what the scalar scan finds") {
+    std::mt19937 random{42};
+    for (std::size_t size = 0; size <= 100; ++size) {
+        for (int attempt = 0; attempt < 20; ++attempt) {
+            const auto haystack = MakeText(random, size);
+            std::uniform_int_distribution<std::size_t> needle_size{1, 4};
+            std::string needle;
+            if (size > 0 && attempt % 2 == 0) {
+                // A piece of the haystack, found at or before where it was taken from
+                std::uniform_int_distribution<std::size_t> start{0, size - 1};
+                const auto from = start(random);
+                needle = search::ToLowerAscii(std::string_view{haystack}.substr(from, needle_size(random)));
+            } else {
+                needle = search::ToLowerAscii(MakeText(random, needle_size(random)));
+            }
+
+            const auto expected = FindReference(haystack, needle);
+            INFO("haystack \"" << haystack << "\", needle \"" << needle << '"');
+            CHECK(FindIgnoreCase(haystack, needle, ScanLevel::Scalar) == expected);
+            CHECK(FindIgnoreCase(haystack, needle, ScanLevel::Sse2) == expected);
+            CHECK(FindIgnoreCase(haystack, needle, ScanLevel::Avx2) == expected);
+        }
+    }
+}
+
+TEST_CASE("Matches across the block boundaries of the vector scans are found") {
+    for (std::size_t position = 0; position < 70; ++position) {
+        auto haystack = std::string(80, 'x');
+        haystack.replace(position, 5, "HoBBi");
+        for (const auto level : {ScanLevel::Scalar, ScanLevel::Sse2, ScanLevel::Avx2}) {
+            CHECK(FindIgnoreCase(haystack, "hobbi"sv, level) == position);
+            CHECK(FindIgnoreCase(haystack, "hobbit"sv, level) == std::string_view::npos);
+        }
+    }
+}
+
+TEST_CASE("An empty needle is found at the start") {
+    for (const auto level : {ScanLevel::Scalar, ScanLevel::Sse2, ScanLevel::Avx2}) {
+        CHECK(FindIgnoreCase(""sv, ""sv, level) == 0);
+        CHECK(FindIgnoreCase("abc"sv, ""sv, level) == 0);
+        CHECK(FindIgnoreCase(""sv, "a"sv, level) == std::string_view::npos);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+namespace tests {
+
+// A path in the temporary directory, unique within the test run; the file is removed with it
+class TemporaryFile {
+public:
+    explicit TemporaryFile(const std::string& name) {
+        static std::atomic<int> counter{0};
+        path_ = (std::filesystem::temp_directory_path()
+                 / ("bookypedia_test_" + std::to_string(::getpid()) + "_" + std::to_string(++counter) + "_" + name))
+                    .string();
+    }
+
+    ~TemporaryFile() {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+    const std::string& GetPath() const noexcept {
+        return path_;
+    }
+
+private:
+    std::string path_;
+};
+
+}  // namespace tests
@@ -0,0 +1,30 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/postgres/typed_query.h"
+
+using postgres::sql::CountParams;
+using postgres::sql::CountResultColumns;
+
+TEST_CASE("Placeholders are counted by the highest one") {
+    STATIC_REQUIRE(CountParams("SELECT 1;") == 0);
+    STATIC_REQUIRE(CountParams("SELECT * FROM books WHERE id = $1;") == 1);
+    STATIC_REQUIRE(CountParams("SELECT * FROM books WHERE year > $2 AND id = $1 OR year < $2;") == 2);
+    STATIC_REQUIRE(CountParams("SELECT $12;") == 12);
+    // Dollars inside literals and quoted identifiers are not placeholders
+    STATIC_REQUIRE(CountParams("SELECT '$3', \"$4\" FROM books WHERE id = $1;") == 1);
+    STATIC_REQUIRE(CountParams("SELECT 'it''s $2' WHERE id = $1;") == 1);
+}
+
+TEST_CASE("Result columns are the items of the outer select list") {
+    STATIC_REQUIRE(CountResultColumns("SELECT id, name FROM authors;") == 2);
+    STATIC_REQUIRE(CountResultColumns("select id from authors") == 1);
+    STATIC_REQUIRE(CountResultColumns("UPDATE books SET title = $1;") == 0);
+    STATIC_REQUIRE(CountResultColumns("INSERT INTO authors (id, name) VALUES ($1, $2) RETURNING id, name;") == 2);
+    // Commas inside calls, subqueries and literals separate nothing
+    STATIC_REQUIRE(CountResultColumns("SELECT coalesce(a, b), (SELECT x, y FROM t), 'a, b' FROM c;") == 3);
+    STATIC_REQUIRE(CountResultColumns("SELECT \"from\", selected FROM t;") == 2);
+    // The outer query of a WITH statement
+    STATIC_REQUIRE(CountResultColumns("WITH n AS (SELECT id, name FROM authors) SELECT id FROM n;") == 1);
+    // Only the first statement
+    STATIC_REQUIRE(CountResultColumns("SELECT id; SELECT id, name FROM authors;") == 1);
+}
@@ -0,0 +1,122 @@
+#include <catch2/catch_test_macros.hpp>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+#include "../src/storage/wal.h"
+#include "temporary_file.h"
+
+using namespace std::literals;
+using storage::WriteAheadLog;
+
+namespace {
+
+std::vector<std::string> Replay(const std::string& path) {
+    std::vector<std::string> records;
+    WriteAheadLog log{{path, false}, [&records](std::string_view record) {
+        records.emplace_back(record);
+    }};
+    return records;
+}
+
+void Write(const std::string& path, const std::vector<std::string>& records) {
+    WriteAheadLog log{{path, false}, [](std::string_view) {}};
+    for (const auto& record : records) {
+        log.WaitDurable(log.Append(record));
+    }
+}
+
+// Lowers the file size limit of the process, so that writes past it fail with EFBIG
+class FileSizeLimit {
+public:
+    explicit FileSizeLimit(rlim_t limit) {
+        ::getrlimit(RLIMIT_FSIZE, &saved_);
+        previous_handler_ = std::signal(SIGXFSZ, SIG_IGN);
+        rlimit lowered = saved_;
+        lowered.rlim_cur = limit;
+        ::setrlimit(RLIMIT_FSIZE, &lowered);
+    }
+
+    ~FileSizeLimit() {
+        ::setrlimit(RLIMIT_FSIZE, &saved_);
+        std::signal(SIGXFSZ, previous_handler_);
+    }
+
+    FileSizeLimit(const FileSizeLimit&) = delete;
+    FileSizeLimit& operator=(const FileSizeLimit&) = delete;
+
+private:
+    rlimit saved_{};
+    void (*previous_handler_)(int) = nullptr;
+};
+
+}  // namespace
+
+TEST_CASE("WAL replays the records in the order they were appended") {
+    const tests::TemporaryFile file{"wal.log"};
+    Write(file.GetPath(), {"first"s, ""s, "third"s});
+    Write(file.GetPath(), {"fourth"s});
+
+    CHECK(Replay(file.GetPath()) == std::vector{"first"s, ""s, "third"s, "fourth"s});
+}
+
+TEST_CASE("WAL replay cuts off a torn or corrupted tail") {
+    const tests::TemporaryFile file{"wal.log"};
+    Write(file.GetPath(), {"first"s, "second"s});
+    const auto intact_size = std::filesystem::file_size(file.GetPath());
+
+    SECTION("torn header") {
+        std::ofstream{file.GetPath(), std::ios::binary | std::ios::app} << "\x05\x00"sv;
+    }
+    SECTION("torn payload") {
+        std::ofstream{file.GetPath(), std::ios::binary | std::ios::app} << "\x05\x00\x00\x00\x00\x00\x00\x00thi"sv;
+    }
+    SECTION("corrupted payload") {
+        Write(file.GetPath(), {"third"s});
+        std::fstream out{file.GetPath(), std::ios::binary | std::ios::in | std::ios::out};
+        out.seekp(static_cast<std::streamoff>(intact_size + 8));
+        out << 'T';
+    }
+
+    CHECK(Replay(file.GetPath()) == std::vector{"first"s, "second"s});
+    CHECK(std::filesystem::file_size(file.GetPath()) == intact_size);
+
+    // Records appended after the cut are replayed, not hidden behind the garbage
+    Write(file.GetPath(), {"after"s});
+    CHECK(Replay(file.GetPath()) == std::vector{"first"s, "second"s, "after"s});
+}
+
+TEST_CASE("WAL stops after a failed write") {
+    const tests::TemporaryFile file{"wal.log"};
+    std::uint64_t durable_size = 0;
+    {
+        WriteAheadLog log{{file.GetPath(), false}, [](std::string_view) {}};
+        const auto durable = log.Append("durable"s);
+        log.WaitDurable(durable);
+        durable_size = log.GetSize();
+
+        std::uint64_t failed = 0;
+        {
+            // Part of the record fits under the limit, so the log is left with a torn tail
+            const FileSizeLimit limit{durable_size + 16};
+            failed = log.Append(std::string(100, 'x'));
+            CHECK_THROWS(log.WaitDurable(failed));
+        }
+
+        // The disk is fine again, but whatever follows the torn record could not be replayed
+        CHECK_THROWS(log.Append("later"s));
+        CHECK_THROWS(log.WaitDurable(failed));
+        CHECK_THROWS(log.Rewrite([](const WriteAheadLog::RecordSink& sink) {
+            sink("rewritten"sv);
+        }));
+        CHECK(log.GetSize() == durable_size);
+        // What was durable before the failure still is
+        log.WaitDurable(durable);
+    }
+
+    CHECK(Replay(file.GetPath()) == std::vector{"durable"s});
+    CHECK(std::filesystem::file_size(file.GetPath()) == durable_size);
+}
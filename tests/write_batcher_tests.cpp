@@ -0,0 +1,196 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/postgres/write_batcher.h"
+
+using namespace std::literals;
+
+namespace {
+
+// What the stub database has seen, inspected once the batcher is gone
+struct StubDatabase {
+    std::vector<std::string> committed;
+    std::vector<std::string> statements;
+    int batches = 0;
+    int connections = 0;
+    bool fail_commit = false;
+    // The connection breaks at the next commit
+    bool break_connection = false;
+};
+
+struct StubConnection {
+    std::shared_ptr<StubDatabase> database;
+};
+
+struct StubBrokenConnection : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+class StubTransaction {
+public:
+    virtual ~StubTransaction() = default;
+
+    void Insert(std::string row) {
+        if (row.starts_with("bad"sv)) {
+            throw std::runtime_error("constraint violated by "s + row);
+        }
+        Log(row);
+        rows_.push_back(std::move(row));
+    }
+
+    virtual void Log(const std::string& statement) = 0;
+
+protected:
+    std::vector<std::string> rows_;
+};
+
+class StubWork : public StubTransaction {
+public:
+    explicit StubWork(StubConnection& connection)
+        : database_{*connection.database} {
+        ++database_.batches;
+    }
+
+    void Log(const std::string& statement) override {
+        database_.statements.push_back(statement);
+    }
+
+    void Keep(std::vector<std::string>& rows) {
+        rows_.insert(rows_.end(), rows.begin(), rows.end());
+    }
+
+    void commit() {
+        if (database_.fail_commit) {
+            throw std::runtime_error("commit failed");
+        }
+        if (database_.break_connection) {
+            database_.break_connection = false;
+            throw StubBrokenConnection("connection lost");
+        }
+        database_.committed.insert(database_.committed.end(), rows_.begin(), rows_.end());
+    }
+
+private:
+    StubDatabase& database_;
+};
+
+// Its rows reach the transaction only when it is committed, otherwise they are rolled back
+class StubSavepoint : public StubTransaction {
+public:
+    explicit StubSavepoint(StubWork& work)
+        : work_{work} {
+    }
+
+    void Log(const std::string& statement) override {
+        work_.Log(statement);
+    }
+
+    void commit() {
+        work_.Keep(rows_);
+    }
+
+private:
+    StubWork& work_;
+};
+
+using Batcher = postgres::BasicWriteBatcher<StubConnection, StubWork, StubSavepoint, StubTransaction, StubBrokenConnection>;
+
+Batcher::Connect ConnectTo(const std::shared_ptr<StubDatabase>& database) {
+    return [database] {
+        ++database->connections;
+        return StubConnection{database};
+    };
+}
+
+void Lock(StubTransaction& work) {
+    work.Log("lock"s);
+}
+
+Batcher::Write Insert(std::string row) {
+    return [row = std::move(row)](StubTransaction& tx) {
+        tx.Insert(row);
+    };
+}
+
+}  // namespace
+
+TEST_CASE("A failed write of a batch is rolled back alone") {
+    const auto database = std::make_shared<StubDatabase>();
+    std::vector<std::future<void>> results;
+    {
+        // A window long enough for the whole batch to be queued before it is taken
+        Batcher batcher{ConnectTo(database), {std::chrono::seconds{10}, 4}, Lock};
+        results.push_back(batcher.Submit(Insert("first"s)));
+        results.push_back(batcher.Submit(Insert("bad second"s)));
+        results.push_back(batcher.Submit(Insert("third"s)));
+        results.push_back(batcher.Submit([](StubTransaction& tx) {
+            tx.Insert("fourth"s);
+            tx.Insert("bad fourth"s);
+        }));
+        for (auto& result : results) {
+            result.wait();
+        }
+    }
+
+    CHECK_NOTHROW(results[0].get());
+    CHECK_THROWS_AS(results[1].get(), std::runtime_error);
+    CHECK_NOTHROW(results[2].get());
+    // The part of the write that succeeded is undone with the rest of it
+    CHECK_THROWS_AS(results[3].get(), std::runtime_error);
+    CHECK(database->batches == 1);
+    CHECK(database->committed == std::vector{"first"s, "third"s});
+    // The locks are taken once, before the first write of the batch
+    CHECK(database->statements == std::vector{"lock"s, "first"s, "third"s, "fourth"s});
+}
+
+TEST_CASE("A batch that fails to commit fails every write") {
+    const auto database = std::make_shared<StubDatabase>();
+    database->fail_commit = true;
+    std::vector<std::future<void>> results;
+    {
+        Batcher batcher{ConnectTo(database), {std::chrono::seconds{10}, 2}, Lock};
+        results.push_back(batcher.Submit(Insert("first"s)));
+        results.push_back(batcher.Submit(Insert("second"s)));
+    }
+
+    for (auto& result : results) {
+        CHECK_THROWS_WITH(result.get(), "commit failed");
+    }
+    CHECK(database->committed.empty());
+}
+
+TEST_CASE("Writes are committed in batches of at most max_writes") {
+    const auto database = std::make_shared<StubDatabase>();
+    std::vector<std::future<void>> results;
+    {
+        Batcher batcher{ConnectTo(database), {std::chrono::seconds{10}, 3}, Lock};
+        for (int i = 0; i < 7; ++i) {
+            results.push_back(batcher.Submit(Insert(std::to_string(i))));
+        }
+        // The last batch is not full; the batcher commits it when it stops
+    }
+
+    for (auto& result : results) {
+        CHECK_NOTHROW(result.get());
+    }
+    CHECK(database->batches == 3);
+    CHECK(database->committed == std::vector{"0"s, "1"s, "2"s, "3"s, "4"s, "5"s, "6"s});
+}
+
+TEST_CASE("A batch after the connection broke runs on a new one") {
+    const auto database = std::make_shared<StubDatabase>();
+    Batcher batcher{ConnectTo(database), {std::chrono::seconds{10}, 1}, Lock};
+    CHECK(database->connections == 1);
+
+    database->break_connection = true;
+    auto lost = batcher.Submit(Insert("lost"s));
+    CHECK_THROWS_AS(lost.get(), StubBrokenConnection);
+    auto kept = batcher.Submit(Insert("kept"s));
+    CHECK_NOTHROW(kept.get());
+
+    CHECK(database->connections == 2);
+    CHECK(database->committed == std::vector{"kept"s});
+}
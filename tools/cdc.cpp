@@ -0,0 +1,99 @@
+// Prints the change-data-capture log of the catalog kept in Postgres as JSON lines,
+// one event per line: {"sequence":..,"entity":..,"id":..,"operation":..,"changes":{..}}.
+//
+// Usage: bookypedia_cdc <offset file> [--follow]
+// Events after the sequence number stored in the offset file are printed in batches;
+// the file is rewritten after every batch has been flushed to stdout, so a restarted
+// consumer resumes after the last complete batch, and at worst sees its events again.
+// With --follow, the tool keeps polling for new events instead of stopping at the end.
+// The database is taken from the BOOKYPEDIA_DB_URL environment variable.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "../src/postgres/change_log.h"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr const char DB_URL_ENV_NAME[]{"BOOKYPEDIA_DB_URL"};
+constexpr std::size_t BATCH_SIZE = 1000;
+constexpr auto POLL_INTERVAL = 1s;
+
+std::uint64_t ReadOffset(const std::string& path) {
+    std::ifstream file{path};
+    std::uint64_t offset = 0;
+    if (file && !(file >> offset)) {
+        throw std::runtime_error("Invalid offset in "s + path);
+    }
+    return offset;
+}
+
+// Replaces the file atomically, so a crash leaves either the old or the new offset
+void WriteOffset(const std::string& path, std::uint64_t offset) {
+    const auto temporary_path = path + ".tmp"s;
+    {
+        std::ofstream file{temporary_path, std::ios::trunc};
+        file << offset << '\n';
+        if (!file.flush()) {
+            throw std::runtime_error("Failed to write "s + temporary_path);
+        }
+    }
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Failed to replace "s + path);
+    }
+}
+
+void PrintEvent(std::ostream& out, const postgres::CatalogEvent& event) {
+    // Entities, ids and operations are plain ASCII, changes are JSON already
+    out << R"({"sequence":)" << event.sequence << R"(,"entity":")" << event.entity << R"(","id":")"
+        << event.entity_id << R"(","operation":")" << event.operation << R"(","changes":)"
+        << (event.changes.empty() ? "null"s : event.changes) << "}\n";
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    try {
+        if (argc < 2 || argc > 3 || (argc == 3 && argv[2] != "--follow"sv)) {
+            throw std::invalid_argument("Usage: "s + argv[0] + " <offset file> [--follow]"s);
+        }
+        const std::string offset_path = argv[1];
+        const bool follow = argc == 3;
+        const auto* db_url = std::getenv(DB_URL_ENV_NAME);
+        if (!db_url) {
+            throw std::runtime_error(DB_URL_ENV_NAME + " environment variable not found"s);
+        }
+
+        pqxx::connection connection{db_url};
+        postgres::ChangeLogReader reader{connection, ReadOffset(offset_path)};
+        while (true) {
+            const auto events = reader.ReadBatch(BATCH_SIZE);
+            for (const auto& event : events) {
+                PrintEvent(std::cout, event);
+            }
+            if (!events.empty()) {
+                if (!std::cout.flush()) {
+                    throw std::runtime_error("Failed to write events");
+                }
+                WriteOffset(offset_path, reader.GetOffset());
+            }
+            if (events.size() < BATCH_SIZE) {
+                if (!follow) {
+                    break;
+                }
+                std::this_thread::sleep_for(POLL_INTERVAL);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
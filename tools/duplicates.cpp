@@ -0,0 +1,70 @@
+// Lists candidate duplicate books of every author in the catalog kept in Postgres,
+// one group per paragraph: the author, then a line per book with its id, year and title.
+//
+// Usage: bookypedia_duplicates [threshold]
+// The threshold is the least estimated title similarity of grouped books, 0.5 by default.
+// The database is taken from the BOOKYPEDIA_DB_URL environment variable.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <pqxx/pqxx>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "../src/search/duplicates.h"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr const char DB_URL_ENV_NAME[]{"BOOKYPEDIA_DB_URL"};
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    try {
+        if (argc > 2) {
+            throw std::invalid_argument("Usage: "s + argv[0] + " [threshold]"s);
+        }
+        search::DuplicateOptions options;
+        if (argc == 2) {
+            options.threshold = std::stod(argv[1]);
+        }
+        const auto* db_url = std::getenv(DB_URL_ENV_NAME);
+        if (!db_url) {
+            throw std::runtime_error(DB_URL_ENV_NAME + " environment variable not found"s);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::size_t books = 0;
+        std::size_t groups = 0;
+        search::DuplicateFinder finder{[&groups](search::DuplicateGroup group) {
+            ++groups;
+            std::cout << group.author << " (" << group.author_id << ")\n";
+            for (const auto& book : group.books) {
+                std::cout << "    " << book.id << "  " << book.publication_year << "  " << book.title << '\n';
+            }
+            std::cout << '\n';
+        }, options};
+
+        // Rows are streamed in author order, so only the finder's current batch is in memory
+        pqxx::connection connection{db_url};
+        pqxx::read_transaction read{connection};
+        for (auto [author_id, author, id, title, year] :
+             read.stream<std::string_view, std::string_view, std::string_view, std::string_view, int>(
+                 "SELECT a.id, a.name, b.id, b.title, b.publication_year FROM books b "
+                 "JOIN authors a ON a.id = b.author_id ORDER BY a.id"sv)) {
+            finder.Add(author_id, author, {std::string{title}, year, std::string{id}});
+            ++books;
+        }
+        finder.Finish();
+
+        std::cerr << "Found " << groups << " candidate duplicate groups among " << books << " books in "
+                  << (std::chrono::steady_clock::now() - start) / 1ms << " ms" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
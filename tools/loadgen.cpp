@@ -0,0 +1,568 @@
+// Synthetic workload generator.
+// N client threads call app::UseCases directly, each over its own connection, with
+// a configurable mix of operations. Titles and authors are picked with Zipfian popularity.
+// Throughput and per-operation latency percentiles are reported for every time window
+// and for the whole measured period; operations done during warm-up are not recorded.
+//
+// In closed-loop mode (default) every thread issues the next operation as soon as the
+// previous one finishes. In open-loop mode (--rate) operations are scheduled at a fixed
+// total rate and latency is measured from the scheduled start, so queueing delay
+// caused by a slow server is not hidden.
+//
+// With --group-commit <window, us>, the saves of all threads go through one postgres::WriteBatcher,
+// which commits up to --group-commit-writes of them at once; a concurrent write workload is
+// e.g. --mix AddAuthor=20,AddBook=80 with many threads, run with and without it.
+//
+// Usage: bookypedia_loadgen [--threads 4] [--duration 60] [--warmup 10] [--window 5]
+//                           [--rate <ops/s>] [--zipf 0.99] [--seed-authors 1000] [--seed-books 10000]
+//                           [--mix AddAuthor=2,AddBook=10,ShowBooks=1,ShowBook=60,EditBook=17,DeleteBook=10]
+//                           [--group-commit <us>] [--group-commit-writes 64]
+// The database is taken from the BOOKYPEDIA_DB_URL environment variable.
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <set>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/app/use_cases_impl.h"
+#include "../src/postgres/postgres.h"
+#include "../src/postgres/write_batcher.h"
+#include "../src/util/latency_histogram.h"
+
+using namespace std::literals;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr const char DB_URL_ENV_NAME[]{"BOOKYPEDIA_DB_URL"};
+
+enum class Operation { AddAuthor, AddBook, ShowBooks, ShowBook, EditBook, DeleteBook, Count };
+constexpr std::size_t OPERATION_COUNT = static_cast<std::size_t>(Operation::Count);
+constexpr std::array<std::string_view, OPERATION_COUNT> OPERATION_NAMES{
+    "AddAuthor"sv, "AddBook"sv, "ShowBooks"sv, "ShowBook"sv, "EditBook"sv, "DeleteBook"sv,
+};
+
+struct LoadConfig {
+    std::string db_url;
+    int threads = 4;
+    std::chrono::seconds duration = 60s;
+    std::chrono::seconds warmup = 10s;
+    std::chrono::seconds window = 5s;
+    // Total operations per second for the open loop, closed loop when not set
+    std::optional<double> rate;
+    double zipf_theta = 0.99;
+    std::size_t seed_authors = 1000;
+    std::size_t seed_books = 10000;
+    std::array<double, OPERATION_COUNT> mix{2, 10, 1, 60, 17, 10};
+    // Prefix of generated names, unique for every run
+    std::string run_id;
+    // Saves are committed in batches when set
+    std::optional<postgres::WriteBatcher::Config> group_commit;
+};
+
+/**
+ * Zipfian distribution over [0, n) where 0 is the most popular item,
+ * as in "Quickly Generating Billion-Record Synthetic Databases" (Gray et al.).
+ * n can change between draws: zeta(n) is updated incrementally.
+ */
+class ZipfianGenerator {
+public:
+    explicit ZipfianGenerator(double theta)
+        : theta_{theta}
+        , zeta2_{1.0 + std::pow(0.5, theta)}
+        , alpha_{1.0 / (1.0 - theta)} {
+    }
+
+    template <typename Engine>
+    std::size_t operator()(Engine& engine, std::size_t n) {
+        Resize(n);
+        const double u = std::uniform_real_distribution<double>{0.0, 1.0}(engine);
+        const double uz = u * zetan_;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < zeta2_) {
+            return std::min<std::size_t>(1, n - 1);
+        }
+        const double eta = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta_)) / (1.0 - zeta2_ / zetan_);
+        const auto item = static_cast<std::size_t>(static_cast<double>(n) * std::pow(eta * u - eta + 1.0, alpha_));
+        return std::min(item, n - 1);
+    }
+
+private:
+    void Resize(std::size_t n) {
+        for (; n_ < n; ++n_) {
+            zetan_ += 1.0 / std::pow(static_cast<double>(n_ + 1), theta_);
+        }
+        for (; n_ > n; --n_) {
+            zetan_ -= 1.0 / std::pow(static_cast<double>(n_), theta_);
+        }
+    }
+
+    double theta_;
+    double zeta2_;
+    double alpha_;
+    std::size_t n_ = 0;
+    double zetan_ = 0.0;
+};
+
+// Authors and book titles known to the generator. The position in the vectors is the
+// popularity rank, so the first items are the hottest ones.
+class Catalog {
+public:
+    void AddAuthor(domain::AuthorId id) {
+        std::lock_guard lock{mutex_};
+        authors_.push_back(std::move(id));
+    }
+
+    void AddTitle(std::string title) {
+        std::lock_guard lock{mutex_};
+        titles_.push_back(std::move(title));
+    }
+
+    template <typename Pick>
+    std::optional<domain::AuthorId> PickAuthor(Pick&& pick) const {
+        std::shared_lock lock{mutex_};
+        if (authors_.empty()) {
+            return std::nullopt;
+        }
+        return authors_[pick(authors_.size())];
+    }
+
+    template <typename Pick>
+    std::optional<std::string> PickTitle(Pick&& pick) const {
+        std::shared_lock lock{mutex_};
+        if (titles_.empty()) {
+            return std::nullopt;
+        }
+        return titles_[pick(titles_.size())];
+    }
+
+    // Removes the title picked by the popularity distribution, swapping the last one into its place
+    template <typename Pick>
+    std::optional<std::string> TakeTitle(Pick&& pick) {
+        std::lock_guard lock{mutex_};
+        if (titles_.empty()) {
+            return std::nullopt;
+        }
+        const auto index = pick(titles_.size());
+        auto title = std::move(titles_[index]);
+        titles_[index] = std::move(titles_.back());
+        titles_.pop_back();
+        return title;
+    }
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::vector<domain::AuthorId> authors_;
+    std::vector<std::string> titles_;
+};
+
+struct OperationStats {
+    util::LatencyHistogram latency;
+    std::atomic<std::uint64_t> errors{0};
+
+    void Reset() {
+        latency.Reset();
+        errors.store(0, std::memory_order_relaxed);
+    }
+};
+
+using StatsSet = std::array<OperationStats, OPERATION_COUNT>;
+
+// Statistics of the current time window and of the whole measured period.
+// Windows alternate between two sets, so the reporter can read and reset
+// the finished window while clients record into the next one.
+class Recorder {
+public:
+    void Record(Operation operation, std::chrono::nanoseconds latency, bool failed) {
+        if (!measuring_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        for (auto* set : {&windows_[current_window_.load(std::memory_order_relaxed)], &total_}) {
+            auto& stats = (*set)[static_cast<std::size_t>(operation)];
+            stats.latency.Record(latency);
+            if (failed) {
+                stats.errors.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void StartMeasuring() {
+        measuring_ = true;
+    }
+
+    StatsSet& SwitchWindow() {
+        const auto finished = current_window_.load();
+        for (auto& stats : windows_[1 - finished]) {
+            stats.Reset();
+        }
+        current_window_ = 1 - finished;
+        return windows_[finished];
+    }
+
+    const StatsSet& GetTotal() const {
+        return total_;
+    }
+
+private:
+    std::atomic<bool> measuring_{false};
+    std::atomic<std::size_t> current_window_{0};
+    std::array<StatsSet, 2> windows_;
+    StatsSet total_;
+};
+
+std::array<double, OPERATION_COUNT> ParseMix(const std::string& text) {
+    std::array<double, OPERATION_COUNT> mix{};
+    std::vector<std::string> items;
+    boost::split(items, text, boost::is_any_of(","));
+    for (const auto& item : items) {
+        const auto eq = item.find('=');
+        const auto name = std::string_view{item}.substr(0, eq);
+        const auto it = std::find(OPERATION_NAMES.begin(), OPERATION_NAMES.end(), name);
+        if (eq == std::string::npos || it == OPERATION_NAMES.end()) {
+            throw std::invalid_argument("Invalid mix item: "s + item);
+        }
+        mix[it - OPERATION_NAMES.begin()] = std::stod(item.substr(eq + 1));
+    }
+    return mix;
+}
+
+LoadConfig ParseCommandLine(int argc, const char* argv[]) {
+    LoadConfig config;
+    config.run_id = "Loadgen "s + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + " "s;
+    if (const auto* url = std::getenv(DB_URL_ENV_NAME)) {
+        config.db_url = url;
+    } else {
+        throw std::runtime_error(DB_URL_ENV_NAME + " environment variable not found"s);
+    }
+
+    std::optional<std::size_t> batch_writes;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+        if (i + 1 == argc) {
+            throw std::invalid_argument("Missing value of "s + argv[i]);
+        }
+        const std::string value{argv[++i]};
+        if (arg == "--threads"sv) {
+            config.threads = std::max(1, std::stoi(value));
+        } else if (arg == "--duration"sv) {
+            config.duration = std::chrono::seconds{std::stoi(value)};
+        } else if (arg == "--warmup"sv) {
+            config.warmup = std::chrono::seconds{std::stoi(value)};
+        } else if (arg == "--window"sv) {
+            config.window = std::chrono::seconds{std::max(1, std::stoi(value))};
+        } else if (arg == "--rate"sv) {
+            config.rate = std::stod(value);
+        } else if (arg == "--zipf"sv) {
+            config.zipf_theta = std::stod(value);
+        } else if (arg == "--seed-authors"sv) {
+            config.seed_authors = std::max<std::size_t>(1, std::stoul(value));
+        } else if (arg == "--seed-books"sv) {
+            config.seed_books = std::stoul(value);
+        } else if (arg == "--mix"sv) {
+            config.mix = ParseMix(value);
+        } else if (arg == "--group-commit"sv) {
+            config.group_commit.emplace().window = std::chrono::microseconds{std::stoi(value)};
+        } else if (arg == "--group-commit-writes"sv) {
+            batch_writes = std::max<std::size_t>(1, std::stoul(value));
+        } else {
+            throw std::invalid_argument("Unknown option "s + std::string{arg});
+        }
+    }
+    if (config.group_commit && batch_writes) {
+        config.group_commit->max_writes = *batch_writes;
+    }
+    return config;
+}
+
+// Database connection and use cases of one client thread
+struct Session {
+    Session(const std::string& db_url, postgres::WriteBatcher* batcher)
+        : db{pqxx::connection{db_url}, nullptr, batcher} {
+    }
+
+    postgres::Database db;
+    app::UseCasesImpl use_cases{db.GetAuthors(), db.GetBooks()};
+};
+
+class Client {
+public:
+    Client(int index, Session& session, Catalog& catalog, Recorder& recorder, const LoadConfig& config)
+        : index_{index}
+        , use_cases_{session.use_cases}
+        , catalog_{catalog}
+        , recorder_{recorder}
+        , config_{config}
+        , engine_{std::random_device{}()}
+        , operations_{config.mix.begin(), config.mix.end()}
+        , zipf_{config.zipf_theta} {
+    }
+
+    void Run(Clock::time_point start, Clock::time_point deadline) {
+        const auto interval = config_.rate
+            ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{config_.threads / *config_.rate})
+            : Clock::duration::zero();
+        // Threads are shifted within the interval, so the total rate is even
+        auto scheduled = start + interval * index_ / config_.threads;
+
+        while (true) {
+            if (config_.rate) {
+                std::this_thread::sleep_until(scheduled);
+            } else {
+                scheduled = Clock::now();
+            }
+            if (scheduled >= deadline) {
+                break;
+            }
+
+            const auto operation = static_cast<Operation>(operations_(engine_));
+            bool failed = false;
+            measured_ = false;
+            try {
+                Execute(operation, scheduled);
+            } catch (const std::exception&) {
+                failed = true;
+            }
+            // Operations skipped because the catalog had nothing to pick are not recorded
+            if (measured_) {
+                recorder_.Record(operation, Clock::now() - last_start_, failed);
+            }
+            scheduled += interval;
+        }
+    }
+
+private:
+    void Execute(Operation operation, Clock::time_point scheduled) {
+        auto pick = [this](std::size_t n) {
+            return zipf_(engine_, n);
+        };
+
+        switch (operation) {
+            case Operation::AddAuthor: {
+                // The id of the new author is not known to the caller, so such authors
+                // exercise the write path but do not join the popularity ranking
+                const auto name = config_.run_id + "author "s + std::to_string(index_) + "-"s + std::to_string(++counter_);
+                Measure(scheduled, [&] {
+                    use_cases_.AddAuthor(name);
+                });
+                return;
+            }
+            case Operation::AddBook: {
+                const auto author = catalog_.PickAuthor(pick);
+                if (!author) {
+                    return;
+                }
+                auto title = config_.run_id + "book "s + std::to_string(index_) + "-"s + std::to_string(++counter_);
+                Measure(scheduled, [&] {
+                    use_cases_.AddBook(2000, title, *author, std::set<std::string>{"loadgen"s});
+                });
+                catalog_.AddTitle(std::move(title));
+                return;
+            }
+            case Operation::ShowBooks:
+                Measure(scheduled, [&] {
+                    use_cases_.ShowBooks();
+                });
+                return;
+            case Operation::ShowBook: {
+                auto title = catalog_.PickTitle(pick);
+                if (!title) {
+                    return;
+                }
+                Measure(scheduled, [&] {
+                    use_cases_.ShowBook(*title);
+                });
+                return;
+            }
+            case Operation::EditBook: {
+                auto title = catalog_.PickTitle(pick);
+                if (!title) {
+                    return;
+                }
+                // Like the UI, find the book by title first; only the edit itself is measured
+                auto books = use_cases_.ShowBook(*title);
+                if (books.empty()) {
+                    return;
+                }
+                auto id = std::get<3>(books.front());
+                Measure(scheduled, [&] {
+                    use_cases_.EditBook(*title, 2001, {"loadgen"s, "edited"s}, id);
+                });
+                return;
+            }
+            case Operation::DeleteBook: {
+                auto title = catalog_.TakeTitle(pick);
+                if (!title) {
+                    return;
+                }
+                auto books = use_cases_.ShowBook(*title);
+                if (books.empty()) {
+                    return;
+                }
+                auto id = std::get<3>(books.front());
+                Measure(scheduled, [&] {
+                    use_cases_.DeleteBook(id);
+                });
+                return;
+            }
+            case Operation::Count:
+                break;
+        }
+    }
+
+    template <typename Fn>
+    void Measure(Clock::time_point scheduled, Fn&& fn) {
+        // The open loop counts the time spent waiting behind earlier operations
+        last_start_ = config_.rate ? scheduled : Clock::now();
+        measured_ = true;
+        fn();
+    }
+
+    int index_;
+    app::UseCasesImpl& use_cases_;
+    Catalog& catalog_;
+    Recorder& recorder_;
+    const LoadConfig& config_;
+    std::mt19937_64 engine_;
+    std::discrete_distribution<std::size_t> operations_;
+    ZipfianGenerator zipf_;
+    std::size_t counter_ = 0;
+    Clock::time_point last_start_;
+    bool measured_ = false;
+};
+
+void Seed(app::UseCasesImpl& use_cases, Catalog& catalog, const LoadConfig& config) {
+    std::cout << "Seeding "sv << config.seed_authors << " authors and "sv << config.seed_books << " books"sv
+              << std::endl;
+    const auto prefix = config.run_id + "seed "s;
+    for (std::size_t i = 0; i < config.seed_authors; ++i) {
+        use_cases.AddAuthor(prefix + "author "s + std::to_string(i));
+    }
+    for (const auto& author : use_cases.GetAuthors()) {
+        if (author.GetName().compare(0, prefix.size(), prefix) == 0) {
+            catalog.AddAuthor(author.GetId());
+        }
+    }
+
+    std::mt19937_64 engine{42};
+    ZipfianGenerator zipf{config.zipf_theta};
+    for (std::size_t i = 0; i < config.seed_books; ++i) {
+        auto title = prefix + "book "s + std::to_string(i);
+        const auto author = catalog.PickAuthor([&](std::size_t n) {
+            return zipf(engine, n);
+        });
+        use_cases.AddBook(1900 + static_cast<int>(i % 125), title, *author, std::set<std::string>{"seed"s});
+        catalog.AddTitle(std::move(title));
+    }
+}
+
+double ToMilliseconds(util::LatencyHistogram::Duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void PrintStats(std::string_view label, const StatsSet& stats, std::chrono::duration<double> period) {
+    std::uint64_t total = 0;
+    for (const auto& op : stats) {
+        total += op.latency.GetCount();
+    }
+    std::cout << label << ": "sv << std::fixed << std::setprecision(1) << total / period.count() << " ops/s"sv
+              << std::endl;
+    for (std::size_t i = 0; i < OPERATION_COUNT; ++i) {
+        const auto& latency = stats[i].latency;
+        if (latency.GetCount() == 0) {
+            continue;
+        }
+        std::cout << "  "sv << std::left << std::setw(12) << OPERATION_NAMES[i] << std::right << std::setw(10)
+                  << latency.GetCount() << " ops"sv << std::setw(8) << stats[i].errors.load() << " errors"sv
+                  << std::setprecision(3) << "  p50 "sv << ToMilliseconds(latency.GetPercentile(50))
+                  << "  p90 "sv << ToMilliseconds(latency.GetPercentile(90)) << "  p99 "sv
+                  << ToMilliseconds(latency.GetPercentile(99)) << "  max "sv << ToMilliseconds(latency.GetMax())
+                  << " ms"sv << std::endl;
+    }
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    try {
+        const auto config = ParseCommandLine(argc, argv);
+
+        // Outlives the sessions that use it
+        std::optional<postgres::WriteBatcher> batcher;
+        if (config.group_commit) {
+            batcher.emplace(config.db_url, *config.group_commit);
+        }
+        // Connections are opened one by one: Database creates the schema when it starts
+        std::vector<std::unique_ptr<Session>> sessions;
+        for (int i = 0; i < config.threads; ++i) {
+            sessions.push_back(std::make_unique<Session>(config.db_url, batcher ? &*batcher : nullptr));
+        }
+
+        Catalog catalog;
+        {
+            // One writer would wait out the window of every batch, so the seed is not batched
+            Session seeding{config.db_url, nullptr};
+            Seed(seeding.use_cases, catalog, config);
+        }
+
+        Recorder recorder;
+        std::vector<std::unique_ptr<Client>> clients;
+        for (int i = 0; i < config.threads; ++i) {
+            clients.push_back(std::make_unique<Client>(i, *sessions[i], catalog, recorder, config));
+        }
+
+        const auto start = Clock::now();
+        const auto measure_start = start + config.warmup;
+        const auto deadline = measure_start + config.duration;
+        std::vector<std::thread> threads;
+        for (auto& client : clients) {
+            threads.emplace_back([&client, start, deadline] {
+                client->Run(start, deadline);
+            });
+        }
+
+        std::cout << (config.rate ? "Open loop at "s + std::to_string(*config.rate) + " ops/s"s : "Closed loop"s)
+                  << " with "sv << config.threads << " threads, warming up for "sv << config.warmup.count() << " s"sv;
+        if (config.group_commit) {
+            std::cout << ", group commit of up to "sv << config.group_commit->max_writes << " writes in "sv
+                      << config.group_commit->window.count() << " us"sv;
+        }
+        std::cout << std::endl;
+        std::this_thread::sleep_until(measure_start);
+        recorder.StartMeasuring();
+
+        for (auto window_start = measure_start; window_start < deadline;) {
+            const auto window_end = std::min(window_start + config.window, deadline);
+            std::this_thread::sleep_until(window_end);
+            const std::chrono::duration<double> since_start = window_end - measure_start;
+            PrintStats("[" + std::to_string(static_cast<int>(since_start.count())) + " s]",
+                       recorder.SwitchWindow(), window_end - window_start);
+            window_start = window_end;
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        PrintStats("Total"sv, recorder.GetTotal(), config.duration);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,154 @@
+// Local load test of bookypedia_server.
+// Every client keeps one keep-alive connection and sends requests back to back
+// for the given duration. For 1, 8 and 64 concurrent clients it reports
+// requests per second and p50/p99 latency.
+//
+// Usage: bookypedia_server_load_test [--host 127.0.0.1] [--port 8080] [--duration <seconds>] [--target /api/v1/books]
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = net::ip::tcp;
+using Clock = std::chrono::steady_clock;
+using namespace std::literals;
+
+namespace {
+
+struct LoadTestConfig {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    std::string target = "/api/v1/books";
+    std::chrono::seconds duration = 10s;
+};
+
+struct ClientResult {
+    std::vector<double> latencies_ms;
+    std::size_t errors = 0;
+};
+
+LoadTestConfig ParseCommandLine(int argc, const char* argv[]) {
+    LoadTestConfig config;
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i] == "--host"sv && i + 1 < argc) {
+            config.host = argv[++i];
+        } else if (argv[i] == "--port"sv && i + 1 < argc) {
+            config.port = argv[++i];
+        } else if (argv[i] == "--duration"sv && i + 1 < argc) {
+            config.duration = std::chrono::seconds{std::stoi(argv[++i])};
+        } else if (argv[i] == "--target"sv && i + 1 < argc) {
+            config.target = argv[++i];
+        } else {
+            throw std::invalid_argument(
+                "Usage: "s + argv[0] + " [--host <host>] [--port <port>] [--duration <seconds>] [--target <path>]"s);
+        }
+    }
+    return config;
+}
+
+void RunClient(const LoadTestConfig& config, Clock::time_point deadline, ClientResult& result) {
+    net::io_context ioc;
+    tcp::resolver resolver{ioc};
+    beast::tcp_stream stream{ioc};
+    stream.connect(resolver.resolve(config.host, config.port));
+
+    http::request<http::empty_body> request{http::verb::get, config.target, 11};
+    request.set(http::field::host, config.host);
+    request.keep_alive(true);
+
+    beast::flat_buffer buffer;
+    while (Clock::now() < deadline) {
+        const auto start = Clock::now();
+        http::write(stream, request);
+        http::response<http::string_body> response;
+        http::read(stream, buffer, response);
+        const std::chrono::duration<double, std::milli> latency = Clock::now() - start;
+
+        if (response.result() != http::status::ok) {
+            ++result.errors;
+        }
+        result.latencies_ms.push_back(latency.count());
+        if (!response.keep_alive()) {
+            break;
+        }
+    }
+
+    beast::error_code ec;
+    stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+}
+
+double Percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const auto index = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+void RunLevel(const LoadTestConfig& config, int clients) {
+    std::vector<ClientResult> results(clients);
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> failed_clients = 0;
+
+    const auto start = Clock::now();
+    const auto deadline = start + config.duration;
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back([&, i] {
+            try {
+                RunClient(config, deadline, results[i]);
+            } catch (const std::exception& e) {
+                ++failed_clients;
+                std::cerr << "Client " << i << ": " << e.what() << std::endl;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::vector<double> latencies;
+    std::size_t errors = 0;
+    for (auto& result : results) {
+        latencies.insert(latencies.end(), result.latencies_ms.begin(), result.latencies_ms.end());
+        errors += result.errors;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << std::setw(8) << clients
+              << std::setw(12) << latencies.size()
+              << std::setw(14) << std::fixed << std::setprecision(1) << latencies.size() / elapsed.count()
+              << std::setw(12) << std::setprecision(3) << Percentile(latencies, 0.50)
+              << std::setw(12) << Percentile(latencies, 0.99)
+              << std::setw(8) << errors + failed_clients << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    try {
+        const auto config = ParseCommandLine(argc, argv);
+        std::cout << "GET " << config.target << " for " << config.duration.count() << " s per level" << std::endl;
+        std::cout << std::setw(8) << "clients" << std::setw(12) << "requests" << std::setw(14) << "requests/s"
+                  << std::setw(12) << "p50, ms" << std::setw(12) << "p99, ms" << std::setw(8) << "errors" << std::endl;
+        for (int clients : {1, 8, 64}) {
+            RunLevel(config, clients);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,84 @@
+// Writes a memory-mapped snapshot of the catalog kept in Postgres, for read-only
+// instances started with `bookypedia --snapshot <file>`.
+//
+// Usage: bookypedia_snapshot <output file>
+// The database is taken from the BOOKYPEDIA_DB_URL environment variable.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <pqxx/pqxx>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/storage/snapshot.h"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr const char DB_URL_ENV_NAME[]{"BOOKYPEDIA_DB_URL"};
+
+struct Catalog {
+    std::vector<domain::Author> authors;
+    std::vector<domain::Book> books;
+};
+
+// Reads the whole catalog in one transaction. Under REPEATABLE READ its statements share one
+// snapshot of the database, so the authors, tags and books are consistent with each other.
+Catalog LoadCatalog(const std::string& db_url) {
+    pqxx::connection connection{db_url};
+    pqxx::transaction<pqxx::isolation_level::repeatable_read, pqxx::write_policy::read_only> read{connection};
+    Catalog catalog;
+
+    for (auto [id, name] : read.query<std::string, std::string>("SELECT id, name FROM authors"sv)) {
+        catalog.authors.emplace_back(domain::AuthorId::FromString(id), std::move(name));
+    }
+
+    std::unordered_map<std::string, std::set<std::string>> tags;
+    for (auto [book_id, tag] : read.query<std::string, std::string>("SELECT book_id, tag FROM book_tags"sv)) {
+        tags[book_id].insert(std::move(tag));
+    }
+
+    for (auto [id, author_id, title, year] :
+         read.query<std::string, std::string, std::string, int>("SELECT id, author_id, title, publication_year FROM books"sv)) {
+        auto book_tags = tags.extract(id);
+        catalog.books.emplace_back(domain::BookId::FromString(id), domain::AuthorId::FromString(author_id),
+                                   std::move(title), year,
+                                   book_tags ? std::move(book_tags.mapped()) : std::set<std::string>{});
+    }
+    return catalog;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    try {
+        if (argc != 2) {
+            throw std::invalid_argument("Usage: "s + argv[0] + " <output file>"s);
+        }
+        const auto* db_url = std::getenv(DB_URL_ENV_NAME);
+        if (!db_url) {
+            throw std::runtime_error(DB_URL_ENV_NAME + " environment variable not found"s);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        auto catalog = LoadCatalog(db_url);
+        const auto author_count = catalog.authors.size();
+        const auto book_count = catalog.books.size();
+        const auto loaded = std::chrono::steady_clock::now();
+        storage::WriteSnapshot(argv[1], std::move(catalog.authors), std::move(catalog.books));
+        const auto written = std::chrono::steady_clock::now();
+
+        const storage::Snapshot snapshot{argv[1]};
+        std::cout << "Wrote " << snapshot.GetAuthorCount() << " of " << author_count << " authors and "
+                  << snapshot.GetBookCount() << " of " << book_count << " books to " << argv[1] << " (loaded in "
+                  << (loaded - start) / 1ms << " ms, written in " << (written - loaded) / 1ms << " ms)" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}